@@ -0,0 +1,108 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// Measures how many addresses per second addrdec_tlx decodes, e.g.
+//
+//   addrdec_bench -gpgpu_n_mem 32 -gpgpu_n_sub_partition_per_mchannel 2 \
+//       -gpgpu_mem_addr_mapping dramid@8;00000000.00000000.00000000.00000000.0000RRRR.RRRRRRRR.RBBBCCCC.BCCSSSSS
+//
+// Any of the address mapping options of the simulator can be given.
+
+#include <stdio.h>
+#include <sys/time.h>
+#include <vector>
+
+#include "gpgpu-sim/addrdec.h"
+#include "option_parser.h"
+
+static double wall_time() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static unsigned g_n_mem;
+static unsigned g_n_sub_partition;
+static unsigned g_n_addresses;
+
+// decodes the addresses a few times over and returns addresses per second
+static double run(const linear_to_raw_address_translation &dec,
+                  const std::vector<new_addr_type> &addrs, unsigned *check) {
+  const unsigned rounds = 8;
+  unsigned sum = 0;
+  double start = wall_time();
+  for (unsigned r = 0; r < rounds; r++) {
+    for (size_t i = 0; i < addrs.size(); i++) {
+      addrdec_t tlx;
+      dec.addrdec_tlx(addrs[i], &tlx);
+      sum += tlx.chip + tlx.bk + tlx.row + tlx.col + tlx.sub_partition;
+    }
+  }
+  double elapsed = wall_time() - start;
+  *check = sum;
+  return rounds * addrs.size() / elapsed;
+}
+
+int main(int argc, const char *argv[]) {
+  option_parser_t opp = option_parser_create();
+  linear_to_raw_address_translation dec;
+  dec.addrdec_setoption(opp);
+  option_parser_register(opp, "-gpgpu_n_mem", OPT_UINT32, &g_n_mem,
+                         "number of memory channels", "32");
+  option_parser_register(opp, "-gpgpu_n_sub_partition_per_mchannel",
+                         OPT_UINT32, &g_n_sub_partition,
+                         "sub partitions per channel", "2");
+  option_parser_register(opp, "-bench_addresses", OPT_UINT32, &g_n_addresses,
+                         "addresses decoded per round", "4194304");
+  option_parser_cmdline(opp, argc, argv);
+  dec.init(g_n_mem, g_n_sub_partition);
+
+  std::vector<new_addr_type> seq(g_n_addresses), rnd(g_n_addresses);
+  unsigned long long x = 88172645463325252ULL;
+  for (unsigned i = 0; i < g_n_addresses; i++) {
+    seq[i] = (new_addr_type)i * 32;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    rnd[i] = x & 0xffffffffe0ULL;  // 40-bit, sector aligned
+  }
+
+#ifdef __BMI2__
+  const char *variant = "pext";
+#else
+  const char *variant = "run table";
+#endif
+  unsigned check_seq, check_rnd;
+  double seq_rate = run(dec, seq, &check_seq);
+  double rnd_rate = run(dec, rnd, &check_rnd);
+  printf("addrdec_tlx (%s): sequential %.1f M addr/s, random %.1f M addr/s "
+         "(check %08x %08x)\n",
+         variant, seq_rate / 1e6, rnd_rate / 1e6, check_seq, check_rnd);
+  return 0;
+}
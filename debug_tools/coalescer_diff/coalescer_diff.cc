@@ -0,0 +1,305 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Runs warp_inst_t::memory_coalescing_arch from the source tree and a copy
+// of the std::map based coalescer it replaced on the same randomized warps,
+// and checks that both produce identical access lists. The make rule pulls
+// the current coalescer out of abstract_hardware_model.cc, so the check
+// always runs against the code in the tree.
+//
+// usage: coalescer_diff [warps] [seed]
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <vector>
+
+// just enough of abstract_hardware_model.h for the coalescer
+typedef unsigned long long new_addr_type;
+typedef unsigned address_type;
+const unsigned MAX_WARP_SIZE = 32;
+typedef std::bitset<MAX_WARP_SIZE> active_mask_t;
+const unsigned MAX_MEMORY_ACCESS_SIZE = 128;
+typedef std::bitset<MAX_MEMORY_ACCESS_SIZE> mem_access_byte_mask_t;
+typedef std::bitset<4> mem_access_sector_mask_t;
+const unsigned MAX_ACCESSES_PER_INSN_PER_THREAD = 8;
+enum mem_access_type { GLOBAL_ACC_R, GLOBAL_ACC_W };
+enum _memory_space_t { global_space, local_space, param_space_local };
+enum cache_operator_type { CACHE_ALL, CACHE_GLOBAL };
+
+static address_type line_size_based_tag_func(new_addr_type address,
+                                             new_addr_type line_size) {
+  return address & ~(line_size - 1);
+}
+
+struct mem_access_t {
+  mem_access_t(unsigned kernel_id, mem_access_type type, new_addr_type address,
+               unsigned size, bool wr, const active_mask_t &active_mask,
+               const mem_access_byte_mask_t &byte_mask,
+               const mem_access_sector_mask_t &sector_mask, void *ctx)
+      : addr(address),
+        req_size(size),
+        write(wr),
+        active(active_mask),
+        bytes(byte_mask),
+        sectors(sector_mask) {}
+  bool operator==(const mem_access_t &o) const {
+    return addr == o.addr && req_size == o.req_size && write == o.write &&
+           active == o.active && bytes == o.bytes && sectors == o.sectors;
+  }
+  new_addr_type addr;
+  unsigned req_size;
+  bool write;
+  active_mask_t active;
+  mem_access_byte_mask_t bytes;
+  mem_access_sector_mask_t sectors;
+};
+
+struct core_config {
+  unsigned warp_size;
+  unsigned mem_warp_parts;
+  unsigned gpgpu_coalesce_arch;
+  bool gmem_skip_L1D;
+  void *gpgpu_ctx;
+};
+
+struct memory_space_t {
+  _memory_space_t m_type;
+  _memory_space_t get_type() const { return m_type; }
+};
+
+// the warp_inst_t members the coalescer reads and writes
+class coalescer_warp {
+ public:
+  void memory_coalescing_arch(bool is_write, mem_access_type access_type);
+  void reference_coalescing_arch(bool is_write, mem_access_type access_type);
+
+  struct transaction_info {
+    std::bitset<4> chunks;  // bitmask: 32-byte chunks accessed
+    mem_access_byte_mask_t bytes;
+    active_mask_t active;  // threads in this transaction
+  };
+  struct per_thread_info {
+    new_addr_type memreqaddr[MAX_ACCESSES_PER_INSN_PER_THREAD];
+  };
+
+  void memory_coalescing_arch_reduce_and_send(bool is_write,
+                                              mem_access_type access_type,
+                                              const transaction_info &info,
+                                              new_addr_type addr,
+                                              unsigned segment_size);
+  bool active(unsigned thread) const { return m_warp_active_mask.test(thread); }
+
+  const core_config *m_config;
+  unsigned m_kernel_id;
+  unsigned data_size;
+  memory_space_t space;
+  cache_operator_type cache_op;
+  active_mask_t m_warp_active_mask;
+  std::vector<per_thread_info> m_per_scalar_thread;
+  std::vector<mem_access_t> m_accessq;
+};
+
+#include "coalescer_current.inc"
+
+// The coalescer before it was rewritten around sorted 64-bit keys, unchanged
+// apart from its name.
+void coalescer_warp::reference_coalescing_arch(bool is_write,
+                                               mem_access_type access_type) {
+  // see the CUDA manual where it discusses coalescing rules before reading this
+  unsigned segment_size = 0;
+  unsigned warp_parts = m_config->mem_warp_parts;
+  bool sector_segment_size = false;
+
+  if (m_config->gpgpu_coalesce_arch >= 20 &&
+      m_config->gpgpu_coalesce_arch < 39) {
+    // Fermi and Kepler, L1 is normal and L2 is sector
+    if (m_config->gmem_skip_L1D || cache_op == CACHE_GLOBAL)
+      sector_segment_size = true;
+    else
+      sector_segment_size = false;
+  } else if (m_config->gpgpu_coalesce_arch >= 40) {
+    // Maxwell, Pascal and Volta, L1 and L2 are sectors
+    // all requests should be 32 bytes
+    sector_segment_size = true;
+  }
+
+  switch (data_size) {
+    case 1:
+      segment_size = 32;
+      break;
+    case 2:
+      segment_size = sector_segment_size ? 32 : 64;
+      break;
+    case 4:
+    case 8:
+    case 16:
+      segment_size = sector_segment_size ? 32 : 128;
+      break;
+  }
+  unsigned subwarp_size = m_config->warp_size / warp_parts;
+
+  for (unsigned subwarp = 0; subwarp < warp_parts; subwarp++) {
+    std::map<new_addr_type, transaction_info> subwarp_transactions;
+
+    // step 1: find all transactions generated by this subwarp
+    for (unsigned thread = subwarp * subwarp_size;
+         thread < subwarp_size * (subwarp + 1); thread++) {
+      if (!active(thread)) continue;
+
+      unsigned data_size_coales = data_size;
+      unsigned num_accesses = 1;
+
+      if (space.get_type() == local_space ||
+          space.get_type() == param_space_local) {
+        // Local memory accesses >4B were split into 4B chunks
+        if (data_size >= 4) {
+          data_size_coales = 4;
+          num_accesses = data_size / 4;
+        }
+        // Otherwise keep the same data_size for sub-4B access to local memory
+      }
+
+      assert(num_accesses <= MAX_ACCESSES_PER_INSN_PER_THREAD);
+
+      //            for(unsigned access=0; access<num_accesses; access++) {
+      for (unsigned access = 0;
+           (access < MAX_ACCESSES_PER_INSN_PER_THREAD) &&
+           (m_per_scalar_thread[thread].memreqaddr[access] != 0);
+           access++) {
+        new_addr_type addr = m_per_scalar_thread[thread].memreqaddr[access];
+        unsigned block_address = line_size_based_tag_func(addr, segment_size);
+        unsigned chunk =
+            (addr & 127) / 32;  // which 32-byte chunk within in a 128-byte
+                                // chunk does this thread access?
+        transaction_info &info = subwarp_transactions[block_address];
+
+        // can only write to one segment
+        assert(block_address == line_size_based_tag_func(
+                                    addr + data_size_coales - 1, segment_size));
+
+        info.chunks.set(chunk);
+        info.active.set(thread);
+        unsigned idx = (addr & 127);
+        for (unsigned i = 0; i < data_size_coales; i++) info.bytes.set(idx + i);
+      }
+    }
+
+    // step 2: reduce each transaction size, if possible
+    std::map<new_addr_type, transaction_info>::iterator t;
+    for (t = subwarp_transactions.begin(); t != subwarp_transactions.end();
+         t++) {
+      new_addr_type addr = t->first;
+      const transaction_info &info = t->second;
+
+      memory_coalescing_arch_reduce_and_send(is_write, access_type, info, addr,
+                                             segment_size);
+    }
+  }
+}
+
+static unsigned long long g_rand_state;
+static unsigned long long rnd() {
+  g_rand_state ^= g_rand_state << 13;
+  g_rand_state ^= g_rand_state >> 7;
+  g_rand_state ^= g_rand_state << 17;
+  return g_rand_state;
+}
+
+// a random warp: data size, space, segment rules, warp parts, active mask
+// and one of strided, clustered, scattered or broadcast-like addresses
+static void random_warp(coalescer_warp &w, core_config &config) {
+  static const unsigned sizes[] = {1, 2, 4, 8, 16};
+  config.gpgpu_coalesce_arch = (rnd() & 1) ? 70 : 30;
+  config.mem_warp_parts = (rnd() % 3 == 0) ? 2 : 1;
+  w.m_config = &config;
+  w.m_kernel_id = 0;
+  w.data_size = sizes[rnd() % 5];
+  w.space.m_type = (_memory_space_t)(rnd() % 3);
+  w.cache_op = (rnd() & 1) ? CACHE_GLOBAL : CACHE_ALL;
+  w.m_warp_active_mask =
+      active_mask_t(rnd() % 4 == 0 ? 0xffffffffULL : rnd());
+  w.m_per_scalar_thread.assign(config.warp_size,
+                               coalescer_warp::per_thread_info());
+  w.m_accessq.clear();
+
+  unsigned pattern = rnd() % 4;
+  new_addr_type base = (rnd() & 0xffffffffffULL) & ~127ULL;
+  if (rnd() & 1) base &= 0xffffffffULL;
+  unsigned stride = w.data_size << (rnd() % 4);
+  // local accesses of 4B and more are split into 4B pieces
+  bool split = w.space.m_type != global_space && w.data_size >= 4;
+  unsigned piece = split ? 4 : w.data_size;
+  unsigned n_pieces = split ? w.data_size / 4 : 1;
+  for (unsigned t = 0; t < config.warp_size; t++) {
+    for (unsigned a = 0; a < MAX_ACCESSES_PER_INSN_PER_THREAD; a++)
+      w.m_per_scalar_thread[t].memreqaddr[a] = 0;
+    new_addr_type addr;
+    if (pattern == 0)
+      addr = base + t * stride;
+    else if (pattern == 1)
+      addr = base + (rnd() % 64) * w.data_size;
+    else if (pattern == 2)
+      addr = rnd() & 0xffffffffffULL;
+    else
+      addr = base + (t % 4) * w.data_size;
+    addr &= ~(new_addr_type)(w.data_size - 1);
+    if (!addr) addr = w.data_size;
+    for (unsigned a = 0; a < n_pieces; a++)
+      w.m_per_scalar_thread[t].memreqaddr[a] = addr + a * piece;
+  }
+}
+
+int main(int argc, char **argv) {
+  unsigned n_warps = (argc > 1) ? atoi(argv[1]) : 400000;
+  g_rand_state = (argc > 2) ? atoll(argv[2]) : 88172645463325252ULL;
+
+  core_config config = {32, 1, 70, false, NULL};
+  unsigned long long n_accesses = 0;
+  for (unsigned i = 0; i < n_warps; i++) {
+    coalescer_warp current;
+    random_warp(current, config);
+    coalescer_warp reference = current;
+    bool is_write = rnd() & 1;
+    mem_access_type type = is_write ? GLOBAL_ACC_W : GLOBAL_ACC_R;
+    reference.reference_coalescing_arch(is_write, type);
+    current.memory_coalescing_arch(is_write, type);
+    if (!(reference.m_accessq == current.m_accessq)) {
+      printf("coalescer_diff: MISMATCH in warp %u: %zu vs %zu accesses\n", i,
+             reference.m_accessq.size(), current.m_accessq.size());
+      return 1;
+    }
+    n_accesses += reference.m_accessq.size();
+  }
+  printf("coalescer_diff: %u warps, %llu accesses, identical\n", n_warps,
+         n_accesses);
+  return 0;
+}
@@ -0,0 +1,248 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// Drives dram_req_queue and a copy of the std::list/std::map request bins
+// that frfcfs_scheduler used before it with the same random stream of
+// insertions and FR-FCFS picks, and checks that every pick is identical.
+// Both are then timed on the same stream, e.g.
+//
+//   frfcfs_diff -frfcfs_banks 16 -frfcfs_rows 8 -frfcfs_ops 20000000
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <list>
+#include <map>
+#include <vector>
+
+#include "gpgpu-sim/dram.h"
+#include "gpgpu-sim/dram_req_queue.h"
+#include "option_parser.h"
+
+static double wall_time() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// The request bins of the previous frfcfs_scheduler, unchanged apart from
+// being pulled out into a class.
+class reference_queue {
+ public:
+  explicit reference_queue(unsigned n_bank) {
+    m_queue = new std::list<dram_req_t *>[n_bank];
+    m_bins = new std::map<
+        unsigned, std::list<std::list<dram_req_t *>::iterator> >[n_bank];
+    m_last_row = new std::list<std::list<dram_req_t *>::iterator> *[n_bank];
+    for (unsigned i = 0; i < n_bank; i++) m_last_row[i] = NULL;
+  }
+
+  void push(dram_req_t *req) {
+    m_queue[req->bk].push_front(req);
+    std::list<dram_req_t *>::iterator ptr = m_queue[req->bk].begin();
+    m_bins[req->bk][req->row].push_front(ptr);  // newest reqs to the front
+  }
+
+  dram_req_t *schedule(unsigned bank, unsigned curr_row, bool &rowhit) {
+    rowhit = true;
+    if (m_last_row[bank] == NULL) {
+      if (m_queue[bank].empty()) return NULL;
+
+      std::map<unsigned,
+               std::list<std::list<dram_req_t *>::iterator> >::iterator
+          bin_ptr = m_bins[bank].find(curr_row);
+      if (bin_ptr == m_bins[bank].end()) {
+        dram_req_t *req = m_queue[bank].back();
+        bin_ptr = m_bins[bank].find(req->row);
+        assert(bin_ptr != m_bins[bank].end());
+        m_last_row[bank] = &(bin_ptr->second);
+        rowhit = false;
+      } else {
+        m_last_row[bank] = &(bin_ptr->second);
+      }
+    }
+    std::list<dram_req_t *>::iterator next = m_last_row[bank]->back();
+    dram_req_t *req = (*next);
+    m_last_row[bank]->pop_back();
+    m_queue[bank].erase(next);
+    if (m_last_row[bank]->empty()) {
+      m_bins[bank].erase(req->row);
+      m_last_row[bank] = NULL;
+    }
+    return req;
+  }
+
+ private:
+  std::list<dram_req_t *> *m_queue;
+  std::map<unsigned, std::list<std::list<dram_req_t *>::iterator> > *m_bins;
+  std::list<std::list<dram_req_t *>::iterator> **m_last_row;
+};
+
+static unsigned g_n_bank;
+static unsigned g_n_row;
+static unsigned g_n_ops;
+static unsigned g_queue_size;
+static unsigned g_seed;
+
+struct op {
+  bool push;
+  unsigned bank;
+  unsigned row;
+};
+
+// Insertions and picks in the ratio a busy controller sees: the queue
+// fills up to g_queue_size and the bank's open row usually follows the
+// last pick, with the odd precharge to a random row.
+static void make_ops(std::vector<op> &ops) {
+  srand(g_seed);
+  std::vector<unsigned> open_row(g_n_bank, 0);
+  unsigned pending = 0;
+  for (unsigned i = 0; i < g_n_ops; i++) {
+    op o;
+    o.bank = rand() % g_n_bank;
+    o.push = pending < g_queue_size && (pending == 0 || rand() % 2);
+    if (o.push) {
+      o.row = rand() % g_n_row;
+      pending++;
+    } else {
+      if (rand() % 8 == 0) open_row[o.bank] = rand() % g_n_row;
+      o.row = open_row[o.bank];
+    }
+    ops.push_back(o);
+    if (!o.push) pending = pending ? pending - 1 : 0;
+  }
+}
+
+static dram_req_t *new_req(std::vector<dram_req_t *> &pool, unsigned &next,
+                           unsigned bank, unsigned row) {
+  if (next == pool.size()) {
+    // only bk and row are looked at
+    pool.push_back((dram_req_t *)calloc(1, sizeof(dram_req_t)));
+  }
+  dram_req_t *req = pool[next++];
+  req->bk = bank;
+  req->row = row;
+  return req;
+}
+
+template <class Q>
+static double run(Q &q, const std::vector<op> &ops, unsigned long long &sum) {
+  std::vector<dram_req_t *> pool;
+  std::vector<dram_req_t *> free_reqs;
+  unsigned next = 0;
+  double start = wall_time();
+  for (unsigned i = 0; i < ops.size(); i++) {
+    const op &o = ops[i];
+    if (o.push) {
+      dram_req_t *req;
+      if (free_reqs.empty()) {
+        req = new_req(pool, next, o.bank, o.row);
+      } else {
+        req = free_reqs.back();
+        free_reqs.pop_back();
+        req->bk = o.bank;
+        req->row = o.row;
+      }
+      q.push(req);
+    } else {
+      bool hit;
+      dram_req_t *req = q.schedule(o.bank, o.row, hit);
+      if (req) {
+        sum += req->row + hit;
+        free_reqs.push_back(req);
+      }
+    }
+  }
+  return ops.size() / (wall_time() - start);
+}
+
+int main(int argc, const char **argv) {
+  option_parser_t opp = option_parser_create();
+  option_parser_register(opp, "-frfcfs_banks", OPT_UINT32, &g_n_bank,
+                         "number of banks", "16");
+  option_parser_register(opp, "-frfcfs_rows", OPT_UINT32, &g_n_row,
+                         "distinct rows per bank in the stream", "8");
+  option_parser_register(opp, "-frfcfs_ops", OPT_UINT32, &g_n_ops,
+                         "number of insertions and picks", "10000000");
+  option_parser_register(opp, "-frfcfs_queue_size", OPT_UINT32,
+                         &g_queue_size, "max pending requests", "64");
+  option_parser_register(opp, "-frfcfs_seed", OPT_UINT32, &g_seed,
+                         "random seed", "1");
+  option_parser_cmdline(opp, argc, argv);
+  option_parser_print(opp, stdout);
+
+  std::vector<op> ops;
+  make_ops(ops);
+
+  // differential check, one request object shared by both queues; the
+  // unbounded dram_req_queue also exercises node pool growth
+  reference_queue ref(g_n_bank);
+  dram_req_queue fast(g_n_bank);
+  std::vector<dram_req_t *> pool;
+  unsigned next = 0;
+  unsigned long long picks = 0, hits = 0;
+  for (unsigned i = 0; i < ops.size(); i++) {
+    const op &o = ops[i];
+    if (o.push) {
+      dram_req_t *req = new_req(pool, next, o.bank, o.row);
+      ref.push(req);
+      fast.push(req);
+      continue;
+    }
+    bool ref_hit, fast_hit;
+    dram_req_t *a = ref.schedule(o.bank, o.row, ref_hit);
+    dram_req_t *b = fast.schedule(o.bank, o.row, fast_hit);
+    if (a != b || (a && ref_hit != fast_hit)) {
+      printf("MISMATCH at op %u: bank %u row %u: reference %p (hit %d), "
+             "dram_req_queue %p (hit %d)\n",
+             i, o.bank, o.row, a, ref_hit, b, fast_hit);
+      return 1;
+    }
+    if (a) {
+      picks++;
+      hits += ref_hit;
+    }
+  }
+  printf("%llu picks identical (%.1f%% row hits)\n", picks,
+         100.0 * hits / (picks ? picks : 1));
+
+  unsigned long long ref_sum = 0, fast_sum = 0;
+  reference_queue ref2(g_n_bank);
+  dram_req_queue fast2(g_n_bank, g_queue_size);
+  double ref_rate = run(ref2, ops, ref_sum);
+  double fast_rate = run(fast2, ops, fast_sum);
+  assert(ref_sum == fast_sum);
+  printf("std::list/std::map: %.1f Mops/s\n", ref_rate / 1e6);
+  printf("dram_req_queue:     %.1f Mops/s (%.2fx)\n", fast_rate / 1e6,
+         fast_rate / ref_rate);
+
+  option_parser_destroy(opp);
+  return 0;
+}
@@ -0,0 +1,222 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// Replays interconnect traffic recorded with -icnt_trace_record against any
+// interconnect configuration, e.g.
+//
+//   icnt_replay app.icnt_trace -network_mode 1 \
+//       -inter_config_file config_volta_islip.icnt
+//
+// The replay is open loop: every packet becomes ready at the cycle it was
+// pushed in the recorded run and is injected as soon as its source has
+// buffer space, in the recorded order per source. Packets are popped as
+// soon as they arrive. Reports latency distributions, throughput and how
+// fast the interconnect model runs on the host.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include "gpgpu-sim/icnt_trace.h"
+#include "gpgpu-sim/icnt_wrapper.h"
+#include "option_parser.h"
+
+struct replay_packet {
+  icnt_trace_record rec;
+  unsigned long long inject_cycle;
+};
+
+static unsigned replay_kernel_id(void *data) {
+  return static_cast<replay_packet *>(data)->rec.kernel_id;
+}
+
+static unsigned replay_type(void *data) {
+  return static_cast<replay_packet *>(data)->rec.type;
+}
+
+static double wall_time() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+class latency_stats {
+ public:
+  void add(unsigned long long latency) { m_samples.push_back(latency); }
+
+  void print(const char *name) {
+    if (m_samples.empty()) {
+      printf("%-22s no packets\n", name);
+      return;
+    }
+    std::sort(m_samples.begin(), m_samples.end());
+    double sum = 0;
+    for (size_t i = 0; i < m_samples.size(); ++i) sum += m_samples[i];
+    printf("%-22s avg %8.2f  p50 %6llu  p90 %6llu  p99 %6llu  max %6llu\n",
+           name, sum / m_samples.size(), percentile(50), percentile(90),
+           percentile(99), m_samples.back());
+  }
+
+ private:
+  unsigned long long percentile(unsigned p) const {
+    return m_samples[(m_samples.size() - 1) * p / 100];
+  }
+
+  std::vector<unsigned long long> m_samples;
+};
+
+// requests travel from shader cores to memory, replies the other way
+struct traffic_stats {
+  latency_stats total;     // recorded push to pop
+  latency_stats network;   // injection to pop
+  latency_stats recorded;  // same packets in the recorded run
+  unsigned long long packets;
+  unsigned long long bytes;
+  traffic_stats() : packets(0), bytes(0) {}
+};
+
+static unsigned g_drain_limit;
+
+int main(int argc, const char *argv[]) {
+  if (argc < 2) {
+    printf("usage: %s <trace> [interconnect options]\n", argv[0]);
+    return 1;
+  }
+  option_parser_t opp = option_parser_create();
+  icnt_reg_options(opp);
+  option_parser_register(opp, "-replay_drain_limit", OPT_UINT32,
+                         &g_drain_limit,
+                         "cycles to wait for the network to drain after the "
+                         "last recorded packet",
+                         "1000000");
+  // the trace name takes the place of the program name
+  option_parser_cmdline(opp, argc - 1, argv + 1);
+  option_parser_print(opp, stdout);
+
+  icnt_trace_reader trace(argv[1]);
+  unsigned n_shader = trace.header().n_shader;
+  unsigned n_mem = trace.header().n_mem;
+  unsigned n_nodes = n_shader + n_mem;
+
+  // the whole trace is loaded up front so reading it is not timed
+  std::vector<replay_packet> packets;
+  std::vector<long long> recorded_pop;
+  icnt_trace_record r;
+  while (trace.next(r)) {
+    if (r.event == ICNT_TRACE_PUSH) {
+      assert(r.id == packets.size());
+      replay_packet p;
+      p.rec = r;
+      p.inject_cycle = 0;
+      packets.push_back(p);
+    } else {
+      if (r.id >= recorded_pop.size()) recorded_pop.resize(r.id + 1, -1);
+      recorded_pop[r.id] = r.cycle;
+    }
+  }
+  recorded_pop.resize(packets.size(), -1);
+  unsigned long long recorded_cycles =
+      packets.empty() ? 0 : packets.back().rec.cycle + 1;
+  printf("icnt_replay: %zu packets over %llu cycles, %u shaders, %u memories\n",
+         packets.size(), recorded_cycles, n_shader, n_mem);
+
+  icnt_set_packet_accessors(replay_kernel_id, replay_type);
+  icnt_wrapper_init();
+  icnt_create(n_shader, n_mem);
+  icnt_init();
+
+  std::vector<std::deque<replay_packet *> > ready(n_nodes);
+  traffic_stats stats[2];
+  size_t next = 0;
+  size_t in_flight = 0;
+  unsigned long long delivered = 0;
+  unsigned long long cycle = 0;
+  unsigned long long drain_end = recorded_cycles + g_drain_limit;
+  double start = wall_time();
+
+  while (delivered < packets.size() && cycle < drain_end) {
+    for (; next < packets.size() && packets[next].rec.cycle <= cycle; ++next)
+      ready[packets[next].rec.src].push_back(&packets[next]);
+    for (unsigned n = 0; n < n_nodes; ++n) {
+      while (!ready[n].empty()) {
+        replay_packet *p = ready[n].front();
+        if (!icnt_has_buffer(n, p->rec.size, p->rec.kernel_id)) break;
+        icnt_push(n, p->rec.dst, p, p->rec.size);
+        p->inject_cycle = cycle;
+        ready[n].pop_front();
+        ++in_flight;
+      }
+    }
+
+    icnt_transfer();
+    ++cycle;
+
+    for (unsigned n = 0; n < n_nodes; ++n) {
+      replay_packet *p = static_cast<replay_packet *>(icnt_pop(n));
+      if (!p) continue;
+      traffic_stats &s = stats[p->rec.src < n_shader ? 0 : 1];
+      s.total.add(cycle - p->rec.cycle);
+      s.network.add(cycle - p->inject_cycle);
+      if (recorded_pop[p->rec.id] >= 0)
+        s.recorded.add(recorded_pop[p->rec.id] - p->rec.cycle);
+      s.packets++;
+      s.bytes += p->rec.size;
+      ++delivered;
+      --in_flight;
+    }
+  }
+  double elapsed = wall_time() - start;
+
+  icnt_display_stats();
+  printf("\nicnt_replay: delivered %llu of %zu packets in %llu cycles",
+         delivered, packets.size(), cycle);
+  if (delivered < packets.size())
+    printf(" (%zu still in the network, %zu not injected)", in_flight,
+           (size_t)(packets.size() - delivered - in_flight));
+  printf("\n");
+  const char *names[2] = {"requests", "replies"};
+  for (unsigned i = 0; i < 2; ++i) {
+    traffic_stats &s = stats[i];
+    printf("\n%s: %llu packets, %llu bytes, %.3f packets/cycle, "
+           "%.2f bytes/cycle\n",
+           names[i], s.packets, s.bytes, cycle ? (double)s.packets / cycle : 0,
+           cycle ? (double)s.bytes / cycle : 0);
+    s.total.print("  latency (ready)");
+    s.network.print("  latency (injected)");
+    s.recorded.print("  recorded latency");
+  }
+  printf("\nhost: %.3f s, %.0f cycles/s, %.0f packets/s\n", elapsed,
+         elapsed > 0 ? cycle / elapsed : 0,
+         elapsed > 0 ? delivered / elapsed : 0);
+  return delivered == packets.size() ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Standalone front end for instruction traces: replays a run captured with
+// -gpgpu_inst_trace_mode 1 without the application binary or the CUDA
+// runtime. It reads <prefix>_launches.txt, loads the PTX modules copied
+// there in capture order (so every instruction gets the pc it had in the
+// capture), and launches each kernel with the grid, block and ptxas resource
+// usage recorded in its trace file, one kernel after the other.
+//
+// Run it in a directory whose gpgpusim.config has -gpgpu_inst_trace_mode 2
+// and the -gpgpu_inst_trace_prefix of the capture; statistics are printed
+// per kernel exactly as for an application run.
+//
+// Kernels are replayed in launch order without overlap, so concurrent
+// kernels on different streams are serialized, and device-side (CDP)
+// launches are not supported. Host work between kernels is not simulated.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fstream>
+#include <string>
+
+#include "../../libcuda/gpgpu_context.h"
+#include "abstract_hardware_model.h"
+#include "cuda-sim/ptx_ir.h"
+#include "gpgpu-sim/gpu-sim.h"
+#include "gpgpu-sim/inst_trace.h"
+#include "stream_manager.h"
+
+static void launch_kernel(gpgpu_context *ctx, gpgpu_sim *gpu, unsigned uid,
+                          const std::string &name) {
+  const gpgpu_sim_config &config = gpu->get_config();
+  inst_trace_launch_t launch;
+  kernel_inst_trace::read_launch(config.get_inst_trace_prefix(), uid,
+                                 gpu->wrp_size(), launch);
+  if (launch.name != name) {
+    printf("inst_trace_replay: trace of kernel %u is %s, index says %s\n",
+           uid, launch.name.c_str(), name.c_str());
+    exit(1);
+  }
+
+  symbol_table *symtab = ctx->g_global_allfiles_symbol_table;
+  if (symtab == NULL || symtab->lookup(name.c_str()) == NULL) {
+    printf("inst_trace_replay: no PTX loaded for kernel %s\n", name.c_str());
+    exit(1);
+  }
+  function_info *entry = symtab->lookup_function(name);
+  if (entry->get_start_PC() != launch.start_pc) {
+    printf(
+        "inst_trace_replay: %s starts at pc %u, captured at %u; the PTX was "
+        "not loaded as in the capture\n",
+        name.c_str(), (unsigned)entry->get_start_PC(), launch.start_pc);
+    exit(1);
+  }
+  entry->set_kernel_info(launch.info);
+  if (!entry->is_pdom_set()) {
+    printf("GPGPU-Sim PTX: finding reconvergence points for \'%s\'...\n",
+           name.c_str());
+    entry->do_pdom();
+    entry->set_pdom();
+  }
+
+  kernel_info_t *grid = new kernel_info_t(launch.grid, launch.block, entry);
+  if (grid->get_uid() != uid) {
+    printf("inst_trace_replay: kernel %s got uid %u, captured as %u\n",
+           name.c_str(), grid->get_uid(), uid);
+    exit(1);
+  }
+  printf(
+      "inst_trace_replay: launching kernel %u \'%s\' gridDim= (%u,%u,%u) "
+      "blockDim = (%u,%u,%u)\n",
+      uid, name.c_str(), launch.grid.x, launch.grid.y, launch.grid.z,
+      launch.block.x, launch.block.y, launch.block.z);
+  stream_operation op(grid, false, NULL);
+  ctx->the_gpgpusim->g_stream_manager->push(op);
+  ctx->synchronize();
+}
+
+int main(int argc, char **argv) {
+  if (argc != 1) {
+    printf(
+        "usage: inst_trace_replay\n"
+        "  replays the instruction traces named by -gpgpu_inst_trace_prefix "
+        "in ./gpgpusim.config\n");
+    return 1;
+  }
+
+  gpgpu_context *ctx = GPGPU_Context();
+  gpgpu_sim *gpu = ctx->GPGPUSim_Init()->get_gpgpu();
+  const gpgpu_sim_config &config = gpu->get_config();
+  if (config.get_inst_trace_mode() != INST_TRACE_REPLAY) {
+    printf("inst_trace_replay: set -gpgpu_inst_trace_mode 2 in "
+           "gpgpusim.config\n");
+    return 1;
+  }
+
+  std::string index_name =
+      std::string(config.get_inst_trace_prefix()) + "_launches.txt";
+  std::ifstream index(index_name.c_str());
+  if (!index) {
+    printf("inst_trace_replay: cannot open %s\n", index_name.c_str());
+    return 1;
+  }
+  std::string what;
+  unsigned n_kernels = 0;
+  while (index >> what) {
+    if (what == "ptx") {
+      std::string filename;
+      index >> filename;
+      ctx->gpgpu_ptx_sim_load_ptx_from_filename(filename.c_str());
+    } else if (what == "kernel") {
+      unsigned uid;
+      std::string name;
+      index >> uid >> name;
+      launch_kernel(ctx, gpu, uid, name);
+      n_kernels++;
+    } else {
+      printf("inst_trace_replay: unknown entry \"%s\" in %s\n", what.c_str(),
+             index_name.c_str());
+      return 1;
+    }
+  }
+
+  printf("inst_trace_replay: replayed %u kernels\n", n_kernels);
+  ctx->exit_simulation();
+  return 0;
+}
@@ -0,0 +1,362 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Drives its_simt_stack, the independent thread scheduling engine, through
+// small programs the way core_t::updateSIMTStack() does: issue the split
+// get_pdom_stack_top_info() names, execute it on the active lanes, then pass
+// the per-lane next pcs, exited lanes, reconvergence pc and the WARP_SYNC
+// bar_type of the instruction to update(). Each case lists the pc, active
+// mask (lane 0 first) and reconvergence pc expected at every issue, so any
+// change to the scheduling order or the barriers shows up as a mismatch.
+// The warp is eight lanes wide to keep the masks readable.
+//
+// The make rule copies its_simt_stack out of abstract_hardware_model.h/.cc,
+// so the cases always run the engine in the tree.
+//
+// usage: its_stack_test [-v]
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <bitset>
+#include <string>
+#include <vector>
+
+// just enough of abstract_hardware_model.h for its_simt_stack
+typedef unsigned address_type;
+const unsigned MAX_WARP_SIZE = 32;
+typedef std::bitset<MAX_WARP_SIZE> simt_mask_t;
+typedef address_type addr_vector_t[MAX_WARP_SIZE];
+enum uarch_op_t { ALU_OP = 1, BRANCH_OP, BARRIER_OP };
+typedef enum uarch_op_t op_type;
+
+struct stats_stub {
+  void ptx_file_line_stats_add_warp_divergence(address_type pc, unsigned n) {}
+};
+struct func_sim_stub {
+  void ptx_print_insn(address_type pc, FILE *fp) {}
+};
+struct context_stub {
+  stats_stub *stats;
+  func_sim_stub *func_sim;
+};
+class gpgpu_sim {
+ public:
+  context_stub *gpgpu_ctx;
+};
+
+class simt_stack {
+ public:
+  simt_stack(unsigned wid, unsigned warpSize, class gpgpu_sim *gpu)
+      : m_warp_id(wid), m_warp_size(warpSize), m_gpu(gpu) {}
+  virtual ~simt_stack() {}
+
+ protected:
+  unsigned m_warp_id;
+  unsigned m_warp_size;
+  class gpgpu_sim *m_gpu;
+};
+
+#include "its_simt_stack.inc"
+
+const unsigned WARP_SIZE = 8;
+const unsigned ISIZE = 8;
+const address_type NO_PC = (address_type)-1;
+
+// one instruction of a test program, at pc = index * ISIZE
+enum test_op { ALU, SET_FLAG, BRA, WARP_SYNC_OP, EXIT };
+enum test_cond {
+  ALWAYS,
+  LANE_LT,    // lane < arg
+  LANE_EQ,    // lane == arg
+  LANE_ODD,
+  COUNT_LT,   // count < (lane & 3) + 1
+  COUNT_EQ,   // count == lane / 2 + 1
+  COUNT_LTI,  // count < arg
+  FLAG_CLEAR
+};
+struct test_inst {
+  test_op op;
+  test_cond cond;
+  unsigned arg;
+  address_type target;
+  address_type recvg_pc;  // immediate post-dominator of a branch
+  bool count;             // increments the lane's count
+};
+
+struct test_step {
+  address_type pc;
+  const char *mask;
+  address_type rpc;
+};
+
+struct test_case {
+  const char *name;
+  std::vector<test_inst> program;
+  std::vector<test_step> expected;
+};
+
+static bool taken(const test_inst &inst, unsigned lane, unsigned count,
+                  bool flag) {
+  switch (inst.cond) {
+    case ALWAYS:
+      return true;
+    case LANE_LT:
+      return lane < inst.arg;
+    case LANE_EQ:
+      return lane == inst.arg;
+    case LANE_ODD:
+      return lane & 1;
+    case COUNT_LT:
+      return count < (lane & 3) + 1;
+    case COUNT_EQ:
+      return count == lane / 2 + 1;
+    case COUNT_LTI:
+      return count < inst.arg;
+    case FLAG_CLEAR:
+      return !flag;
+  }
+  return false;
+}
+
+static std::string mask_string(const simt_mask_t &mask) {
+  std::string s;
+  for (unsigned i = 0; i < WARP_SIZE; i++) s += mask.test(i) ? '1' : '0';
+  return s;
+}
+
+static bool run_case(const test_case &tc, bool verbose) {
+  stats_stub stats;
+  func_sim_stub func_sim;
+  context_stub ctx = {&stats, &func_sim};
+  gpgpu_sim gpu;
+  gpu.gpgpu_ctx = &ctx;
+  its_simt_stack stack(0, WARP_SIZE, &gpu);
+
+  simt_mask_t launch_mask;
+  for (unsigned i = 0; i < WARP_SIZE; i++) launch_mask.set(i);
+  stack.launch(0, launch_mask);
+
+  // the pc of every thread, as its ptx_thread_info would hold it
+  addr_vector_t next_pc;
+  for (unsigned i = 0; i < WARP_SIZE; i++) next_pc[i] = 0;
+  unsigned count[WARP_SIZE] = {0};
+  bool flag = false;
+  simt_mask_t thread_done;
+  std::vector<test_step> trace;
+  std::vector<std::string> masks;
+  while (stack.get_active_mask().any() && trace.size() < 1000) {
+    unsigned pc, rpc;
+    stack.get_pdom_stack_top_info(&pc, &rpc);
+    const simt_mask_t active = stack.get_active_mask();
+    masks.push_back(mask_string(active));
+    test_step step = {pc, NULL, rpc};
+    trace.push_back(step);
+
+    assert(pc % ISIZE == 0 && pc / ISIZE < tc.program.size());
+    const test_inst &inst = tc.program[pc / ISIZE];
+    for (unsigned i = 0; i < WARP_SIZE; i++) {
+      if (!active.test(i)) continue;
+      if (inst.count) count[i]++;
+      next_pc[i] = pc + ISIZE;
+      if (inst.op == SET_FLAG) flag = true;
+      if (inst.op == BRA && taken(inst, i, count[i], flag))
+        next_pc[i] = inst.target;
+      if (inst.op == EXIT) thread_done.set(i);
+    }
+    op_type op = (inst.op == BRA) ? BRANCH_OP
+                                  : (inst.op == WARP_SYNC_OP ? BARRIER_OP
+                                                             : ALU_OP);
+    stack.update(thread_done, next_pc, inst.recvg_pc, op, ISIZE, pc,
+                 inst.op == WARP_SYNC_OP);
+  }
+  for (unsigned s = 0; s < trace.size(); s++) trace[s].mask = masks[s].c_str();
+
+  bool pass = trace.size() == tc.expected.size() && thread_done == launch_mask;
+  for (unsigned s = 0; pass && s < trace.size(); s++)
+    pass = trace[s].pc == tc.expected[s].pc &&
+           !strcmp(trace[s].mask, tc.expected[s].mask) &&
+           trace[s].rpc == tc.expected[s].rpc;
+  printf("its_stack_test: %-20s %s\n", tc.name, pass ? "PASS" : "FAIL");
+  if (!pass || verbose) {
+    for (unsigned s = 0; s < trace.size() || s < tc.expected.size(); s++) {
+      printf("  %3u:", s);
+      if (s < trace.size())
+        printf(" pc %3u %s rpc %3d", trace[s].pc, trace[s].mask,
+               (int)trace[s].rpc);
+      if (s < tc.expected.size())
+        printf("   expected pc %3u %s rpc %3d", tc.expected[s].pc,
+               tc.expected[s].mask, (int)tc.expected[s].rpc);
+      printf("\n");
+    }
+  }
+  return pass;
+}
+
+static test_inst inst(test_op op, test_cond cond = ALWAYS, unsigned arg = 0,
+                      address_type target = NO_PC,
+                      address_type recvg_pc = NO_PC, bool count = false) {
+  test_inst i = {op, cond, arg, target, recvg_pc, count};
+  return i;
+}
+
+static test_step step(address_type pc, const char *mask, address_type rpc) {
+  test_step s = {pc, mask, rpc};
+  return s;
+}
+
+int main(int argc, char **argv) {
+  bool verbose = argc > 1 && !strcmp(argv[1], "-v");
+  std::vector<test_case> cases;
+  test_case tc;
+
+  // if (lane < 4) A; else B; C
+  tc.name = "if/else";
+  tc.program.clear();
+  tc.program.push_back(inst(BRA, LANE_LT, 4, 24, 32));  // 0
+  tc.program.push_back(inst(ALU));                       // 8: B
+  tc.program.push_back(inst(BRA, ALWAYS, 0, 32, 32));    // 16
+  tc.program.push_back(inst(ALU));                       // 24: A
+  tc.program.push_back(inst(ALU));                       // 32: C
+  tc.program.push_back(inst(EXIT));                      // 40
+  tc.expected.clear();
+  tc.expected.push_back(step(0, "11111111", NO_PC));
+  tc.expected.push_back(step(24, "11110000", 32));
+  tc.expected.push_back(step(8, "00001111", 32));
+  tc.expected.push_back(step(16, "00001111", 32));
+  tc.expected.push_back(step(32, "11111111", NO_PC));
+  tc.expected.push_back(step(40, "11111111", NO_PC));
+  cases.push_back(tc);
+
+  // do { count++; } while (count < (lane & 3) + 1)
+  tc.name = "loop";
+  tc.program.clear();
+  tc.program.push_back(inst(ALU, ALWAYS, 0, NO_PC, NO_PC, true));  // 0
+  tc.program.push_back(inst(BRA, COUNT_LT, 0, 0, 16));             // 8
+  tc.program.push_back(inst(EXIT));                                // 16
+  tc.expected.clear();
+  tc.expected.push_back(step(0, "11111111", NO_PC));
+  tc.expected.push_back(step(8, "11111111", NO_PC));
+  tc.expected.push_back(step(0, "01110111", 16));
+  tc.expected.push_back(step(8, "01110111", 16));
+  tc.expected.push_back(step(0, "00110011", 16));
+  tc.expected.push_back(step(8, "00110011", 16));
+  tc.expected.push_back(step(0, "00010001", 16));
+  tc.expected.push_back(step(8, "00010001", 16));
+  tc.expected.push_back(step(16, "11111111", NO_PC));
+  cases.push_back(tc);
+
+  // do { count++; if (count == lane / 2 + 1) break; if (!(lane & 1)) A; }
+  // while (count < 3); B
+  tc.name = "break-out";
+  tc.program.clear();
+  tc.program.push_back(inst(ALU, ALWAYS, 0, NO_PC, NO_PC, true));  // 0
+  tc.program.push_back(inst(BRA, COUNT_EQ, 0, 40, 40));            // 8
+  tc.program.push_back(inst(BRA, LANE_ODD, 0, 32, 32));            // 16
+  tc.program.push_back(inst(ALU));                                 // 24: A
+  tc.program.push_back(inst(BRA, COUNT_LTI, 3, 0, 40));            // 32
+  tc.program.push_back(inst(ALU));                                 // 40: B
+  tc.program.push_back(inst(EXIT));                                // 48
+  tc.expected.clear();
+  tc.expected.push_back(step(0, "11111111", NO_PC));
+  tc.expected.push_back(step(8, "11111111", NO_PC));
+  tc.expected.push_back(step(16, "00111111", 40));  // lanes 0-1 broke out
+  tc.expected.push_back(step(24, "00101010", 32));
+  tc.expected.push_back(step(32, "00111111", 40));
+  tc.expected.push_back(step(0, "00111111", 40));
+  tc.expected.push_back(step(8, "00111111", 40));
+  tc.expected.push_back(step(16, "00001111", 40));  // lanes 2-3 broke out
+  tc.expected.push_back(step(24, "00001010", 32));
+  tc.expected.push_back(step(32, "00001111", 40));
+  tc.expected.push_back(step(0, "00001111", 40));
+  tc.expected.push_back(step(8, "00001111", 40));
+  tc.expected.push_back(step(16, "00000011", 40));  // lanes 4-5 broke out
+  tc.expected.push_back(step(24, "00000010", 32));
+  tc.expected.push_back(step(32, "00000011", 40));
+  tc.expected.push_back(step(40, "11111111", NO_PC));
+  tc.expected.push_back(step(48, "11111111", NO_PC));
+  cases.push_back(tc);
+
+  // if (lane < 4) { __syncwarp(); A; } else { B; __syncwarp(); }
+  // __syncwarp()
+  tc.name = "divergent __syncwarp";
+  tc.program.clear();
+  tc.program.push_back(inst(BRA, LANE_LT, 4, 32, 48));  // 0
+  tc.program.push_back(inst(ALU));                       // 8: B
+  tc.program.push_back(inst(WARP_SYNC_OP));              // 16
+  tc.program.push_back(inst(BRA, ALWAYS, 0, 48, 48));    // 24
+  tc.program.push_back(inst(WARP_SYNC_OP));              // 32
+  tc.program.push_back(inst(ALU));                       // 40: A
+  tc.program.push_back(inst(WARP_SYNC_OP));              // 48
+  tc.program.push_back(inst(EXIT));                      // 56
+  tc.expected.clear();
+  tc.expected.push_back(step(0, "11111111", NO_PC));
+  tc.expected.push_back(step(32, "11110000", 48));
+  tc.expected.push_back(step(8, "00001111", 40));  // 0-3 wait at __syncwarp
+  tc.expected.push_back(step(16, "00001111", 40));
+  tc.expected.push_back(step(24, "00001111", 48));  // both sides released
+  tc.expected.push_back(step(40, "11110000", 48));
+  tc.expected.push_back(step(48, "11111111", NO_PC));
+  tc.expected.push_back(step(56, "11111111", NO_PC));
+  cases.push_back(tc);
+
+  // if (lane == 0) { while (!flag); A; } else { B; flag = 1; }
+  // lane 0 runs first and must yield at its backward branch
+  tc.name = "spin-wait";
+  tc.program.clear();
+  tc.program.push_back(inst(BRA, LANE_EQ, 0, 32, 56));   // 0
+  tc.program.push_back(inst(ALU));                       // 8: B
+  tc.program.push_back(inst(SET_FLAG));                  // 16
+  tc.program.push_back(inst(BRA, ALWAYS, 0, 56, 56));    // 24
+  tc.program.push_back(inst(ALU));                       // 32: load flag
+  tc.program.push_back(inst(BRA, FLAG_CLEAR, 0, 32, 48));  // 40
+  tc.program.push_back(inst(ALU));                       // 48: A
+  tc.program.push_back(inst(EXIT));                      // 56
+  tc.expected.clear();
+  tc.expected.push_back(step(0, "11111111", NO_PC));
+  tc.expected.push_back(step(32, "10000000", 56));
+  tc.expected.push_back(step(40, "10000000", 56));
+  tc.expected.push_back(step(8, "01111111", 56));
+  tc.expected.push_back(step(16, "01111111", 56));
+  tc.expected.push_back(step(24, "01111111", 56));
+  tc.expected.push_back(step(32, "10000000", 56));
+  tc.expected.push_back(step(40, "10000000", 56));
+  tc.expected.push_back(step(48, "10000000", 56));
+  tc.expected.push_back(step(56, "11111111", NO_PC));
+  cases.push_back(tc);
+
+  unsigned failed = 0;
+  for (unsigned i = 0; i < cases.size(); i++)
+    if (!run_case(cases[i], verbose)) failed++;
+  if (failed) {
+    printf("its_stack_test: %u of %zu cases FAILED\n", failed, cases.size());
+    return 1;
+  }
+  printf("its_stack_test: all %zu cases passed\n", cases.size());
+  return 0;
+}
@@ -0,0 +1,223 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Drives the L1D latency queue of ldst_unit and a copy of the shift register
+// of l1_latency slots per bank that it replaced with the same random stream
+// of requests, and checks cycle by cycle that both send the same request of
+// each bank to the L1D and accept or refuse the same new requests.  As in
+// ldst_unit::cycle(), L1_latency_queue_cycle() runs first and memory_cycle()
+// and issue_prefetch() then try to queue new requests, several per bank at
+// times.  A demand request at the head that gets RESERVATION_FAIL stays
+// there; prefetches and every other outcome leave the queue.
+//
+// The make rule pulls l1_latency_queue_free() and l1_latency_queue_push()
+// out of shader.cc; the part of L1_latency_queue_cycle() that walks the
+// queue is restated in latency_unit::cycle() below, as the rest of it needs
+// a whole L1D.
+//
+// usage: l1_latency_diff [trials] [cycles] [seed]
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <deque>
+#include <vector>
+
+struct mem_fetch {
+  unsigned id;
+  bool prefetch;
+};
+
+struct l1d_cache_config {
+  unsigned l1_latency;
+  int l1_banks;
+};
+struct shader_core_config {
+  l1d_cache_config m_L1D_config;
+};
+
+// the ldst_unit members of the current queue
+class latency_unit {
+ public:
+  latency_unit(const shader_core_config *config) : m_config(config) {
+    l1_latency_queue.resize(m_config->m_L1D_config.l1_banks);
+    m_l1_latency_cycle = 0;
+  }
+  bool l1_latency_queue_free(unsigned bank) const;
+  void l1_latency_queue_push(unsigned bank, mem_fetch *mf);
+  // L1_latency_queue_cycle(); fail[j] is the L1D's RESERVATION_FAIL for
+  // bank j and accessed[j] gets the request it saw, or NULL
+  void cycle(const std::vector<bool> &fail,
+             std::vector<mem_fetch *> &accessed) {
+    m_l1_latency_cycle++;
+    for (int j = 0; j < m_config->m_L1D_config.l1_banks; j++) {
+      accessed[j] = NULL;
+      if (!l1_latency_queue[j].empty() &&
+          l1_latency_queue[j].front().ready <= m_l1_latency_cycle) {
+        mem_fetch *mf_next = l1_latency_queue[j].front().mf;
+        accessed[j] = mf_next;
+        if (mf_next->prefetch || !fail[j]) l1_latency_queue[j].pop_front();
+      }
+    }
+  }
+
+ private:
+  const shader_core_config *m_config;
+  struct l1_latency_entry {
+    mem_fetch *mf;
+    unsigned long long ready;
+  };
+  std::vector<std::deque<l1_latency_entry>> l1_latency_queue;
+  unsigned long long m_l1_latency_cycle;
+};
+
+#include "l1_latency_current.inc"
+
+// the queue before the ready stamps: l1_latency slots per bank, a new
+// request enters the last one and every request moves down a slot per cycle
+// when the slot below it is free
+class reference_unit {
+ public:
+  reference_unit(const shader_core_config *config) : m_config(config) {
+    l1_latency_queue.resize(m_config->m_L1D_config.l1_banks);
+    for (int j = 0; j < m_config->m_L1D_config.l1_banks; j++)
+      l1_latency_queue[j].resize(m_config->m_L1D_config.l1_latency,
+                                 (mem_fetch *)NULL);
+  }
+  bool try_push(unsigned bank, mem_fetch *mf) {
+    if ((l1_latency_queue[bank][m_config->m_L1D_config.l1_latency - 1]) ==
+        NULL) {
+      l1_latency_queue[bank][m_config->m_L1D_config.l1_latency - 1] = mf;
+      return true;
+    }
+    return false;
+  }
+  void cycle(const std::vector<bool> &fail,
+             std::vector<mem_fetch *> &accessed) {
+    for (int j = 0; j < m_config->m_L1D_config.l1_banks; j++) {
+      accessed[j] = NULL;
+      if ((l1_latency_queue[j][0]) != NULL) {
+        mem_fetch *mf_next = l1_latency_queue[j][0];
+        accessed[j] = mf_next;
+        if (mf_next->prefetch || !fail[j]) l1_latency_queue[j][0] = NULL;
+      }
+
+      for (unsigned stage = 0; stage < m_config->m_L1D_config.l1_latency - 1;
+           ++stage)
+        if (l1_latency_queue[j][stage] == NULL) {
+          l1_latency_queue[j][stage] = l1_latency_queue[j][stage + 1];
+          l1_latency_queue[j][stage + 1] = NULL;
+        }
+    }
+  }
+
+ private:
+  const shader_core_config *m_config;
+  std::vector<std::deque<mem_fetch *>> l1_latency_queue;
+};
+
+static unsigned long long g_rand_state;
+static unsigned long long rnd() {
+  g_rand_state ^= g_rand_state << 13;
+  g_rand_state ^= g_rand_state >> 7;
+  g_rand_state ^= g_rand_state << 17;
+  return g_rand_state;
+}
+
+// one configuration: latency, bank count, arrival rate, share of prefetches
+// and how often the L1D refuses the request at the head of a bank
+static bool run_trial(unsigned trial, unsigned n_cycles,
+                      unsigned long long &n_accesses,
+                      unsigned long long &n_accepts) {
+  shader_core_config config;
+  config.m_L1D_config.l1_latency = 1 + rnd() % 24;
+  config.m_L1D_config.l1_banks = 1 + rnd() % 4;
+  unsigned arrival_pct = rnd() % 101;
+  unsigned prefetch_pct = rnd() % 30;
+  unsigned fail_pct = rnd() % 80;
+  const unsigned n_banks = config.m_L1D_config.l1_banks;
+
+  latency_unit current(&config);
+  reference_unit reference(&config);
+  std::vector<bool> fail(n_banks);
+  std::vector<mem_fetch *> accessed(n_banks), expected(n_banks);
+  std::deque<mem_fetch> fetches;  // owns every request of the trial
+  for (unsigned c = 0; c < n_cycles; c++) {
+    for (unsigned j = 0; j < n_banks; j++) fail[j] = rnd() % 100 < fail_pct;
+    reference.cycle(fail, expected);
+    current.cycle(fail, accessed);
+    for (unsigned j = 0; j < n_banks; j++) {
+      if (accessed[j] != expected[j]) {
+        printf(
+            "l1_latency_diff: MISMATCH in trial %u (latency %u) cycle %u bank "
+            "%u: L1D access to request %d vs %d\n",
+            trial, config.m_L1D_config.l1_latency, c, j,
+            expected[j] ? (int)expected[j]->id : -1,
+            accessed[j] ? (int)accessed[j]->id : -1);
+        return false;
+      }
+      if (accessed[j]) n_accesses++;
+    }
+
+    // memory_cycle() and issue_prefetch()
+    for (unsigned r = 0; r < 2 * n_banks; r++) {
+      if (rnd() % 100 >= arrival_pct) continue;
+      mem_fetch mf = {(unsigned)fetches.size(), rnd() % 100 < prefetch_pct};
+      fetches.push_back(mf);
+      unsigned bank = rnd() % n_banks;
+      bool accepted = current.l1_latency_queue_free(bank);
+      if (accepted) current.l1_latency_queue_push(bank, &fetches.back());
+      if (reference.try_push(bank, &fetches.back()) != accepted) {
+        printf(
+            "l1_latency_diff: MISMATCH in trial %u (latency %u) cycle %u bank "
+            "%u: request %u %s vs %s\n",
+            trial, config.m_L1D_config.l1_latency, c, bank, mf.id,
+            accepted ? "refused" : "accepted",
+            accepted ? "accepted" : "refused");
+        return false;
+      }
+      if (accepted) n_accepts++;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  unsigned n_trials = (argc > 1) ? atoi(argv[1]) : 2000;
+  unsigned n_cycles = (argc > 2) ? atoi(argv[2]) : 5000;
+  g_rand_state = (argc > 3) ? atoll(argv[3]) : 88172645463325252ULL;
+
+  unsigned long long n_accesses = 0, n_accepts = 0;
+  for (unsigned t = 0; t < n_trials; t++)
+    if (!run_trial(t, n_cycles, n_accesses, n_accepts)) return 1;
+  printf(
+      "l1_latency_diff: %u trials x %u cycles, %llu accepts, %llu L1D "
+      "accesses, identical\n",
+      n_trials, n_cycles, n_accepts, n_accesses);
+  return 0;
+}
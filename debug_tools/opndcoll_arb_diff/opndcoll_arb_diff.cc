@@ -0,0 +1,315 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Runs opndcoll_rfu_t::arbiter_t::allocate_reads from the source tree and a
+// copy of the booksim wavefront allocator it replaced on the same random
+// streams of register reads and write-allocated banks, and checks that both
+// grant the same reads and rotate the priority diagonal the same way every
+// cycle. Idle cycles go through idle_step() as ldst_unit::idle_cycle() does.
+// The make rules pull the current allocator, bit_mask_t and op_queue_t out of
+// shader.h/shader.cc, so the check always runs against the code in the tree.
+//
+// usage: opndcoll_arb_diff [trials] [cycles] [seed]
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <list>
+#include <vector>
+
+#define MAX_REG_OPERANDS 32
+
+// the op_t members the arbiter reads
+class op_t {
+ public:
+  op_t() : m_cu(0), m_bank(0), m_id(0) {}
+  op_t(unsigned cu, unsigned bank, unsigned id)
+      : m_cu(cu), m_bank(bank), m_id(id) {}
+  unsigned get_oc_id() const { return m_cu; }
+  unsigned get_bank() const { return m_bank; }
+  bool operator==(const op_t &o) const {
+    return m_cu == o.m_cu && m_bank == o.m_bank && m_id == o.m_id;
+  }
+
+ private:
+  unsigned m_cu, m_bank, m_id;
+};
+
+class allocation_t {
+ public:
+  allocation_t() : m_write(false) {}
+  bool is_write() const { return m_write; }
+  void alloc_write() { m_write = true; }
+  void reset() { m_write = false; }
+
+ private:
+  bool m_write;
+};
+
+#include "arbiter_types.inc"
+
+// the arbiter_t state allocate_reads() works on
+class arbiter {
+ public:
+  void init(unsigned num_cu, unsigned num_banks) {
+    m_num_collectors = num_cu;
+    m_num_banks = num_banks;
+    m_queue = new op_queue_t[num_banks];
+    for (unsigned b = 0; b < num_banks; b++)
+      m_queue[b].init(num_cu * MAX_REG_OPERANDS * 2);
+    m_allocated_bank = new allocation_t[num_banks];
+    m_requests.init(num_banks);
+    m_granted.init(num_banks);
+    m_cu_requested.init(num_cu);
+    m_cu_diagonal.resize(num_cu);
+    m_cu_bank.resize(num_cu);
+    m_last_cu = 0;
+  }
+  ~arbiter() {
+    delete[] m_queue;
+    delete[] m_allocated_bank;
+  }
+  void allocate_reads(std::vector<op_t> &result);
+  void add_read_request(const op_t &op) {
+    m_queue[op.get_bank()].push_back(op);
+    m_requests.set(op.get_bank());
+  }
+  bool idle() const { return m_requests.none(); }
+  void idle_step() {
+    unsigned square =
+        (m_num_banks > m_num_collectors) ? m_num_banks : m_num_collectors;
+    m_last_cu = (m_last_cu + 1) % square;
+  }
+
+  unsigned m_num_banks;
+  unsigned m_num_collectors;
+  allocation_t *m_allocated_bank;
+  op_queue_t *m_queue;
+  bit_mask_t m_requests;
+  unsigned m_last_cu;
+  bit_mask_t m_granted;
+  bit_mask_t m_cu_requested;
+  std::vector<unsigned> m_cu_diagonal;
+  std::vector<unsigned> m_cu_bank;
+};
+
+#include "arbiter_current.inc"
+
+// the arbiter before the bank bitmasks, with its std::list queues
+class reference_arbiter {
+ public:
+  void init(unsigned num_cu, unsigned num_banks) {
+    m_num_collectors = num_cu;
+    m_num_banks = num_banks;
+    _inmatch = new int[m_num_banks];
+    _outmatch = new int[m_num_collectors];
+    _request = new int *[m_num_banks];
+    for (unsigned i = 0; i < m_num_banks; i++)
+      _request[i] = new int[m_num_collectors];
+    m_queue = new std::list<op_t>[num_banks];
+    m_allocated_bank = new allocation_t[num_banks];
+    m_last_cu = 0;
+  }
+  ~reference_arbiter() {
+    for (unsigned i = 0; i < m_num_banks; i++) delete[] _request[i];
+    delete[] _request;
+    delete[] _inmatch;
+    delete[] _outmatch;
+    delete[] m_queue;
+    delete[] m_allocated_bank;
+  }
+  std::list<op_t> allocate_reads();
+  void add_read_request(const op_t &op) {
+    m_queue[op.get_bank()].push_back(op);
+  }
+
+  unsigned m_num_banks;
+  unsigned m_num_collectors;
+  allocation_t *m_allocated_bank;
+  std::list<op_t> *m_queue;
+  unsigned m_last_cu;
+  int *_inmatch;
+  int *_outmatch;
+  int **_request;
+};
+
+std::list<op_t> reference_arbiter::allocate_reads() {
+  std::list<op_t> result;
+
+  int input;
+  int output;
+  int _inputs = m_num_banks;
+  int _outputs = m_num_collectors;
+  int _square = (_inputs > _outputs) ? _inputs : _outputs;
+  assert(_square > 0);
+  int _pri = (int)m_last_cu;
+
+  // Clear matching
+  for (int i = 0; i < _inputs; ++i) _inmatch[i] = -1;
+  for (int j = 0; j < _outputs; ++j) _outmatch[j] = -1;
+
+  for (unsigned i = 0; i < m_num_banks; i++) {
+    for (unsigned j = 0; j < m_num_collectors; j++) _request[i][j] = 0;
+    if (!m_queue[i].empty()) {
+      const op_t &op = m_queue[i].front();
+      int oc_id = op.get_oc_id();
+      assert(oc_id < _outputs);
+      _request[i][oc_id] = 1;
+    }
+    if (m_allocated_bank[i].is_write()) {
+      _inmatch[i] = 0;  // write gets priority
+    }
+  }
+
+  ///// wavefront allocator from booksim... --->
+
+  // Loop through diagonals of request matrix
+
+  for (int p = 0; p < _square; ++p) {
+    output = (_pri + p) % _square;
+
+    // Step through the current diagonal
+    for (input = 0; input < _inputs; ++input) {
+      if ((output < _outputs) && (_inmatch[input] == -1) &&
+          (_outmatch[output] == -1) && (_request[input][output])) {
+        // Grant!
+        _inmatch[input] = output;
+        _outmatch[output] = input;
+      }
+
+      output = (output + 1) % _square;
+    }
+  }
+
+  // Round-robin the priority diagonal
+  _pri = (_pri + 1) % _square;
+
+  /// <--- end code from booksim
+
+  m_last_cu = _pri;
+  for (unsigned i = 0; i < m_num_banks; i++) {
+    if (_inmatch[i] != -1) {
+      if (!m_allocated_bank[i].is_write()) {
+        unsigned bank = (unsigned)i;
+        op_t &op = m_queue[bank].front();
+        result.push_back(op);
+        m_queue[bank].pop_front();
+      }
+    }
+  }
+
+  return result;
+}
+
+static unsigned long long g_rand_state;
+static unsigned long long rnd() {
+  g_rand_state ^= g_rand_state << 13;
+  g_rand_state ^= g_rand_state >> 7;
+  g_rand_state ^= g_rand_state << 17;
+  return g_rand_state;
+}
+
+// one configuration: bank and collector counts on both sides of each other
+// and of the 64-bit word boundary of bit_mask_t, a read load from a trickle
+// to saturation and a rate of bank write allocations
+static bool run_trial(unsigned trial, unsigned n_cycles,
+                      unsigned long long &n_grants) {
+  unsigned n_banks = 1 + rnd() % 80;
+  unsigned n_cus = 1 + rnd() % 80;
+  unsigned load = rnd() % 17;     // reads issued per cycle, at most
+  unsigned write_pct = rnd() % 50;
+
+  arbiter current;
+  reference_arbiter reference;
+  current.init(n_cus, n_banks);
+  reference.init(n_cus, n_banks);
+  current.m_last_cu = reference.m_last_cu =
+      rnd() % ((n_banks > n_cus) ? n_banks : n_cus);
+
+  // a collector unit has at most MAX_REG_OPERANDS * 2 reads in flight
+  std::vector<unsigned> in_flight(n_cus, 0);
+  std::vector<op_t> grants;
+  unsigned id = 0;
+  for (unsigned c = 0; c < n_cycles; c++) {
+    unsigned n_reads = load ? rnd() % (load + 1) : 0;
+    for (unsigned r = 0; r < n_reads; r++) {
+      unsigned cu = rnd() % n_cus;
+      if (in_flight[cu] == MAX_REG_OPERANDS * 2) continue;
+      in_flight[cu]++;
+      op_t op(cu, rnd() % n_banks, id++);
+      current.add_read_request(op);
+      reference.add_read_request(op);
+    }
+    for (unsigned b = 0; b < n_banks; b++) {
+      current.m_allocated_bank[b].reset();
+      reference.m_allocated_bank[b].reset();
+      if (rnd() % 100 < write_pct) {
+        current.m_allocated_bank[b].alloc_write();
+        reference.m_allocated_bank[b].alloc_write();
+      }
+    }
+
+    std::list<op_t> expected = reference.allocate_reads();
+    if (current.idle()) {
+      current.idle_step();
+      grants.clear();
+    } else {
+      current.allocate_reads(grants);
+    }
+    bool same = expected.size() == grants.size() &&
+                current.m_last_cu == reference.m_last_cu;
+    std::list<op_t>::const_iterator e = expected.begin();
+    for (unsigned g = 0; same && g < grants.size(); g++, e++)
+      same = *e == grants[g];
+    if (!same) {
+      printf(
+          "opndcoll_arb_diff: MISMATCH in trial %u (%u banks, %u cus) cycle "
+          "%u: %zu vs %zu grants, last cu %u vs %u\n",
+          trial, n_banks, n_cus, c, expected.size(), grants.size(),
+          reference.m_last_cu, current.m_last_cu);
+      return false;
+    }
+    for (unsigned g = 0; g < grants.size(); g++)
+      in_flight[grants[g].get_oc_id()]--;
+    n_grants += grants.size();
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  unsigned n_trials = (argc > 1) ? atoi(argv[1]) : 500;
+  unsigned n_cycles = (argc > 2) ? atoi(argv[2]) : 500;
+  g_rand_state = (argc > 3) ? atoll(argv[3]) : 88172645463325252ULL;
+
+  unsigned long long n_grants = 0;
+  for (unsigned t = 0; t < n_trials; t++)
+    if (!run_trial(t, n_cycles, n_grants)) return 1;
+  printf("opndcoll_arb_diff: %u trials x %u cycles, %llu grants, identical\n",
+         n_trials, n_cycles, n_grants);
+  return 0;
+}
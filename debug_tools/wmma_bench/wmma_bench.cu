@@ -0,0 +1,207 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Microbenchmarks for the tensor core timing model. For wmma.mma.m16n16k16
+// with each accumulator (C fragment) type (f16, f32) it times, with
+// clock64() on the simulated SM,
+//
+//  - latency: one warp running a chain of dependent mma.sync, and
+//  - throughput: a block of BLOCK_WARPS warps, each with CHAINS independent
+//    accumulators,
+//
+// and compares them with what the latency / initiation interval table gives:
+//
+//   latency:    cycles per mma        = latency
+//   throughput: cycles per mma per SM = max(II / tensor units,
+//                                           latency / independent chains)
+//
+// Run it under GPGPU-Sim with the tables given to the simulator, in the
+// order of -ptx_opcode_latency_tensor_acc, e.g. for an SM7 config
+//
+//   wmma_bench -latency 64,64 -initiation 64,64 -units 4
+//
+// m32n8k16 and m8n32k16 are left out: the PTX functional model only
+// implements 16x16x16 fragments and aborts on the other shapes.
+//
+// A throughput well below the table usually means the fragment reads are
+// bound by the operand collector and register banks rather than the unit.
+
+#include <mma.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace nvcuda;
+
+#define N_ACC_TYPES 2  // f16 and f32 C fragments, as in the table
+#define BLOCK_WARPS 32
+#define CHAINS 4
+
+static unsigned g_latency[N_ACC_TYPES] = {64, 64};
+static unsigned g_initiation[N_ACC_TYPES] = {64, 64};
+static unsigned g_units = 4;
+static unsigned g_iters = 64;
+static unsigned g_slack = 8;  // issue, operand and writeback cycles allowed
+                              // on top of the table latency
+static double g_tolerance = 0.1;
+
+#define CUDA_CHECK(call)                                                  \
+  do {                                                                    \
+    cudaError_t err = (call);                                             \
+    if (err != cudaSuccess) {                                             \
+      printf("wmma_bench: %s failed: %s\n", #call, cudaGetErrorString(err)); \
+      exit(1);                                                            \
+    }                                                                     \
+  } while (0)
+
+// every warp runs n_chains independent chains of iters dependent mma.sync
+// and records the clock before and after
+template <int M, int N, int K, typename Acc, int n_chains>
+__global__ void mma_chains(const half *a, const half *b, Acc *d,
+                           unsigned iters, long long *cycles) {
+  wmma::fragment<wmma::matrix_a, M, N, K, half, wmma::row_major> frag_a;
+  wmma::fragment<wmma::matrix_b, M, N, K, half, wmma::col_major> frag_b;
+  wmma::fragment<wmma::accumulator, M, N, K, Acc> acc[n_chains];
+  unsigned warp = threadIdx.x / 32;
+
+  wmma::load_matrix_sync(frag_a, a, K);
+  wmma::load_matrix_sync(frag_b, b, K);
+  for (int c = 0; c < n_chains; c++) wmma::fill_fragment(acc[c], 0.0f);
+  __syncthreads();
+
+  long long start = clock64();
+  for (unsigned i = 0; i < iters; i++) {
+#pragma unroll
+    for (int c = 0; c < n_chains; c++)
+      wmma::mma_sync(acc[c], frag_a, frag_b, acc[c]);
+  }
+  long long end = clock64();
+
+  for (int c = 0; c < n_chains; c++)
+    wmma::store_matrix_sync(d + (warp * n_chains + c) * M * N, acc[c], N,
+                            wmma::mem_row_major);
+  if (threadIdx.x % 32 == 0) {
+    cycles[2 * warp] = start;
+    cycles[2 * warp + 1] = end;
+  }
+}
+
+// cycles per mma.sync over all warps of one block
+template <int M, int N, int K, typename Acc, int n_chains>
+static double run(unsigned n_warps) {
+  half *a, *b;
+  Acc *d;
+  long long *cycles;
+  CUDA_CHECK(cudaMalloc(&a, M * K * sizeof(half)));
+  CUDA_CHECK(cudaMalloc(&b, K * N * sizeof(half)));
+  CUDA_CHECK(cudaMalloc(&d, n_warps * n_chains * M * N * sizeof(Acc)));
+  CUDA_CHECK(cudaMalloc(&cycles, 2 * n_warps * sizeof(long long)));
+  CUDA_CHECK(cudaMemset(a, 0, M * K * sizeof(half)));
+  CUDA_CHECK(cudaMemset(b, 0, K * N * sizeof(half)));
+
+  mma_chains<M, N, K, Acc, n_chains>
+      <<<1, n_warps * 32>>>(a, b, d, g_iters, cycles);
+  CUDA_CHECK(cudaGetLastError());
+  CUDA_CHECK(cudaDeviceSynchronize());
+
+  long long *h_cycles = new long long[2 * n_warps];
+  CUDA_CHECK(cudaMemcpy(h_cycles, cycles, 2 * n_warps * sizeof(long long),
+                        cudaMemcpyDeviceToHost));
+  long long start = h_cycles[0], end = h_cycles[1];
+  for (unsigned w = 1; w < n_warps; w++) {
+    if (h_cycles[2 * w] < start) start = h_cycles[2 * w];
+    if (h_cycles[2 * w + 1] > end) end = h_cycles[2 * w + 1];
+  }
+  delete[] h_cycles;
+  CUDA_CHECK(cudaFree(a));
+  CUDA_CHECK(cudaFree(b));
+  CUDA_CHECK(cudaFree(d));
+  CUDA_CHECK(cudaFree(cycles));
+  return (double)(end - start) / ((double)n_warps * n_chains * g_iters);
+}
+
+static bool within(double measured, double expected, double slack) {
+  return measured >= expected * (1 - g_tolerance) &&
+         measured <= expected * (1 + g_tolerance) + slack;
+}
+
+// runs both tests for table entry i and prints one line; false on a mismatch
+template <int M, int N, int K, typename Acc>
+static bool check(unsigned i, const char *name) {
+  double latency = run<M, N, K, Acc, 1>(1);
+  double throughput = run<M, N, K, Acc, CHAINS>(BLOCK_WARPS);
+
+  double expected_latency = g_latency[i];
+  double expected_throughput = (double)g_initiation[i] / g_units;
+  double chain_bound = (double)g_latency[i] / (BLOCK_WARPS * CHAINS);
+  if (chain_bound > expected_throughput) expected_throughput = chain_bound;
+
+  bool latency_ok = within(latency, expected_latency, g_slack);
+  bool throughput_ok = within(throughput, expected_throughput, 0);
+  printf("%-14s %9.2f %9.2f %5s %11.3f %11.3f %5s\n", name, latency,
+         expected_latency, latency_ok ? "ok" : "FAIL", throughput,
+         expected_throughput, throughput_ok ? "ok" : "FAIL");
+  return latency_ok && throughput_ok;
+}
+
+static void parse_table(const char *arg, unsigned table[N_ACC_TYPES]) {
+  if (sscanf(arg, "%u,%u", &table[0], &table[1]) != N_ACC_TYPES) {
+    printf("wmma_bench: expected %u comma separated values, got \"%s\"\n",
+           N_ACC_TYPES, arg);
+    exit(1);
+  }
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "-latency"))
+      parse_table(argv[i + 1], g_latency);
+    else if (!strcmp(argv[i], "-initiation"))
+      parse_table(argv[i + 1], g_initiation);
+    else if (!strcmp(argv[i], "-units"))
+      g_units = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-iters"))
+      g_iters = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-slack"))
+      g_slack = atoi(argv[i + 1]);
+    else if (!strcmp(argv[i], "-tolerance"))
+      g_tolerance = atof(argv[i + 1]);
+    else {
+      printf("wmma_bench: unknown option %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  printf("%-14s %9s %9s %5s %11s %11s %5s\n", "shape", "latency", "expected",
+         "", "cycles/mma", "expected", "");
+  bool ok = true;
+  ok &= check<16, 16, 16, half>(0, "m16n16k16.f16");
+  ok &= check<16, 16, 16, float>(1, "m16n16k16.f32");
+  printf("wmma_bench: %s\n", ok ? "PASSED" : "FAILED");
+  return ok ? 0 : 1;
+}
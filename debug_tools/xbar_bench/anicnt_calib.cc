@@ -0,0 +1,264 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// Calibrates the analytical interconnect (-network_mode 3) against the local
+// crossbar (-network_mode 2, iSLIP). Both are fed the same open-loop traffic:
+// every source draws packets from the same random stream into an unbounded
+// source queue and pushes the head whenever the network has buffer space;
+// every destination pops at most one packet per cycle, as the memory
+// partitions and shader cores do. Latency runs from generation to pop, so
+// it includes source queueing.
+//
+// The scenarios are uniform random requests from the shaders (8 byte read
+// requests) at several injection rates, uniform random replies from the
+// memory partitions (136 byte read replies) and a hotspot. For each one it
+// prints the average latency and delivered packets per cycle of both
+// models, then searches -anicnt_latency x -anicnt_port_bandwidth for the
+// pair that tracks the crossbar best: the mean relative error of the
+// throughput over all scenarios and of the latency over the scenarios the
+// crossbar does not saturate (past saturation the latency only measures how
+// long the source queues grew during the run).
+//
+// usage: anicnt_calib [n_shader] [n_mem] [cycles] [buffer_limit]
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <deque>
+#include <vector>
+
+#include "analytical_interconnect.h"
+#include "local_interconnect.h"
+
+struct scenario {
+  const char *name;
+  bool reply;         // memory partitions send to shaders
+  double rate;        // packets per source per cycle
+  unsigned size;      // bytes
+  bool hotspot;       // every source sends to the first destination
+};
+
+struct result {
+  double latency;     // cycles from generation to pop
+  double throughput;  // delivered packets per cycle
+  bool saturated;     // delivered less than was offered
+};
+
+// xorshift, so both models see the same traffic
+static unsigned long long g_rng;
+static unsigned next_rand() {
+  g_rng ^= g_rng << 13;
+  g_rng ^= g_rng >> 7;
+  g_rng ^= g_rng << 17;
+  return (unsigned)(g_rng >> 11);
+}
+
+// one network under test; the same loop drives both models
+class net_adapter {
+ public:
+  virtual ~net_adapter() {}
+  virtual bool has_buffer(unsigned src, unsigned size) = 0;
+  virtual void push(unsigned src, unsigned dst, void *data, unsigned size) = 0;
+  virtual void advance() = 0;
+  virtual void *pop(unsigned dst) = 0;
+};
+
+class xbar_adapter : public net_adapter {
+ public:
+  xbar_adapter(bool reply, unsigned n_shader, unsigned n_mem, unsigned limit)
+      : m_router(0, reply ? REPLY_NET : REQ_NET, n_shader, n_mem, limit,
+                 limit, iSLIP) {}
+  bool has_buffer(unsigned src, unsigned size) {
+    return m_router.Has_Buffer_In(src, 1);
+  }
+  void push(unsigned src, unsigned dst, void *data, unsigned size) {
+    m_router.Push(src, dst, data, size);
+  }
+  void advance() { m_router.Advance(); }
+  void *pop(unsigned dst) { return m_router.Pop(dst); }
+
+ private:
+  xbar_router m_router;
+};
+
+class analytical_adapter : public net_adapter {
+ public:
+  analytical_adapter(unsigned latency, unsigned port_bandwidth,
+                     unsigned n_shader, unsigned n_mem, unsigned limit) {
+    m_config.latency = latency;
+    m_config.port_bandwidth = port_bandwidth;
+    m_config.in_buffer_limit = limit;
+    m_config.subnets = 1;
+    m_net = AnalyticalInterconnect::New(m_config);
+    m_net->CreateInterconnect(n_shader, n_mem);
+  }
+  ~analytical_adapter() { delete m_net; }
+  bool has_buffer(unsigned src, unsigned size) {
+    return m_net->HasBuffer(src, size);
+  }
+  void push(unsigned src, unsigned dst, void *data, unsigned size) {
+    m_net->Push(src, dst, data, size);
+  }
+  void advance() { m_net->Advance(); }
+  void *pop(unsigned dst) { return m_net->Pop(dst); }
+
+ private:
+  anicnt_config m_config;  // the model keeps a reference to it
+  AnalyticalInterconnect *m_net;
+};
+
+static result run(net_adapter &net, const scenario &sc, unsigned n_shader,
+                  unsigned n_mem, unsigned long long n_cycles) {
+  unsigned n_src = sc.reply ? n_mem : n_shader;
+  unsigned src_base = sc.reply ? n_shader : 0;
+  unsigned n_dst = sc.reply ? n_shader : n_mem;
+  unsigned dst_base = sc.reply ? 0 : n_shader;
+  unsigned threshold = (unsigned)(sc.rate * (1u << 21));
+
+  struct pending {
+    unsigned dst;
+    unsigned long long born;
+  };
+  std::vector<std::deque<pending> > sources(n_src);
+  std::vector<unsigned long long> born;  // indexed by data - 1
+  unsigned long long delivered = 0, total_latency = 0;
+  // skip the first tenth so the queues reach steady state
+  unsigned long long warmup = n_cycles / 10;
+
+  g_rng = 88172645463325252ULL;
+  for (unsigned long long cycle = 0; cycle < n_cycles; ++cycle) {
+    for (unsigned s = 0; s < n_src; ++s) {
+      if ((next_rand() & ((1u << 21) - 1)) < threshold) {
+        pending p;
+        p.dst = dst_base + (sc.hotspot ? 0 : next_rand() % n_dst);
+        p.born = cycle;
+        sources[s].push_back(p);
+      }
+      if (!sources[s].empty() && net.has_buffer(src_base + s, sc.size)) {
+        const pending &p = sources[s].front();
+        born.push_back(p.born);
+        net.push(src_base + s, p.dst, (void *)(uintptr_t)born.size(),
+                 sc.size);
+        sources[s].pop_front();
+      }
+    }
+    net.advance();
+    for (unsigned d = 0; d < n_dst; ++d) {
+      void *data = net.pop(dst_base + d);
+      if (data && cycle >= warmup) {
+        delivered++;
+        total_latency += cycle + 1 - born[(uintptr_t)data - 1];
+      }
+    }
+  }
+  result r;
+  r.latency = delivered ? (double)total_latency / delivered : 0;
+  r.throughput = (double)delivered / (n_cycles - warmup);
+  r.saturated = r.throughput < 0.99 * sc.rate * n_src;
+  return r;
+}
+
+static double rel_error(double model, double reference) {
+  double e = (model - reference) / reference;
+  return e < 0 ? -e : e;
+}
+
+int main(int argc, char **argv) {
+  unsigned n_shader = (argc > 1) ? atoi(argv[1]) : 80;
+  unsigned n_mem = (argc > 2) ? atoi(argv[2]) : 32;
+  unsigned long long n_cycles = (argc > 3) ? atoll(argv[3]) : 20000;
+  unsigned limit = (argc > 4) ? atoi(argv[4]) : 512;
+
+  const scenario scenarios[] = {
+      {"req uniform 0.10", false, 0.10, 8, false},
+      {"req uniform 0.25", false, 0.25, 8, false},
+      {"req uniform 0.30", false, 0.30, 8, false},
+      {"req uniform 0.35", false, 0.35, 8, false},
+      {"req uniform 0.50", false, 0.50, 8, false},
+      {"rep uniform 0.25", true, 0.25, 136, false},
+      {"rep uniform 0.50", true, 0.50, 136, false},
+      {"rep uniform 1.00", true, 1.00, 136, false},
+      {"req hotspot 0.01", false, 0.01, 8, true},
+  };
+  const unsigned n_scenarios = sizeof(scenarios) / sizeof(scenarios[0]);
+  const unsigned latencies[] = {0, 1, 2, 3, 4, 6, 8};
+  const unsigned bandwidths[] = {8, 16, 32, 40, 64, 128, 136, 256};
+  const unsigned n_latencies = sizeof(latencies) / sizeof(latencies[0]);
+  const unsigned n_bandwidths = sizeof(bandwidths) / sizeof(bandwidths[0]);
+
+  printf("anicnt_calib: %ux%u ports, buffers %u, %llu cycles\n", n_shader,
+         n_mem, limit, n_cycles);
+  std::vector<result> xbar(n_scenarios);
+  for (unsigned i = 0; i < n_scenarios; ++i) {
+    xbar_adapter net(scenarios[i].reply, n_shader, n_mem, limit);
+    xbar[i] = run(net, scenarios[i], n_shader, n_mem, n_cycles);
+  }
+
+  // mean relative error of latency and throughput over all scenarios
+  double best_error = -1;
+  unsigned best_latency = 0, best_bandwidth = 0;
+  for (unsigned l = 0; l < n_latencies; ++l) {
+    for (unsigned b = 0; b < n_bandwidths; ++b) {
+      double error = 0;
+      unsigned n_terms = 0;
+      for (unsigned i = 0; i < n_scenarios; ++i) {
+        analytical_adapter net(latencies[l], bandwidths[b], n_shader, n_mem,
+                               limit);
+        result r = run(net, scenarios[i], n_shader, n_mem, n_cycles);
+        error += rel_error(r.throughput, xbar[i].throughput);
+        n_terms++;
+        if (!xbar[i].saturated) {
+          error += rel_error(r.latency, xbar[i].latency);
+          n_terms++;
+        }
+      }
+      error /= n_terms;
+      if (best_error < 0 || error < best_error) {
+        best_error = error;
+        best_latency = latencies[l];
+        best_bandwidth = bandwidths[b];
+      }
+    }
+  }
+
+  printf("%-18s %10s %10s %10s %10s\n", "scenario", "xbar lat", "anicnt lat",
+         "xbar pkt/c", "anicnt pkt/c");
+  for (unsigned i = 0; i < n_scenarios; ++i) {
+    analytical_adapter net(best_latency, best_bandwidth, n_shader, n_mem,
+                           limit);
+    result r = run(net, scenarios[i], n_shader, n_mem, n_cycles);
+    printf("%-18s %10.2f %10.2f %10.3f %10.3f%s\n", scenarios[i].name,
+           xbar[i].latency, r.latency, xbar[i].throughput, r.throughput,
+           xbar[i].saturated ? "  (xbar saturated)" : "");
+  }
+  printf(
+      "anicnt_calib: best -anicnt_latency %u -anicnt_port_bandwidth %u, mean "
+      "relative error %.1f%%\n",
+      best_latency, best_bandwidth, 100 * best_error);
+  return 0;
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// Measures how many packets per second xbar_router can arbitrate. Every
+// cycle each shader injects into a random memory node while it has buffer
+// space, and every output buffer is drained, similar to a memory-bound
+// kernel on the request network.
+//
+// It then checks the QoS weights: the even shaders send class 0 and the odd
+// ones class 1, weighted 3:1, to a single memory node, and the delivered
+// share of class 0 has to come out at 3/4.
+//
+// usage: xbar_bench [n_shader] [n_mem] [cycles] [0=RR|1=iSLIP]
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include "local_interconnect.h"
+
+static double now() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+// fraction of the packets delivered to one hot output that are class 0
+static double qos_share(unsigned n_shader, unsigned n_mem,
+                        unsigned long long n_cycles, Arbiteration_type algo) {
+  xbar_router router(0, REQ_NET, n_shader, n_mem, 64, 64, algo, 2);
+  router.Set_QoS_Weight(0, 3);
+  router.Set_QoS_Weight(1, 1);
+
+  unsigned long long delivered[2] = {0, 0};
+  for (unsigned long long cycle = 0; cycle < n_cycles; ++cycle) {
+    // the classes come from different inputs, so they only meet at the output
+    for (unsigned s = 0; s < n_shader; ++s) {
+      unsigned c = s % 2;
+      if (router.Has_Buffer_In(s, 1, false, c))
+        router.Push(s, n_shader, (void *)(uintptr_t)(c + 1), 8, c);
+    }
+    router.Advance();
+    void *data = router.Pop(n_shader);
+    if (data) delivered[(uintptr_t)data - 1]++;
+  }
+  printf("xbar_bench: QoS 3:1, %s: delivered %llu:%llu\n",
+         (algo == iSLIP) ? "iSLIP" : "RR", delivered[0], delivered[1]);
+  return (double)delivered[0] / (delivered[0] + delivered[1]);
+}
+
+int main(int argc, char **argv) {
+  unsigned n_shader = (argc > 1) ? atoi(argv[1]) : 80;
+  unsigned n_mem = (argc > 2) ? atoi(argv[2]) : 32;
+  unsigned long long n_cycles = (argc > 3) ? atoll(argv[3]) : 1000000;
+  Arbiteration_type algo =
+      (argc > 4) ? (Arbiteration_type)atoi(argv[4]) : iSLIP;
+  unsigned total_nodes = n_shader + n_mem;
+
+  xbar_router router(0, REQ_NET, n_shader, n_mem, 64, 64, algo);
+  srand(1);
+
+  unsigned long long delivered = 0;
+  double start = now();
+  for (unsigned long long cycle = 0; cycle < n_cycles; ++cycle) {
+    for (unsigned s = 0; s < n_shader; ++s) {
+      if (router.Has_Buffer_In(s, 1))
+        router.Push(s, n_shader + rand() % n_mem, (void *)(cycle + 1), 8);
+    }
+    router.Advance();
+    for (unsigned o = 0; o < total_nodes; ++o) {
+      if (router.Pop(o)) delivered++;
+    }
+  }
+  double elapsed = now() - start;
+
+  printf("xbar_bench: %ux%u ports, %s, %llu cycles\n", n_shader, n_mem,
+         (algo == iSLIP) ? "iSLIP" : "RR", n_cycles);
+  printf(
+      "xbar_bench: %llu packets in %.3f s = %.3f Mpackets/s, %.3f "
+      "Mcycles/s\n",
+      delivered, elapsed, delivered / elapsed * 1e-6,
+      n_cycles / elapsed * 1e-6);
+  printf("xbar_bench: conflicts = %llu, out_buffer_full = %llu\n",
+         router.conflicts, router.out_buffer_full);
+
+  double share = qos_share(n_shader, n_mem, 100000, algo);
+  if (share < 0.74 || share > 0.76) {
+    printf("xbar_bench: FAIL class 0 got %.4f of the output, expected 0.75\n",
+           share);
+    return 1;
+  }
+  return 0;
+}
@@ -45,6 +45,7 @@ void mem_access_t::init(gpgpu_context *ctx) {
   m_uid = ++(gpgpu_ctx->sm_next_access_uid);
   m_addr = 0;
   m_req_size = 0;
+  m_kernel_id = 0;
 }
 void warp_inst_t::issue(const active_mask_t &mask, unsigned warp_id,
                         unsigned long long cycle, int dynamic_warp_id,
@@ -323,91 +324,39 @@ void warp_inst_t::generate_mem_accesses() {
     case shared_space:
     case sstarr_space: {
       unsigned subwarp_size = m_config->warp_size / m_config->mem_warp_parts;
+      unsigned banks_per_access = 1;
+      unsigned phase_size = subwarp_size;
+      if (m_config->shmem_wide_access_phases) {
+        // e.g. 32 banks x 4B serve 64-bit accesses a half-warp at a time and
+        // 128-bit accesses a quarter-warp at a time
+        unsigned access_size = data_size * vector_width;
+        banks_per_access = (access_size + m_config->shmem_bank_width - 1) /
+                           m_config->shmem_bank_width;
+        assert(banks_per_access <= MAX_SHMEM_BANKS_PER_ACCESS);
+        phase_size = std::min(
+            subwarp_size,
+            std::max(1u, m_config->num_shmem_bank / banks_per_access));
+      }
       unsigned total_accesses = 0;
+      unsigned phases = 0;
       for (unsigned subwarp = 0; subwarp < m_config->mem_warp_parts;
            subwarp++) {
-        // data structures used per part warp
-        std::map<unsigned, std::map<new_addr_type, unsigned> >
-            bank_accs;  // bank -> word address -> access count
-
-        // step 1: compute accesses to words in banks
-        for (unsigned thread = subwarp * subwarp_size;
-             thread < (subwarp + 1) * subwarp_size; thread++) {
-          if (!active(thread)) continue;
-          new_addr_type addr = m_per_scalar_thread[thread].memreqaddr[0];
-          // FIXME: deferred allocation of shared memory should not accumulate
-          // across kernel launches assert( addr < m_config->gpgpu_shmem_size );
-          unsigned bank = m_config->shmem_bank_func(addr);
-          new_addr_type word =
-              line_size_based_tag_func(addr, m_config->WORD_SIZE);
-          bank_accs[bank][word]++;
-        }
-
-        if (m_config->shmem_limited_broadcast) {
-          // step 2: look for and select a broadcast bank/word if one occurs
-          bool broadcast_detected = false;
-          new_addr_type broadcast_word = (new_addr_type)-1;
-          unsigned broadcast_bank = (unsigned)-1;
-          std::map<unsigned, std::map<new_addr_type, unsigned> >::iterator b;
-          for (b = bank_accs.begin(); b != bank_accs.end(); b++) {
-            unsigned bank = b->first;
-            std::map<new_addr_type, unsigned> &access_set = b->second;
-            std::map<new_addr_type, unsigned>::iterator w;
-            for (w = access_set.begin(); w != access_set.end(); ++w) {
-              if (w->second > 1) {
-                // found a broadcast
-                broadcast_detected = true;
-                broadcast_bank = bank;
-                broadcast_word = w->first;
-                break;
-              }
-            }
-            if (broadcast_detected) break;
-          }
-
-          // step 3: figure out max bank accesses performed, taking account of
-          // broadcast case
-          unsigned max_bank_accesses = 0;
-          for (b = bank_accs.begin(); b != bank_accs.end(); b++) {
-            unsigned bank_accesses = 0;
-            std::map<new_addr_type, unsigned> &access_set = b->second;
-            std::map<new_addr_type, unsigned>::iterator w;
-            for (w = access_set.begin(); w != access_set.end(); ++w)
-              bank_accesses += w->second;
-            if (broadcast_detected && broadcast_bank == b->first) {
-              for (w = access_set.begin(); w != access_set.end(); ++w) {
-                if (w->first == broadcast_word) {
-                  unsigned n = w->second;
-                  assert(n > 1);  // or this wasn't a broadcast
-                  assert(bank_accesses >= (n - 1));
-                  bank_accesses -= (n - 1);
-                  break;
-                }
-              }
-            }
-            if (bank_accesses > max_bank_accesses)
-              max_bank_accesses = bank_accesses;
-          }
-
-          // step 4: accumulate
-          total_accesses += max_bank_accesses;
-        } else {
-          // step 2: look for the bank with the maximum number of access to
-          // different words
-          unsigned max_bank_accesses = 0;
-          std::map<unsigned, std::map<new_addr_type, unsigned> >::iterator b;
-          for (b = bank_accs.begin(); b != bank_accs.end(); b++) {
-            max_bank_accesses =
-                std::max(max_bank_accesses, (unsigned)b->second.size());
-          }
-
-          // step 3: accumulate
-          total_accesses += max_bank_accesses;
+        unsigned subwarp_end = (subwarp + 1) * subwarp_size;
+        for (unsigned phase = subwarp * subwarp_size; phase < subwarp_end;
+             phase += phase_size) {
+          unsigned accesses = shmem_bank_accesses(
+              phase, std::min(phase + phase_size, subwarp_end),
+              banks_per_access);
+          if (accesses) phases++;
+          total_accesses += accesses;
         }
       }
-      assert(total_accesses > 0 && total_accesses <= m_config->warp_size);
+      assert(total_accesses > 0 &&
+             total_accesses <= m_config->warp_size * banks_per_access);
       cycles = total_accesses;  // shared memory conflicts modeled as larger
                                 // initiation interval
+      m_shmem_conflict_degree = total_accesses;
+      m_shmem_phases = phases;
       m_config->gpgpu_ctx->stats->ptx_file_line_stats_add_smem_bank_conflict(
           pc, total_accesses);
       break;
@@ -465,6 +414,16 @@ void warp_inst_t::generate_mem_accesses() {
   m_mem_accesses_created = true;
 }
 
+// sets bytes [idx, idx + size) of a 128-bit byte mask held as two words
+static inline void set_byte_range(unsigned long long bytes[2], unsigned idx,
+                                  unsigned size) {
+  assert(size < 64 && idx + size <= MAX_MEMORY_ACCESS_SIZE);
+  unsigned long long mask = (1ULL << size) - 1;
+  unsigned shift = idx % 64;
+  bytes[idx / 64] |= mask << shift;
+  if (shift + size > 64) bytes[1] |= mask >> (64 - shift);
+}
+
 void warp_inst_t::memory_coalescing_arch(bool is_write,
                                          mem_access_type access_type) {
   // see the CUDA manual where it discusses coalescing rules before reading this
@@ -500,61 +459,69 @@ void warp_inst_t::memory_coalescing_arch(bool is_write,
   }
   unsigned subwarp_size = m_config->warp_size / warp_parts;
 
+  unsigned data_size_coales = data_size;
+  if (space.get_type() == local_space ||
+      space.get_type() == param_space_local) {
+    // Local memory accesses >4B were split into 4B chunks
+    // Otherwise keep the same data_size for sub-4B access to local memory
+    if (data_size >= 4) data_size_coales = 4;
+  }
+  assert(data_size / data_size_coales <= MAX_ACCESSES_PER_INSN_PER_THREAD);
+  assert(m_config->warp_size <= MAX_WARP_SIZE);
+
+  // every access of a subwarp packed as (segment address, lane, offset within
+  // the 128-byte chunk); sorting groups each transaction's accesses together
+  // in ascending segment order
+  unsigned long long
+      accesses[MAX_WARP_SIZE * MAX_ACCESSES_PER_INSN_PER_THREAD];
+
   for (unsigned subwarp = 0; subwarp < warp_parts; subwarp++) {
-    std::map<new_addr_type, transaction_info> subwarp_transactions;
+    unsigned n_accesses = 0;
 
     // step 1: find all transactions generated by this subwarp
     for (unsigned thread = subwarp * subwarp_size;
          thread < subwarp_size * (subwarp + 1); thread++) {
       if (!active(thread)) continue;
 
-      unsigned data_size_coales = data_size;
-      unsigned num_accesses = 1;
-
-      if (space.get_type() == local_space ||
-          space.get_type() == param_space_local) {
-        // Local memory accesses >4B were split into 4B chunks
-        if (data_size >= 4) {
-          data_size_coales = 4;
-          num_accesses = data_size / 4;
-        }
-        // Otherwise keep the same data_size for sub-4B access to local memory
-      }
-
-      assert(num_accesses <= MAX_ACCESSES_PER_INSN_PER_THREAD);
-
-      //            for(unsigned access=0; access<num_accesses; access++) {
-      for (unsigned access = 0;
-           (access < MAX_ACCESSES_PER_INSN_PER_THREAD) &&
-           (m_per_scalar_thread[thread].memreqaddr[access] != 0);
+      const new_addr_type *memreqaddr = m_per_scalar_thread[thread].memreqaddr;
+      for (unsigned access = 0; (access < MAX_ACCESSES_PER_INSN_PER_THREAD) &&
+                                (memreqaddr[access] != 0);
            access++) {
-        new_addr_type addr = m_per_scalar_thread[thread].memreqaddr[access];
+        new_addr_type addr = memreqaddr[access];
         unsigned block_address = line_size_based_tag_func(addr, segment_size);
-        unsigned chunk =
-            (addr & 127) / 32;  // which 32-byte chunk within in a 128-byte
-                                // chunk does this thread access?
-        transaction_info &info = subwarp_transactions[block_address];
 
         // can only write to one segment
         assert(block_address == line_size_based_tag_func(
                                     addr + data_size_coales - 1, segment_size));
 
-        info.chunks.set(chunk);
-        info.active.set(thread);
-        unsigned idx = (addr & 127);
-        for (unsigned i = 0; i < data_size_coales; i++) info.bytes.set(idx + i);
+        accesses[n_accesses++] =
+            ((unsigned long long)block_address << 32) | (thread << 8) |
+            (addr & 127);
       }
     }
+    std::sort(accesses, accesses + n_accesses);
+
+    // step 2: build the masks of each transaction and reduce its size, if
+    // possible
+    for (unsigned i = 0; i < n_accesses;) {
+      unsigned block_address = accesses[i] >> 32;
+      unsigned long long bytes[2] = {0, 0};
+      unsigned long chunks = 0;
+      transaction_info info;
+      for (; i < n_accesses && (unsigned)(accesses[i] >> 32) == block_address;
+           i++) {
+        unsigned idx = accesses[i] & 0xff;
+        info.active.set((accesses[i] >> 8) & 0xff);
+        chunks |= 1UL << (idx / 32);  // which 32-byte chunk within in a
+                                      // 128-byte chunk does this access?
+        set_byte_range(bytes, idx, data_size_coales);
+      }
+      info.chunks = mem_access_sector_mask_t(chunks);
+      info.bytes = (mem_access_byte_mask_t(bytes[1]) << 64) |
+                   mem_access_byte_mask_t(bytes[0]);
 
-    // step 2: reduce each transaction size, if possible
-    std::map<new_addr_type, transaction_info>::iterator t;
-    for (t = subwarp_transactions.begin(); t != subwarp_transactions.end();
-         t++) {
-      new_addr_type addr = t->first;
-      const transaction_info &info = t->second;
-
-      memory_coalescing_arch_reduce_and_send(is_write, access_type, info, addr,
-                                             segment_size);
+      memory_coalescing_arch_reduce_and_send(is_write, access_type, info,
+                                             block_address, segment_size);
     }
   }
 }
@@ -664,6 +631,56 @@ void warp_inst_t::memory_coalescing_arch_atomic(bool is_write,
   }
 }
 
+// number of cycles the shared memory banks need to serve the accesses of
+// threads [first_thread, end_thread), each spanning banks_per_access
+// consecutive banks
+unsigned warp_inst_t::shmem_bank_accesses(unsigned first_thread,
+                                          unsigned end_thread,
+                                          unsigned banks_per_access) const {
+  // step 1: compute accesses to words in banks, as (bank, word address)
+  std::pair<unsigned, new_addr_type>
+      bank_accs[MAX_WARP_SIZE * MAX_SHMEM_BANKS_PER_ACCESS];
+  unsigned n = 0;
+  for (unsigned thread = first_thread; thread < end_thread; thread++) {
+    if (!active(thread)) continue;
+    new_addr_type addr = m_per_scalar_thread[thread].memreqaddr[0];
+    // FIXME: deferred allocation of shared memory should not accumulate
+    // across kernel launches assert( addr < m_config->gpgpu_shmem_size );
+    new_addr_type word = addr / m_config->shmem_bank_width;
+    for (unsigned b = 0; b < banks_per_access; b++, word++)
+      bank_accs[n++] = std::make_pair(
+          (unsigned)(word % m_config->num_shmem_bank), word);
+  }
+  if (n == 0) return 0;
+  std::sort(bank_accs, bank_accs + n);
+
+  // step 2: look for the bank with the maximum number of accesses. Without
+  // limited broadcast every distinct word is one access (multicast);
+  // otherwise only the first word read by several threads is broadcast
+  bool broadcast_detected = false;
+  unsigned max_bank_accesses = 0;
+  for (unsigned i = 0; i < n;) {
+    unsigned bank = bank_accs[i].first;
+    unsigned bank_accesses = 0;
+    while (i < n && bank_accs[i].first == bank) {
+      unsigned j = i;
+      while (j < n && bank_accs[j] == bank_accs[i]) j++;
+      unsigned count = j - i;
+      if (!m_config->shmem_limited_broadcast) {
+        bank_accesses++;
+      } else if (count > 1 && !broadcast_detected) {
+        broadcast_detected = true;
+        bank_accesses++;
+      } else {
+        bank_accesses += count;
+      }
+      i = j;
+    }
+    max_bank_accesses = std::max(max_bank_accesses, bank_accesses);
+  }
+  return max_bank_accesses;
+}
+
 void warp_inst_t::memory_coalescing_arch_reduce_and_send(
     bool is_write, mem_access_type access_type, const transaction_info &info,
     new_addr_type addr, unsigned segment_size) {
@@ -1008,12 +1025,13 @@ void simt_stack::print_checkpoint(FILE *fout) const {
   }
 }
 
-void simt_stack::update(simt_mask_t &thread_done, addr_vector_t &next_pc,
-                        address_type recvg_pc, op_type next_inst_op,
-                        unsigned next_inst_size, address_type next_inst_pc) {
+void simt_stack::update(simt_mask_t &thread_done,
+                        const addr_vector_t &next_pc, address_type recvg_pc,
+                        op_type next_inst_op, unsigned next_inst_size,
+                        address_type next_inst_pc, bool warp_sync) {
   assert(m_stack.size() > 0);
 
-  assert(next_pc.size() == m_warp_size);
+  assert(m_warp_size <= MAX_WARP_SIZE);
 
   simt_mask_t top_active_mask = m_stack.back().m_active_mask;
   address_type top_recvg_pc = m_stack.back().m_recvg_pc;
@@ -1028,7 +1046,9 @@ void simt_stack::update(simt_mask_t &thread_done, addr_vector_t &next_pc,
   address_type new_recvg_pc = null_pc;
   unsigned num_divergent_paths = 0;
 
-  std::map<address_type, simt_mask_t> divergent_paths;
+  // at most two paths are valid, see below; the rest only trip the assert
+  address_type path_pc[MAX_WARP_SIZE];
+  simt_mask_t path_mask[MAX_WARP_SIZE];
   while (top_active_mask.any()) {
     // extract a group of threads with the same next PC among the active threads
     // in the warp
@@ -1054,28 +1074,23 @@ void simt_stack::update(simt_mask_t &thread_done, addr_vector_t &next_pc,
       continue;
     }
 
-    divergent_paths[tmp_next_pc] = tmp_active_mask;
+    path_pc[num_divergent_paths] = tmp_next_pc;
+    path_mask[num_divergent_paths] = tmp_active_mask;
     num_divergent_paths++;
   }
 
   address_type not_taken_pc = next_inst_pc + next_inst_size;
   assert(num_divergent_paths <= 2);
+  // the not taken path goes first, then paths in pc order
+  if (num_divergent_paths == 2 &&
+      (path_pc[1] == not_taken_pc ||
+       (path_pc[0] != not_taken_pc && path_pc[1] < path_pc[0]))) {
+    std::swap(path_pc[0], path_pc[1]);
+    std::swap(path_mask[0], path_mask[1]);
+  }
   for (unsigned i = 0; i < num_divergent_paths; i++) {
-    address_type tmp_next_pc = null_pc;
-    simt_mask_t tmp_active_mask;
-    tmp_active_mask.reset();
-    if (divergent_paths.find(not_taken_pc) != divergent_paths.end()) {
-      assert(i == 0);
-      tmp_next_pc = not_taken_pc;
-      tmp_active_mask = divergent_paths[tmp_next_pc];
-      divergent_paths.erase(tmp_next_pc);
-    } else {
-      std::map<address_type, simt_mask_t>::iterator it =
-          divergent_paths.begin();
-      tmp_next_pc = it->first;
-      tmp_active_mask = divergent_paths[tmp_next_pc];
-      divergent_paths.erase(tmp_next_pc);
-    }
+    address_type tmp_next_pc = path_pc[i];
+    simt_mask_t tmp_active_mask = path_mask[i];
 
     // HANDLE THE SPECIAL CASES FIRST
     if (next_inst_op == CALL_OPS) {
@@ -1153,6 +1168,243 @@ void simt_stack::update(simt_mask_t &thread_done, addr_vector_t &next_pc,
   }
 }
 
+its_simt_stack::its_simt_stack(unsigned wid, unsigned warpSize,
+                               class gpgpu_sim *gpu)
+    : simt_stack(wid, warpSize, gpu) {
+  m_barriers.reserve(warpSize);
+  reset();
+}
+
+void its_simt_stack::reset() {
+  m_live.reset();
+  m_waiting.reset();
+  m_active.reset();
+  m_active_pc = (address_type)-1;
+  m_barriers.clear();
+}
+
+void its_simt_stack::launch(address_type start_pc,
+                            const simt_mask_t &active_mask) {
+  reset();
+  for (unsigned i = 0; i < m_warp_size; i++) m_pc[i] = start_pc;
+  m_live = active_mask;
+  m_active = active_mask;
+  m_active_pc = start_pc;
+}
+
+void its_simt_stack::resume(char *fname) {
+  printf(
+      "GPGPU-Sim uArch: checkpoint resume is not supported with independent "
+      "thread scheduling\n");
+  abort();
+}
+
+void its_simt_stack::print_checkpoint(FILE *fout) const {
+  printf(
+      "GPGPU-Sim uArch: checkpointing is not supported with independent "
+      "thread scheduling\n");
+  abort();
+}
+
+const simt_mask_t &its_simt_stack::get_active_mask() const {
+  return m_active;
+}
+
+void its_simt_stack::get_pdom_stack_top_info(unsigned *pc,
+                                             unsigned *rpc) const {
+  *pc = m_active_pc;
+  *rpc = get_rp();
+}
+
+// the barrier the selected split converges at next
+unsigned its_simt_stack::get_rp() const {
+  for (unsigned i = 0; i < m_warp_size; i++) {
+    if (!m_active.test(i)) continue;
+    int b = innermost_barrier(i);
+    return (b < 0) ? (address_type)-1 : m_barriers[b].m_pc;
+  }
+  return (address_type)-1;
+}
+
+void its_simt_stack::print(FILE *fout) const {
+  fprintf(fout, "w%02d   ", m_warp_id);
+  for (unsigned j = 0; j < m_warp_size; j++)
+    fprintf(fout, "%c", (m_active.test(j) ? '1' : '0'));
+  fprintf(fout, " pc: 0x%03x waiting: ", m_active_pc);
+  for (unsigned j = 0; j < m_warp_size; j++)
+    fprintf(fout, "%c", (m_waiting.test(j) ? '1' : '0'));
+  fprintf(fout, " ");
+  if (m_active.any())
+    m_gpu->gpgpu_ctx->func_sim->ptx_print_insn(m_active_pc, fout);
+  fprintf(fout, "\n");
+  for (unsigned b = 0; b < m_barriers.size(); b++) {
+    const convergence_barrier &bar = m_barriers[b];
+    fprintf(fout, "    %1u ", b);
+    for (unsigned j = 0; j < m_warp_size; j++)
+      fprintf(fout, "%c", (bar.m_arrived.test(j)
+                               ? 'A'
+                               : (bar.m_members.test(j) ? '1' : '0')));
+    fprintf(fout, " rp: %4u tp: %s\n", bar.m_pc, bar.m_warp_sync ? "W" : "C");
+  }
+}
+
+int its_simt_stack::innermost_barrier(unsigned lane) const {
+  for (int b = (int)m_barriers.size() - 1; b >= 0; b--)
+    if (m_barriers[b].m_members.test(lane)) return b;
+  return -1;
+}
+
+// A thread at the pc of one of its barriers waits there. Reaching an outer
+// barrier (e.g. breaking out of a loop) also takes it out of the barriers
+// nested inside.
+void its_simt_stack::arrive(unsigned lane) {
+  for (int b = (int)m_barriers.size() - 1; b >= 0; b--) {
+    convergence_barrier &bar = m_barriers[b];
+    if (!bar.m_members.test(lane) || bar.m_pc != m_pc[lane]) continue;
+    bar.m_arrived.set(lane);
+    m_waiting.set(lane);
+    for (unsigned inner = b + 1; inner < m_barriers.size(); inner++)
+      m_barriers[inner].m_members.reset(lane);
+    return;
+  }
+}
+
+// Releases every barrier whose live members have all arrived. The released
+// threads may then be waiting at an enclosing barrier with the same pc.
+void its_simt_stack::release_barriers() {
+  bool released = true;
+  while (released) {
+    released = false;
+    for (int b = (int)m_barriers.size() - 1; b >= 0; b--) {
+      const convergence_barrier &bar = m_barriers[b];
+      if ((bar.m_members & m_live & ~bar.m_arrived).any()) continue;
+      simt_mask_t arrived = bar.m_arrived;
+      m_barriers.erase(m_barriers.begin() + b);
+      m_waiting &= ~arrived;
+      for (unsigned i = 0; i < m_warp_size; i++)
+        if (arrived.test(i) && m_live.test(i)) arrive(i);
+      released = true;
+      break;
+    }
+  }
+}
+
+void its_simt_stack::select_split(const simt_mask_t &executed,
+                                  address_type fallthrough_pc,
+                                  address_type branch_pc) {
+  const address_type null_pc = -1;
+  simt_mask_t ready = m_live & ~m_waiting;
+  while (ready.none() && m_live.any()) {
+    // every live thread waits, on barriers whose members cannot all arrive.
+    // If each of them waits at a bar.warp.sync (e.g. __syncwarp() on both
+    // sides of a branch) the warp has synchronized: release all of those.
+    // Otherwise release the innermost barrier.
+    simt_mask_t at_warp_sync;
+    for (unsigned b = 0; b < m_barriers.size(); b++)
+      if (m_barriers[b].m_warp_sync) at_warp_sync |= m_barriers[b].m_arrived;
+    if ((m_live & ~at_warp_sync).none()) {
+      for (int b = (int)m_barriers.size() - 1; b >= 0; b--) {
+        if (!m_barriers[b].m_warp_sync) continue;
+        m_waiting &= ~m_barriers[b].m_arrived;
+        m_barriers.erase(m_barriers.begin() + b);
+      }
+    } else {
+      int b = (int)m_barriers.size() - 1;
+      while (b >= 0 && m_barriers[b].m_arrived.none()) b--;
+      assert(b >= 0);
+      m_waiting &= ~m_barriers[b].m_arrived;
+      m_barriers.erase(m_barriers.begin() + b);
+    }
+    ready = m_live & ~m_waiting;
+  }
+
+  // keep issuing the split just executed, taken path first
+  address_type pc = null_pc;
+  bool any_ready_executed = false;
+  for (unsigned i = 0; i < m_warp_size; i++) {
+    if (!executed.test(i) || !ready.test(i)) continue;
+    any_ready_executed = true;
+    if (m_pc[i] != fallthrough_pc && (pc == null_pc || m_pc[i] < pc))
+      pc = m_pc[i];
+  }
+  if (pc == null_pc && any_ready_executed) pc = fallthrough_pc;
+
+  // otherwise, or when yielding at a backward branch, the lowest other pc
+  bool other_ready = false;
+  address_type other_pc = null_pc;
+  for (unsigned i = 0; i < m_warp_size; i++) {
+    if (!ready.test(i) || m_pc[i] == pc) continue;
+    other_ready = true;
+    if (other_pc == null_pc || m_pc[i] < other_pc) other_pc = m_pc[i];
+  }
+  if (pc == null_pc || (pc <= branch_pc && other_ready)) pc = other_pc;
+
+  m_active.reset();
+  m_active_pc = pc;
+  for (unsigned i = 0; i < m_warp_size; i++)
+    if (ready.test(i) && m_pc[i] == pc) m_active.set(i);
+}
+
+void its_simt_stack::update(simt_mask_t &thread_done,
+                            const addr_vector_t &next_pc,
+                            address_type recvg_pc, op_type next_inst_op,
+                            unsigned next_inst_size, address_type next_inst_pc,
+                            bool warp_sync) {
+  assert(m_active.any());
+  assert(m_active_pc == next_inst_pc);
+
+  const address_type null_pc = -1;
+  m_live &= ~thread_done;
+  m_waiting &= m_live;
+  simt_mask_t executed = m_active & m_live;
+  int first_lane = -1;
+  bool diverged = false;
+  for (unsigned i = 0; i < m_warp_size; i++) {
+    if (!m_live.test(i)) continue;
+    m_pc[i] = next_pc[i];
+    if (!executed.test(i)) continue;
+    if (first_lane < 0)
+      first_lane = i;
+    else if (m_pc[i] != m_pc[first_lane])
+      diverged = true;
+  }
+
+  if (diverged) {
+    // converge at the immediate post-dominator, unless the split already
+    // waits for one there (a loop exit branch diverging again)
+    int b = innermost_barrier(first_lane);
+    if (recvg_pc != null_pc && (b < 0 || m_barriers[b].m_pc != recvg_pc ||
+                                m_barriers[b].m_warp_sync)) {
+      convergence_barrier bar;
+      bar.m_pc = recvg_pc;
+      bar.m_members = executed;
+      bar.m_warp_sync = false;
+      m_barriers.push_back(bar);
+    }
+    m_gpu->gpgpu_ctx->stats->ptx_file_line_stats_add_warp_divergence(
+        next_inst_pc, 1);
+  }
+
+  if (warp_sync && executed.any() && (m_live & ~executed).any()) {
+    address_type sync_pc = next_inst_pc + next_inst_size;
+    bool found = false;
+    for (unsigned b = 0; b < m_barriers.size() && !found; b++)
+      found = m_barriers[b].m_warp_sync && m_barriers[b].m_pc == sync_pc;
+    if (!found) {
+      convergence_barrier bar;
+      bar.m_pc = sync_pc;
+      bar.m_members = m_live;
+      bar.m_warp_sync = true;
+      m_barriers.push_back(bar);
+    }
+  }
+
+  for (unsigned i = 0; i < m_warp_size; i++)
+    if (executed.test(i)) arrive(i);
+  release_barriers();
+  select_split(executed, next_inst_pc + next_inst_size, next_inst_pc);
+}
+
 void core_t::execute_warp_inst_t(warp_inst_t &inst, unsigned warpId) {
   for (unsigned t = 0; t < m_warp_size; t++) {
     if (inst.active(t)) {
@@ -1178,15 +1430,15 @@ void core_t::updateSIMTStack(unsigned warpId, warp_inst_t *inst) {
   for (unsigned i = 0; i < m_warp_size; i++) {
     if (ptx_thread_done(wtid + i)) {
       thread_done.set(i);
-      next_pc.push_back((address_type)-1);
     } else {
       if (inst->reconvergence_pc == RECONVERGE_RETURN_PC)
         inst->reconvergence_pc = get_return_pc(m_thread[wtid + i]);
-      next_pc.push_back(m_thread[wtid + i]->get_pc());
+      next_pc[i] = m_thread[wtid + i]->get_pc();
     }
   }
   m_simt_stack[warpId]->update(thread_done, next_pc, inst->reconvergence_pc,
-                               inst->op, inst->isize, inst->pc);
+                               inst->op, inst->isize, inst->pc,
+                               inst->bar_type == WARP_SYNC);
 }
 
 //! Get the warp to be executed using the data taken form the SIMT stack
@@ -1208,8 +1460,12 @@ void core_t::deleteSIMTStack() {
 
 void core_t::initilizeSIMTStack(unsigned warp_count, unsigned warp_size) {
   m_simt_stack = new simt_stack *[warp_count];
-  for (unsigned i = 0; i < warp_count; ++i)
-    m_simt_stack[i] = new simt_stack(i, warp_size, m_gpu);
+  for (unsigned i = 0; i < warp_count; ++i) {
+    if (m_gpu->simd_model() == INDEPENDENT_THREAD_SCHEDULING)
+      m_simt_stack[i] = new its_simt_stack(i, warp_size, m_gpu);
+    else
+      m_simt_stack[i] = new simt_stack(i, warp_size, m_gpu);
+  }
   m_warp_size = warp_size;
   m_warp_count = warp_count;
 }
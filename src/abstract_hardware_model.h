@@ -101,7 +101,7 @@ enum uarch_op_t {
 };
 typedef enum uarch_op_t op_type;
 
-enum uarch_bar_t { NOT_BAR = -1, SYNC = 1, ARRIVE, RED };
+enum uarch_bar_t { NOT_BAR = -1, SYNC = 1, ARRIVE, RED, WARP_SYNC };
 typedef enum uarch_bar_t barrier_type;
 
 enum uarch_red_t { NOT_RED = -1, POPC_RED = 1, AND_RED, OR_RED };
@@ -349,7 +349,9 @@ class core_config {
     gpgpu_ctx = ctx;
     m_valid = false;
     num_shmem_bank = 16;
+    shmem_bank_width = WORD_SIZE;
     shmem_limited_broadcast = false;
+    shmem_wide_access_phases = false;
     gpgpu_shmem_sizeDefault = (unsigned)-1;
     gpgpu_shmem_sizePrefL1 = (unsigned)-1;
     gpgpu_shmem_sizePrefShared = (unsigned)-1;
@@ -368,8 +370,12 @@ class core_config {
   bool shmem_limited_broadcast;
   static const address_type WORD_SIZE = 4;
   unsigned num_shmem_bank;
+  unsigned shmem_bank_width;  // bytes each bank delivers per cycle
+  // serve accesses wider than a bank (64/128-bit, vector) in phases of as
+  // many threads as the banks deliver per cycle, each spanning several banks
+  bool shmem_wide_access_phases;
   unsigned shmem_bank_func(address_type addr) const {
-    return ((addr / WORD_SIZE) % num_shmem_bank);
+    return ((addr / shmem_bank_width) % num_shmem_bank);
   }
   unsigned mem_warp_parts;
   mutable unsigned gpgpu_shmem_size;
@@ -395,24 +401,29 @@ const unsigned MAX_WARP_SIZE = 32;
 typedef std::bitset<MAX_WARP_SIZE> active_mask_t;
 #define MAX_WARP_SIZE_SIMT_STACK MAX_WARP_SIZE
 typedef std::bitset<MAX_WARP_SIZE_SIMT_STACK> simt_mask_t;
-typedef std::vector<address_type> addr_vector_t;
+// next pc of each lane of a warp, indexed by lane
+typedef address_type addr_vector_t[MAX_WARP_SIZE];
 
 class simt_stack {
  public:
   simt_stack(unsigned wid, unsigned warpSize, class gpgpu_sim *gpu);
-
-  void reset();
-  void launch(address_type start_pc, const simt_mask_t &active_mask);
-  void update(simt_mask_t &thread_done, addr_vector_t &next_pc,
-              address_type recvg_pc, op_type next_inst_op,
-              unsigned next_inst_size, address_type next_inst_pc);
-
-  const simt_mask_t &get_active_mask() const;
-  void get_pdom_stack_top_info(unsigned *pc, unsigned *rpc) const;
-  unsigned get_rp() const;
-  void print(FILE *fp) const;
-  void resume(char *fname);
-  void print_checkpoint(FILE *fout) const;
+  virtual ~simt_stack() {}
+
+  virtual void reset();
+  virtual void launch(address_type start_pc, const simt_mask_t &active_mask);
+  // next_pc is only read for lanes not set in thread_done; warp_sync is set
+  // when the instruction just executed was a bar.warp.sync
+  virtual void update(simt_mask_t &thread_done, const addr_vector_t &next_pc,
+                      address_type recvg_pc, op_type next_inst_op,
+                      unsigned next_inst_size, address_type next_inst_pc,
+                      bool warp_sync);
+
+  virtual const simt_mask_t &get_active_mask() const;
+  virtual void get_pdom_stack_top_info(unsigned *pc, unsigned *rpc) const;
+  virtual unsigned get_rp() const;
+  virtual void print(FILE *fp) const;
+  virtual void resume(char *fname);
+  virtual void print_checkpoint(FILE *fout) const;
 
  protected:
   unsigned m_warp_id;
@@ -436,11 +447,108 @@ class simt_stack {
           m_type(STACK_ENTRY_TYPE_NORMAL){};
   };
 
-  std::deque<simt_stack_entry> m_stack;
+  // Stack of entries kept inline up to INLINE_DEPTH levels of nesting, which
+  // covers all but pathological kernels; deeper entries spill to a vector
+  // that keeps its capacity across reset(), so a warp's branches never touch
+  // the heap once it has reached its maximum depth.
+  class entry_stack {
+   public:
+    entry_stack() : m_size(0) {}
+
+    unsigned size() const { return m_size; }
+    void clear() {
+      m_size = 0;
+      m_overflow.clear();
+    }
+    simt_stack_entry &operator[](unsigned i) {
+      return i < INLINE_DEPTH ? m_inline[i] : m_overflow[i - INLINE_DEPTH];
+    }
+    const simt_stack_entry &operator[](unsigned i) const {
+      return i < INLINE_DEPTH ? m_inline[i] : m_overflow[i - INLINE_DEPTH];
+    }
+    simt_stack_entry &back() { return (*this)[m_size - 1]; }
+    const simt_stack_entry &back() const { return (*this)[m_size - 1]; }
+    void push_back(const simt_stack_entry &entry) {
+      if (m_size < INLINE_DEPTH)
+        m_inline[m_size] = entry;
+      else
+        m_overflow.push_back(entry);
+      m_size++;
+    }
+    void pop_back() {
+      assert(m_size > 0);
+      m_size--;
+      if (m_size >= INLINE_DEPTH) m_overflow.pop_back();
+    }
+
+   private:
+    static const unsigned INLINE_DEPTH = 16;
+    unsigned m_size;
+    simt_stack_entry m_inline[INLINE_DEPTH];
+    std::vector<simt_stack_entry> m_overflow;
+  };
+
+  entry_stack m_stack;
 
   class gpgpu_sim *m_gpu;
 };
 
+// Independent thread scheduling (-gpgpu_simd_model 2), in place of the PDOM
+// stack. Every thread keeps its own pc (read back from its ptx_thread_info
+// after each instruction) and the warp issues one split at a time: the
+// threads that are not waiting and share the selected pc. When a split
+// diverges at a branch, its threads join a convergence barrier at the
+// branch's immediate post-dominator, as BSSY/BSYNC do on Volta. A thread
+// reaching a barrier pc waits there until every other member has reached it
+// or exited. bar.warp.sync is a barrier for all live threads of the warp (the
+// member mask is assumed to be the full warp).
+//
+// The split just executed keeps issuing (taken path first after a divergent
+// branch, as with the PDOM stack) until it waits or exits; then the live
+// split with the lowest pc is selected. A split also yields at a backward
+// branch whenever another split can run, so a thread spinning on a flag set
+// by another thread of its warp does not starve it.
+class its_simt_stack : public simt_stack {
+ public:
+  its_simt_stack(unsigned wid, unsigned warpSize, class gpgpu_sim *gpu);
+
+  virtual void reset();
+  virtual void launch(address_type start_pc, const simt_mask_t &active_mask);
+  virtual void update(simt_mask_t &thread_done, const addr_vector_t &next_pc,
+                      address_type recvg_pc, op_type next_inst_op,
+                      unsigned next_inst_size, address_type next_inst_pc,
+                      bool warp_sync);
+
+  virtual const simt_mask_t &get_active_mask() const;
+  virtual void get_pdom_stack_top_info(unsigned *pc, unsigned *rpc) const;
+  virtual unsigned get_rp() const;
+  virtual void print(FILE *fp) const;
+  virtual void resume(char *fname);
+  virtual void print_checkpoint(FILE *fout) const;
+
+ private:
+  struct convergence_barrier {
+    address_type m_pc;
+    simt_mask_t m_members;
+    simt_mask_t m_arrived;
+    bool m_warp_sync;
+  };
+
+  int innermost_barrier(unsigned lane) const;
+  void arrive(unsigned lane);
+  void release_barriers();
+  void select_split(const simt_mask_t &executed, address_type fallthrough_pc,
+                    address_type branch_pc);
+
+  address_type m_pc[MAX_WARP_SIZE];  // next pc of each live thread
+  simt_mask_t m_live;     // threads that have not exited
+  simt_mask_t m_waiting;  // threads arrived at a barrier not yet released
+  simt_mask_t m_active;   // the split issued next
+  address_type m_active_pc;
+  // innermost (most recently created) barrier last
+  std::vector<convergence_barrier> m_barriers;
+};
+
 // Let's just upgrade to C++11 so we can use constexpr here...
 // start allocating from this address (lower values used for allocating globals
 // in .ptx file)
@@ -733,7 +841,9 @@ typedef std::bitset<SECTOR_CHUNCK_SIZE> mem_access_sector_mask_t;
       MA_TUP(TEXTURE_ACC_R), MA_TUP(GLOBAL_ACC_W), MA_TUP(LOCAL_ACC_W), \
       MA_TUP(L1_WRBK_ACC), MA_TUP(L2_WRBK_ACC), MA_TUP(INST_ACC_R),     \
       MA_TUP(L1_WR_ALLOC_R), MA_TUP(L2_WR_ALLOC_R),                     \
-      MA_TUP(NUM_MEM_ACCESS_TYPE) MA_TUP_END(mem_access_type)
+      MA_TUP(L1_PREFETCH_ACC), MA_TUP(L2_PREFETCH_ACC),                 \
+      MA_TUP(NUM_MEM_ACCESS_TYPE)                                       \
+          MA_TUP_END(mem_access_type)
 
 #define MA_TUP_BEGIN(X) enum X {
 #define MA_TUP(X) X
@@ -833,6 +943,12 @@ class mem_access_t {
       case L1_WRBK_ACC:
         fprintf(fp, "L1_WRBK ");
         break;
+      case L1_PREFETCH_ACC:
+        fprintf(fp, "L1_PREF ");
+        break;
+      case L2_PREFETCH_ACC:
+        fprintf(fp, "L2_PREF ");
+        break;
       default:
         fprintf(fp, "unknown ");
         break;
@@ -861,7 +977,8 @@ class mem_fetch;
 
 class mem_fetch_interface {
  public:
-  virtual bool full(unsigned size, bool write) const = 0;
+  // kernel_id lets the interconnect check the issuing kernel's QoS quota
+  virtual bool full(unsigned size, bool write, unsigned kernel_id) const = 0;
   virtual void push(mem_fetch *mf) = 0;
 };
 
@@ -916,6 +1033,7 @@ class inst_t {
     cache_op = CACHE_UNDEFINED;
     latency = 1;
     initiation_interval = 1;
+    vector_width = 1;
     for (unsigned i = 0; i < MAX_REG_OPERANDS; i++) {
       arch_reg.src[i] = -1;
       arch_reg.dst[i] = -1;
@@ -983,6 +1101,7 @@ class inst_t {
   unsigned initiation_interval;
 
   unsigned data_size;  // what is the size of the word being operated on?
+  unsigned vector_width;  // data_size words moved per thread (ld/st .v2/.v4)
   memory_space_t space;
   cache_operator_type cache_op;
 
@@ -991,9 +1110,14 @@ class inst_t {
   virtual void pre_decode() {}
 };
 
-enum divergence_support_t { POST_DOMINATOR = 1, NUM_SIMD_MODEL };
+enum divergence_support_t {
+  POST_DOMINATOR = 1,
+  INDEPENDENT_THREAD_SCHEDULING,
+  NUM_SIMD_MODEL
+};
 
 const unsigned MAX_ACCESSES_PER_INSN_PER_THREAD = 8;
+const unsigned MAX_SHMEM_BANKS_PER_ACCESS = 8;
 
 class warp_inst_t : public inst_t {
  public:
@@ -1014,6 +1138,8 @@ class warp_inst_t : public inst_t {
     m_cache_hit = false;
     m_is_printf = false;
     m_is_cdp = 0;
+    m_shmem_conflict_degree = 0;
+    m_shmem_phases = 0;
   }
   virtual ~warp_inst_t() {}
 
@@ -1051,7 +1177,7 @@ class warp_inst_t : public inst_t {
       return;
     else {
       printf("Printing mem access generated\n");
-      std::list<mem_access_t>::iterator it;
+      std::vector<mem_access_t>::iterator it;
       for (it = m_accessq.begin(); it != m_accessq.end(); ++it) {
         printf("MEM_TXN_GEN:%s:%llx, Size:%d \n",
                mem_access_type_str(it->get_type()), it->get_addr(),
@@ -1080,6 +1206,8 @@ class warp_inst_t : public inst_t {
                                               const transaction_info &info,
                                               new_addr_type addr,
                                               unsigned segment_size);
+  unsigned shmem_bank_accesses(unsigned first_thread, unsigned end_thread,
+                               unsigned banks_per_access) const;
 
   void add_callback(unsigned lane_id,
                     void (*function)(const class inst_t *,
@@ -1133,6 +1261,10 @@ class warp_inst_t : public inst_t {
     assert(m_per_scalar_thread_valid);
     return m_per_scalar_thread[n].memreqaddr[0];
   }
+  new_addr_type get_addr(unsigned n, unsigned access) const {
+    assert(m_per_scalar_thread_valid);
+    return m_per_scalar_thread[n].memreqaddr[access];
+  }
 
   bool isatomic() const { return m_isatomic; }
 
@@ -1141,6 +1273,7 @@ class warp_inst_t : public inst_t {
   bool accessq_empty() const { return m_accessq.empty(); }
   unsigned accessq_count() const { return m_accessq.size(); }
   const mem_access_t &accessq_back() { return m_accessq.back(); }
+  const std::vector<mem_access_t> &get_accessq() const { return m_accessq; }
   void accessq_pop_back() { m_accessq.pop_back(); }
 
   bool dispatch_delay() {
@@ -1149,6 +1282,11 @@ class warp_inst_t : public inst_t {
   }
 
   bool has_dispatch_delay() { return cycles > 0; }
+  // cycles the shared memory banks need to serve this warp's access
+  unsigned shmem_conflict_degree() const { return m_shmem_conflict_degree; }
+  // of those, the cycles it takes without bank conflicts: one per phase
+  // (sub-warp, or group of threads of a wide access) with active threads
+  unsigned shmem_phases() const { return m_shmem_phases; }
 
   void print(FILE *fout) const;
   unsigned get_uid() const { return m_uid; }
@@ -1187,7 +1325,9 @@ class warp_inst_t : public inst_t {
   bool m_per_scalar_thread_valid;
   std::vector<per_thread_info> m_per_scalar_thread;
   bool m_mem_accesses_created;
-  std::list<mem_access_t> m_accessq;
+  std::vector<mem_access_t> m_accessq;
+  unsigned m_shmem_conflict_degree;
+  unsigned m_shmem_phases;
 
   unsigned m_scheduler_id;  // the scheduler that issues this inst
 
@@ -1324,6 +1464,10 @@ class register_set {
     warp_inst_t **free = get_free();
     move_warp(*free, src);
   }
+  void move_in(bool sub_core_model, unsigned reg_id, warp_inst_t *&src) {
+    warp_inst_t **free = get_free(sub_core_model, reg_id);
+    move_warp(*free, src);
+  }
   // void copy_in( warp_inst_t* src ){
   //   src->copy_contents_to(*get_free());
   //}
@@ -1331,6 +1475,10 @@ class register_set {
     warp_inst_t **ready = get_ready();
     move_warp(dest, *ready);
   }
+  void move_out_to(bool sub_core_model, unsigned reg_id, warp_inst_t *&dest) {
+    warp_inst_t **ready = get_ready(sub_core_model, reg_id);
+    move_warp(dest, *ready);
+  }
 
   warp_inst_t **get_ready() {
     warp_inst_t **ready;
@@ -1346,6 +1494,14 @@ class register_set {
     }
     return ready;
   }
+  warp_inst_t **get_ready(bool sub_core_model, unsigned reg_id) {
+    // in subcore model, each sched has a one specific reg to use (based on
+    // sched id)
+    if (!sub_core_model) return get_ready();
+
+    assert(reg_id < regs.size());
+    return regs[reg_id]->empty() ? NULL : &regs[reg_id];
+  }
 
   void print(FILE *fp) const {
     fprintf(fp, "%s : @%p\n", m_name, this);
@@ -84,6 +84,13 @@ void cuda_sim::ptx_opcocde_latency_options(option_parser_t opp) {
                          "Opcode latencies for Tensor instructions"
                          "Default 64",
                          "64");
+  option_parser_register(
+      opp, "-ptx_opcode_latency_tensor_acc", OPT_CSTR,
+      &opcode_latency_tensor_acc,
+      "Opcode latencies for wmma.mma.m16n16k16 by accumulator (C) type "
+      "<F16,F32>, 0 uses -ptx_opcode_latency_tesnor"
+      "Default 0,0",
+      "0,0");
   option_parser_register(
       opp, "-ptx_opcode_initiation_int", OPT_CSTR, &opcode_initiation_int,
       "Opcode initiation intervals for integers <ADD,MAX,MUL,MAD,DIV,SHFL>"
@@ -111,6 +118,13 @@ void cuda_sim::ptx_opcocde_latency_options(option_parser_t opp) {
                          "Opcode initiation intervals for tensor instructions"
                          "Default 64",
                          "64");
+  option_parser_register(
+      opp, "-ptx_opcode_initiation_tensor_acc", OPT_CSTR,
+      &opcode_initiation_tensor_acc,
+      "Opcode initiation intervals for wmma.mma.m16n16k16 by accumulator (C) "
+      "type <F16,F32>, 0 uses -ptx_opcode_initiation_tensor"
+      "Default 0,0",
+      "0,0");
   option_parser_register(opp, "-cdp_latency", OPT_CSTR, &cdp_latency_str,
                          "CDP API latency <cudaStreamCreateWithFlags, \
 cudaGetParameterBufferV2_init_perWarp, cudaGetParameterBufferV2_perKernel, \
@@ -678,6 +692,8 @@ void ptx_instruction::set_bar_type() {
     }
   } else if (m_opcode == SST_OP) {
     bar_type = SYNC;
+  } else if (m_opcode == NOP_OP && m_barrier_op == SYNC_OPTION) {
+    bar_type = WARP_SYNC;  // bar.warp.sync
   }
 }
 
@@ -687,11 +703,13 @@ void ptx_instruction::set_opcode_and_latency() {
   unsigned dp_latency[5];
   unsigned sfu_latency;
   unsigned tensor_latency;
+  unsigned tensor_acc_latency[2];
   unsigned int_init[6];
   unsigned fp_init[5];
   unsigned dp_init[5];
   unsigned sfu_init;
   unsigned tensor_init;
+  unsigned tensor_acc_init[2];
   /*
    * [0] ADD,SUB
    * [1] MAX,Min
@@ -711,6 +729,12 @@ void ptx_instruction::set_opcode_and_latency() {
          &dp_latency[4]);
   sscanf(gpgpu_ctx->func_sim->opcode_latency_sfu, "%u", &sfu_latency);
   sscanf(gpgpu_ctx->func_sim->opcode_latency_tensor, "%u", &tensor_latency);
+  /*
+   * [0] f16 C fragment
+   * [1] f32 C fragment
+   */
+  sscanf(gpgpu_ctx->func_sim->opcode_latency_tensor_acc, "%u,%u",
+         &tensor_acc_latency[0], &tensor_acc_latency[1]);
   sscanf(gpgpu_ctx->func_sim->opcode_initiation_int, "%u,%u,%u,%u,%u,%u",
          &int_init[0], &int_init[1], &int_init[2], &int_init[3], &int_init[4],
          &int_init[5]);
@@ -720,6 +744,8 @@ void ptx_instruction::set_opcode_and_latency() {
          &dp_init[0], &dp_init[1], &dp_init[2], &dp_init[3], &dp_init[4]);
   sscanf(gpgpu_ctx->func_sim->opcode_initiation_sfu, "%u", &sfu_init);
   sscanf(gpgpu_ctx->func_sim->opcode_initiation_tensor, "%u", &tensor_init);
+  sscanf(gpgpu_ctx->func_sim->opcode_initiation_tensor_acc, "%u,%u",
+         &tensor_acc_init[0], &tensor_acc_init[1]);
   sscanf(gpgpu_ctx->func_sim->cdp_latency_str, "%u,%u,%u,%u,%u",
          &gpgpu_ctx->func_sim->cdp_latency[0],
          &gpgpu_ctx->func_sim->cdp_latency[1],
@@ -939,6 +965,13 @@ void ptx_instruction::set_opcode_and_latency() {
     case MMA_OP:
       latency = tensor_latency;
       initiation_interval = tensor_init;
+      if (m_wmma_type == MMA) {
+        // keyed on the type of the C (accumulator input) fragment; mma_impl
+        // only implements m16n16k16
+        unsigned i = get_type2() == F32_TYPE ? 1 : 0;
+        if (tensor_acc_latency[i]) latency = tensor_acc_latency[i];
+        if (tensor_acc_init[i]) initiation_interval = tensor_acc_init[i];
+      }
       op = TENSOR_CORE_OP;
       break;
     case SHFL_OP:
@@ -1018,10 +1051,24 @@ void ptx_instruction::pre_decode() {
   space = m_space_spec;
   memory_op = no_memory_op;
   data_size = 0;
+  vector_width = 1;
   if (has_memory_read() || has_memory_write()) {
     unsigned to_type = get_type();
     data_size = datatype2size(to_type);
     memory_op = has_memory_read() ? memory_load : memory_store;
+    switch (get_vector()) {
+      case V2_TYPE:
+        vector_width = 2;
+        break;
+      case V3_TYPE:
+        vector_width = 3;
+        break;
+      case V4_TYPE:
+        vector_width = 4;
+        break;
+      default:
+        break;
+    }
   }
 
   bool has_dst = false;
@@ -1344,6 +1391,19 @@ unsigned function_info::get_args_aligned_size() {
   return m_args_aligned_size;
 }
 
+unsigned long long function_info::get_ptx_hash() {
+  if (m_ptx_hash) return m_ptx_hash;
+
+  unsigned long long h = fnv1a_hash(m_name.c_str(), m_name.size());
+  for (std::list<ptx_instruction *>::const_iterator i = m_instructions.begin();
+       i != m_instructions.end(); i++) {
+    std::string src = (*i)->get_source();
+    h = fnv1a_hash(src.c_str(), src.size() + 1, h);
+  }
+  m_ptx_hash = h ? h : 1;
+  return m_ptx_hash;
+}
+
 void function_info::finalize(memory_space *param_mem) {
   unsigned param_address = 0;
   for (std::map<unsigned, param_info>::iterator i =
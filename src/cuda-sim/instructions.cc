@@ -1851,6 +1851,19 @@ void mapping(int thread, int wmma_type, int wmma_layout, int type, int index,
   }
 }
 
+// The fragment layouts above and mma_impl are only worked out for 16x16x16
+// tiles; the other shapes would silently compute wrong results.
+static void check_wmma_shape(const ptx_instruction *pI) {
+  int shape = pI->get_wmma_configuration();
+  if (shape == M32N8K16 || shape == M8N32K16) {
+    printf(
+        "GPGPU-Sim PTX: ERROR ** wmma shape %s is not implemented, only "
+        "m16n16k16 is\n",
+        shape == M32N8K16 ? "m32n8k16" : "m8n32k16");
+    abort();
+  }
+}
+
 void mma_impl(const ptx_instruction *pI, core_t *core, warp_inst_t inst) {
   int i, j, k, thrd;
   int row, col, offset;
@@ -1861,6 +1874,7 @@ void mma_impl(const ptx_instruction *pI, core_t *core, warp_inst_t inst) {
   ptx_reg_t src_data;
   ptx_thread_info *thread;
 
+  check_wmma_shape(pI);
   unsigned a_layout = pI->get_wmma_layout(0);
   unsigned b_layout = pI->get_wmma_layout(1);
   unsigned type = pI->get_type();
@@ -2167,7 +2181,8 @@ void call_impl(const ptx_instruction *pI, ptx_thread_info *thread) {
 
   gpgpu_sim *gpu = thread->get_gpu();
   unsigned callee_pc = 0, callee_rpc = 0;
-  if (gpu->simd_model() == POST_DOMINATOR) {
+  if (gpu->simd_model() == POST_DOMINATOR ||
+      gpu->simd_model() == INDEPENDENT_THREAD_SCHEDULING) {
     thread->get_core()->get_pdom_stack_top_info(thread->get_hw_wid(),
                                                 &callee_pc, &callee_rpc);
     assert(callee_pc == thread->get_pc());
@@ -2194,7 +2209,8 @@ void callp_impl(const ptx_instruction *pI, ptx_thread_info *thread) {
 
   gpgpu_sim *gpu = thread->get_gpu();
   unsigned callee_pc = 0, callee_rpc = 0;
-  if (gpu->simd_model() == POST_DOMINATOR) {
+  if (gpu->simd_model() == POST_DOMINATOR ||
+      gpu->simd_model() == INDEPENDENT_THREAD_SCHEDULING) {
     thread->get_core()->get_pdom_stack_top_info(thread->get_hw_wid(),
                                                 &callee_pc, &callee_rpc);
     assert(callee_pc == thread->get_pc());
@@ -3386,6 +3402,7 @@ void mma_st_impl(const ptx_instruction *pI, core_t *core, warp_inst_t &inst) {
   unsigned wmma_layout = pI->get_wmma_layout(0);
   int stride;
 
+  check_wmma_shape(pI);
   if (core->get_gpu()->is_functional_sim())
     tid = inst.warp_id_func() * core->get_warp_size();
   else
@@ -3508,6 +3525,7 @@ void mma_ld_impl(const ptx_instruction *pI, core_t *core, warp_inst_t &inst) {
   int thrd, stride;
   ptx_thread_info *thread;
 
+  check_wmma_shape(pI);
   if (core->get_gpu()->is_functional_sim())
     tid = inst.warp_id_func() * core->get_warp_size();
   else
@@ -179,6 +179,19 @@ void memory_space_impl<BSIZE>::set_watch(addr_t addr, unsigned watchpoint) {
   m_watchpoints[watchpoint] = addr;
 }
 
+template <unsigned BSIZE>
+unsigned long long memory_space_impl<BSIZE>::hash() const {
+  // blocks are combined with a sum so the hash map's iteration order, which
+  // depends on allocation history, does not leak into the result
+  unsigned long long h = 0;
+  typename map_t::const_iterator i_page;
+  for (i_page = m_data.begin(); i_page != m_data.end(); ++i_page) {
+    mem_addr_t blk_idx = i_page->first;
+    h += i_page->second.hash(fnv1a_hash(&blk_idx, sizeof(blk_idx)));
+  }
+  return h;
+}
+
 template class memory_space_impl<32>;
 template class memory_space_impl<64>;
 template class memory_space_impl<8192>;
@@ -31,6 +31,7 @@
 
 #include "../abstract_hardware_model.h"
 
+#include "../gpgpu-sim/gpu-misc.h"
 #include "../tr1_hash_map.h"
 #define mem_map tr1_hash_map
 #if tr1_hash_map_ismap == 1
@@ -83,6 +84,10 @@ class mem_storage {
     fflush(fout);
   }
 
+  unsigned long long hash(unsigned long long seed) const {
+    return fnv1a_hash(m_data, BSIZE, seed);
+  }
+
  private:
   unsigned m_nbytes;
   unsigned char *m_data;
@@ -101,6 +106,8 @@ class memory_space {
   virtual void read(mem_addr_t addr, size_t length, void *data) const = 0;
   virtual void print(const char *format, FILE *fout) const = 0;
   virtual void set_watch(addr_t addr, unsigned watchpoint) = 0;
+  // content hash, independent of the order blocks were allocated in
+  virtual unsigned long long hash() const = 0;
 };
 
 template <unsigned BSIZE>
@@ -116,6 +123,7 @@ class memory_space_impl : public memory_space {
   virtual void print(const char *format, FILE *fout) const;
 
   virtual void set_watch(addr_t addr, unsigned watchpoint);
+  virtual unsigned long long hash() const;
 
  private:
   void read_single_block(mem_addr_t blk_idx, mem_addr_t addr, size_t length,
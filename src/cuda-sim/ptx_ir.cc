@@ -1227,6 +1227,8 @@ ptx_instruction::ptx_instruction(
   m_vector_spec = 0;
   m_atomic_spec = 0;
   m_membar_level = 0;
+  m_barrier_op = 0;
+  m_wmma_configuration = 0;
   m_inst_size = 8;  // bytes
   int rr = 0;
   std::list<int>::const_iterator i;
@@ -1249,6 +1251,7 @@ ptx_instruction::ptx_instruction(
       case M16N16K16:
       case M32N8K16:
       case M8N32K16:
+        m_wmma_configuration = last_ptx_inst_option;
         break;
       default:
         assert(0);
@@ -1494,6 +1497,7 @@ function_info::function_info(int entry_point, gpgpu_context *ctx) {
   m_kernel_info.smem = 0;
   m_local_mem_framesize = 0;
   m_args_aligned_size = -1;
+  m_ptx_hash = 0;
   pdom_done = false;  // initialize it to false
 }
 
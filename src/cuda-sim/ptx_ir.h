@@ -1038,6 +1038,7 @@ class ptx_instruction : public warp_inst_t {
   unsigned get_atomic() const { return m_atomic_spec; }
 
   int get_wmma_type() const { return m_wmma_type; }
+  int get_wmma_configuration() const { return m_wmma_configuration; }
   int get_wmma_layout(int index) const {
     return m_wmma_layout[index];  // 0->Matrix D,1->Matrix C
   }
@@ -1315,6 +1316,8 @@ class function_info {
   void remove_args() { m_args.clear(); }
   unsigned num_args() const { return m_args.size(); }
   unsigned get_args_aligned_size();
+  // hash of the kernel name and PTX source, computed once on first use
+  unsigned long long get_ptx_hash();
 
   const symbol *get_arg(unsigned n) const {
     assert(n < m_args.size());
@@ -1409,6 +1412,8 @@ class function_info {
   // parameter size for device kernels
   int m_args_aligned_size;
 
+  unsigned long long m_ptx_hash;
+
   addr_t m_n;  // offset in m_instr_mem (used in do_pdom)
 };
 
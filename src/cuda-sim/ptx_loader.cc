@@ -32,6 +32,8 @@
 #include <fstream>
 #include <sstream>
 #include "../../libcuda/gpgpu_context.h"
+#include "../gpgpu-sim/gpu-sim.h"
+#include "../gpgpu-sim/inst_trace.h"
 #include "cuda-sim.h"
 #include "ptx_ir.h"
 #include "ptx_parser.h"
@@ -174,6 +176,10 @@ symbol_table *gpgpu_context::gpgpu_ptx_sim_load_ptx_from_string(
     fprintf(fp, "%s", p);
     fclose(fp);
   }
+  // keep a copy for replaying an instruction trace without the application
+  gpgpu_sim *gpu = the_gpgpusim->g_the_gpu;
+  if (gpu && gpu->get_inst_trace_index())
+    gpu->get_inst_trace_index()->add_ptx(p);
   symbol_table *symtab = init_parser(buf);
   ptx_lex_init(&(ptx_parser->scanner));
   ptx__scan_string(p, ptx_parser->scanner);
@@ -203,6 +209,10 @@ symbol_table *gpgpu_context::gpgpu_ptx_sim_load_ptx_from_string(
 
 symbol_table *gpgpu_context::gpgpu_ptx_sim_load_ptx_from_filename(
     const char *filename) {
+  // keep a copy for replaying an instruction trace without the application
+  gpgpu_sim *gpu = the_gpgpusim->g_the_gpu;
+  if (gpu && gpu->get_inst_trace_index())
+    gpu->get_inst_trace_index()->add_ptx_file(filename);
   symbol_table *symtab = init_parser(filename);
   printf("GPGPU-Sim PTX: finished parsing EMBEDDED .ptx file %s\n", filename);
   return symtab;
@@ -29,15 +29,42 @@
 #include "addrdec.h"
 #include <string.h>
 #include "../option_parser.h"
-#include "gpu-sim.h"
 
 static long int powli(long int x, long int y);
 static unsigned int LOGB2_32(unsigned int v);
-static new_addr_type addrdec_packbits(new_addr_type mask, new_addr_type val,
-                                      unsigned char high, unsigned char low);
 static void addrdec_getmasklimit(new_addr_type mask, unsigned char *high,
                                  unsigned char *low);
 
+void addrdec_bit_extract::init(new_addr_type mask) {
+  m_mask = mask;
+  m_n_runs = 0;
+  unsigned pos = 0;
+  for (unsigned i = 0; i < 64;) {
+    if ((mask & (1ULL << i)) == 0) {
+      i++;
+      continue;
+    }
+    unsigned low = i;
+    while (i < 64 && (mask & (1ULL << i)) != 0) i++;
+    new_addr_type run = (i == 64) ? ~0ULL << low : ((1ULL << i) - (1ULL << low));
+    assert(m_n_runs < 32);
+    m_run_mask[m_n_runs] = run;
+    m_run_shift[m_n_runs] = low - pos;
+    m_n_runs++;
+    pos += i - low;
+  }
+}
+
+// splitmix64 finalizer: spreads every address bit over the whole result
+static inline unsigned long long addrdec_hash(unsigned long long x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
 linear_to_raw_address_translation::linear_to_raw_address_translation() {
   addrdec_option = NULL;
   ADDR_CHIP_S = 10;
@@ -73,34 +100,75 @@ void linear_to_raw_address_translation::addrdec_setoption(option_parser_t opp) {
 new_addr_type linear_to_raw_address_translation::partition_address(
     new_addr_type addr) const {
   if (!gap) {
-    return addrdec_packbits(~(addrdec_mask[CHIP] | sub_partition_id_mask), addr,
-                            64, 0);
+    return m_extract_partition(addr);
   } else {
     // see addrdec_tlx for explanation
     unsigned long long int partition_addr;
     partition_addr = ((addr >> ADDR_CHIP_S) / m_n_channel) << ADDR_CHIP_S;
     partition_addr |= addr & ((1 << ADDR_CHIP_S) - 1);
     // remove the part of address that constributes to the sub partition ID
-    partition_addr =
-        addrdec_packbits(~sub_partition_id_mask, partition_addr, 64, 0);
+    partition_addr = m_extract_no_sub_partition(partition_addr);
     return partition_addr;
   }
 }
 
+bool linear_to_raw_address_translation::raw_address(
+    new_addr_type partition_addr, unsigned sub_partition,
+    new_addr_type *addr) const {
+  if (memory_partition_indexing == RANDOM) return false;
+  unsigned chip = sub_partition / m_n_sub_partition_in_channel;
+  new_addr_type rest_of_addr =
+      m_extract_sub_partition.deposit(sub_partition %
+                                      m_n_sub_partition_in_channel);
+  rest_of_addr |= gap ? m_extract_no_sub_partition.deposit(partition_addr)
+                      : m_extract_partition.deposit(partition_addr);
+
+  // undo the chip indexing function; it only depends on row and bank bits,
+  // which are already in place
+  switch (memory_partition_indexing) {
+    case BITWISE_PERMUTATION:
+      chip ^= m_extract[ROW](rest_of_addr) & (m_n_channel - 1);
+      break;
+    case IPOLY:
+    case PAE:
+      chip ^= chip_hash(m_extract[ROW](rest_of_addr),
+                        m_extract[BK](rest_of_addr));
+      break;
+    default:
+      break;
+  }
+  if (chip >= m_n_channel) return false;
+
+  if (!gap) {
+    *addr = rest_of_addr | m_extract[CHIP].deposit(chip);
+  } else {
+    *addr = (((rest_of_addr >> ADDR_CHIP_S) * m_n_channel + chip)
+             << ADDR_CHIP_S) |
+            (rest_of_addr & ((1ULL << ADDR_CHIP_S) - 1));
+  }
+  return true;
+}
+
+unsigned linear_to_raw_address_translation::chip_hash(new_addr_type row,
+                                                     unsigned bk) const {
+  unsigned hash = 0;
+  for (unsigned i = 0; i < N_CHIP_HASH_BITS; i++) {
+    hash |= __builtin_parityll((row & m_chip_hash_row[i]) ^
+                               (bk & m_chip_hash_bk[i]))
+            << i;
+  }
+  return hash;
+}
+
 void linear_to_raw_address_translation::addrdec_tlx(new_addr_type addr,
                                                     addrdec_t *tlx) const {
   unsigned long long int addr_for_chip, rest_of_addr;
   if (!gap) {
-    tlx->chip = addrdec_packbits(addrdec_mask[CHIP], addr, addrdec_mkhigh[CHIP],
-                                 addrdec_mklow[CHIP]);
-    tlx->bk = addrdec_packbits(addrdec_mask[BK], addr, addrdec_mkhigh[BK],
-                               addrdec_mklow[BK]);
-    tlx->row = addrdec_packbits(addrdec_mask[ROW], addr, addrdec_mkhigh[ROW],
-                                addrdec_mklow[ROW]);
-    tlx->col = addrdec_packbits(addrdec_mask[COL], addr, addrdec_mkhigh[COL],
-                                addrdec_mklow[COL]);
-    tlx->burst = addrdec_packbits(addrdec_mask[BURST], addr,
-                                  addrdec_mkhigh[BURST], addrdec_mklow[BURST]);
+    tlx->chip = m_extract[CHIP](addr);
+    tlx->bk = m_extract[BK](addr);
+    tlx->row = m_extract[ROW](addr);
+    tlx->col = m_extract[COL](addr);
+    tlx->burst = m_extract[BURST](addr);
   } else {
     // Split the given address at ADDR_CHIP_S into (MSBs,LSBs)
     // - extract chip address using modulus of MSBs
@@ -111,14 +179,10 @@ void linear_to_raw_address_translation::addrdec_tlx(new_addr_type addr,
     rest_of_addr |= addr & ((1 << ADDR_CHIP_S) - 1);
 
     tlx->chip = addr_for_chip;
-    tlx->bk = addrdec_packbits(addrdec_mask[BK], rest_of_addr,
-                               addrdec_mkhigh[BK], addrdec_mklow[BK]);
-    tlx->row = addrdec_packbits(addrdec_mask[ROW], rest_of_addr,
-                                addrdec_mkhigh[ROW], addrdec_mklow[ROW]);
-    tlx->col = addrdec_packbits(addrdec_mask[COL], rest_of_addr,
-                                addrdec_mkhigh[COL], addrdec_mklow[COL]);
-    tlx->burst = addrdec_packbits(addrdec_mask[BURST], rest_of_addr,
-                                  addrdec_mkhigh[BURST], addrdec_mklow[BURST]);
+    tlx->bk = m_extract[BK](rest_of_addr);
+    tlx->row = m_extract[ROW](rest_of_addr);
+    tlx->col = m_extract[COL](rest_of_addr);
+    tlx->burst = m_extract[BURST](rest_of_addr);
   }
 
   switch (memory_partition_indexing) {
@@ -131,77 +195,26 @@ void linear_to_raw_address_translation::addrdec_tlx(new_addr_type addr,
       assert(tlx->chip < m_n_channel);
       break;
     }
-    case IPOLY: {
-      /*
-       * Set Indexing function from "Pseudo-randomly interleaved memory."
-       * Rau, B. R et al.
-       * ISCA 1991
-       *
-       * equations are adopted from:
-       * "Sacat: streaming-aware conflict-avoiding thrashing-resistant gpgpu
-       * cache management scheme." Khairy et al. IEEE TPDS 2017.
-       */
-      if (m_n_channel == 32) {
-        std::bitset<64> a(tlx->row);
-        std::bitset<5> chip(tlx->chip);
-        chip[0] = a[13] ^ a[12] ^ a[11] ^ a[10] ^ a[9] ^ a[6] ^ a[5] ^ a[3] ^
-                  a[0] ^ chip[0];
-        chip[1] = a[14] ^ a[13] ^ a[12] ^ a[11] ^ a[10] ^ a[7] ^ a[6] ^ a[4] ^
-                  a[1] ^ chip[1];
-        chip[2] = a[14] ^ a[10] ^ a[9] ^ a[8] ^ a[7] ^ a[6] ^ a[3] ^ a[2] ^
-                  a[0] ^ chip[2];
-        chip[3] =
-            a[11] ^ a[10] ^ a[9] ^ a[8] ^ a[7] ^ a[4] ^ a[3] ^ a[1] ^ chip[3];
-        chip[4] =
-            a[12] ^ a[11] ^ a[10] ^ a[9] ^ a[8] ^ a[5] ^ a[4] ^ a[2] ^ chip[4];
-        tlx->chip = chip.to_ulong();
-
-      } else { /* Else incorrect number of channels for the hashing function */
-        assert(
-            "\nGPGPU-Sim memory_partition_indexing error: The number of "
-            "channels should be "
-            "32 for the hashing IPOLY index function.\n" &&
-            0);
-      }
-      assert(tlx->chip < m_n_channel);
-      break;
-    }
+    case IPOLY:
     case PAE: {
-      // Page Address Entropy
-      // random selected bits from the page and bank bits
-      // similar to
-      // Liu, Yuxi, et al. "Get Out of the Valley: Power-Efficient Address
-      // Mapping for GPUs." ISCA 2018
-      std::bitset<64> a(tlx->row);
-      std::bitset<5> chip(tlx->chip);
-      std::bitset<4> b(tlx->bk);
-      chip[0] = a[13] ^ a[10] ^ a[9] ^ a[5] ^ a[0] ^ b[3] ^ b[0] ^ chip[0];
-      chip[1] = a[12] ^ a[11] ^ a[6] ^ a[1] ^ b[3] ^ b[2] ^ b[1] ^ chip[1];
-      chip[2] = a[14] ^ a[9] ^ a[8] ^ a[7] ^ a[2] ^ b[1] ^ chip[2];
-      chip[3] = a[11] ^ a[10] ^ a[8] ^ a[3] ^ b[2] ^ b[3] ^ chip[3];
-      chip[4] = a[12] ^ a[9] ^ a[8] ^ a[5] ^ a[4] ^ b[1] ^ b[0] ^ chip[4];
-      tlx->chip = chip.to_ulong();
+      // xor functions built by init_chip_hash(); they are defined for 32
+      // channels, so only the low 5 chip bits take part
+      tlx->chip = (tlx->chip & ((1 << N_CHIP_HASH_BITS) - 1)) ^
+                  chip_hash(tlx->row, tlx->bk);
       assert(tlx->chip < m_n_channel);
       break;
     }
     case RANDOM: {
-      // This is an unrealistic hashing using software hashtable
-      // we generate a random set for each memory address and save the value in
-      // a big hashtable for future reuse
+      // Unrealistic fully random interleaving: every chip-sized block of the
+      // address space goes to a pseudo-random sub partition. A hash of the
+      // block address keeps the mapping deterministic without remembering
+      // the blocks seen so far.
       new_addr_type chip_address = (addr >> ADDR_CHIP_S);
-      tr1_hash_map<new_addr_type, unsigned>::const_iterator got =
-          address_random_interleaving.find(chip_address);
-      if (got == address_random_interleaving.end()) {
-        unsigned new_chip_id =
-            rand() % (m_n_channel * m_n_sub_partition_in_channel);
-        address_random_interleaving[chip_address] = new_chip_id;
-        tlx->chip = new_chip_id / m_n_sub_partition_in_channel;
-        tlx->sub_partition = new_chip_id;
-      } else {
-        unsigned new_chip_id = got->second;
-        tlx->chip = new_chip_id / m_n_sub_partition_in_channel;
-        tlx->sub_partition = new_chip_id;
-      }
+      unsigned new_chip_id =
+          addrdec_hash(chip_address) %
+          (m_n_channel * m_n_sub_partition_in_channel);
+      tlx->chip = new_chip_id / m_n_sub_partition_in_channel;
+      tlx->sub_partition = new_chip_id;
 
       assert(tlx->chip < m_n_channel);
       assert(tlx->sub_partition < m_n_channel * m_n_sub_partition_in_channel);
@@ -479,11 +492,73 @@ void linear_to_raw_address_translation::init(
   }
   printf("sub_partition_id_mask = %016llx\n", sub_partition_id_mask);
 
+  for (i = 0; i < N_ADDRDEC; i++) m_extract[i].init(addrdec_mask[i]);
+  m_extract_partition.init(~(addrdec_mask[CHIP] | sub_partition_id_mask));
+  m_extract_no_sub_partition.init(~sub_partition_id_mask);
+  m_extract_sub_partition.init(sub_partition_id_mask);
+  init_chip_hash();
+
   if (run_test) {
     sweep_test();
   }
+}
+
+void linear_to_raw_address_translation::init_chip_hash() {
+  memset(m_chip_hash_row, 0, sizeof(m_chip_hash_row));
+  memset(m_chip_hash_bk, 0, sizeof(m_chip_hash_bk));
+  // row (r) and bank (b) bits xored into each chip bit, low chip bit first
+  static const unsigned char ipoly_row[N_CHIP_HASH_BITS][10] = {
+      {13, 12, 11, 10, 9, 6, 5, 3, 0, 0xff},
+      {14, 13, 12, 11, 10, 7, 6, 4, 1, 0xff},
+      {14, 10, 9, 8, 7, 6, 3, 2, 0, 0xff},
+      {11, 10, 9, 8, 7, 4, 3, 1, 0xff},
+      {12, 11, 10, 9, 8, 5, 4, 2, 0xff}};
+  static const unsigned char pae_row[N_CHIP_HASH_BITS][6] = {
+      {13, 10, 9, 5, 0, 0xff},
+      {12, 11, 6, 1, 0xff},
+      {14, 9, 8, 7, 2, 0xff},
+      {11, 10, 8, 3, 0xff},
+      {12, 9, 8, 5, 4, 0xff}};
+  static const unsigned char pae_bk[N_CHIP_HASH_BITS][4] = {
+      {3, 0, 0xff}, {3, 2, 1, 0xff}, {1, 0xff}, {2, 3, 0xff}, {1, 0, 0xff}};
 
-  if (memory_partition_indexing == RANDOM) srand(1);
+  switch (memory_partition_indexing) {
+    case IPOLY:
+      /*
+       * Set Indexing function from "Pseudo-randomly interleaved memory."
+       * Rau, B. R et al.
+       * ISCA 1991
+       *
+       * equations are adopted from:
+       * "Sacat: streaming-aware conflict-avoiding thrashing-resistant gpgpu
+       * cache management scheme." Khairy et al. IEEE TPDS 2017.
+       */
+      if (m_n_channel != 32) {
+        printf(
+            "\nGPGPU-Sim memory_partition_indexing error: The number of "
+            "channels should be 32 for the hashing IPOLY index function.\n");
+        abort();
+      }
+      for (unsigned c = 0; c < N_CHIP_HASH_BITS; c++)
+        for (unsigned j = 0; ipoly_row[c][j] != 0xff; j++)
+          m_chip_hash_row[c] |= 1ULL << ipoly_row[c][j];
+      break;
+    case PAE:
+      // Page Address Entropy
+      // random selected bits from the page and bank bits
+      // similar to
+      // Liu, Yuxi, et al. "Get Out of the Valley: Power-Efficient Address
+      // Mapping for GPUs." ISCA 2018
+      for (unsigned c = 0; c < N_CHIP_HASH_BITS; c++) {
+        for (unsigned j = 0; pae_row[c][j] != 0xff; j++)
+          m_chip_hash_row[c] |= 1ULL << pae_row[c][j];
+        for (unsigned j = 0; pae_bk[c][j] != 0xff; j++)
+          m_chip_hash_bk[c] |= 1U << pae_bk[c][j];
+      }
+      break;
+    default:
+      break;
+  }
 }
 
 #include "../tr1_hash_map.h"
@@ -596,19 +671,6 @@ static unsigned int LOGB2_32(unsigned int v) {
   return r;
 }
 
-static new_addr_type addrdec_packbits(new_addr_type mask, new_addr_type val,
-                                      unsigned char high, unsigned char low) {
-  unsigned pos = 0;
-  new_addr_type result = 0;
-  for (unsigned i = low; i < high; i++) {
-    if ((mask & ((unsigned long long int)1 << i)) != 0) {
-      result |= ((val & ((unsigned long long int)1 << i)) >> i) << pos;
-      pos++;
-    }
-  }
-  return result;
-}
-
 static void addrdec_getmasklimit(new_addr_type mask, unsigned char *high,
                                  unsigned char *low) {
   *high = 64;
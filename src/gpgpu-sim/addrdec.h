@@ -29,6 +29,9 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
 #include "../option_parser.h"
 
 #ifndef ADDRDEC_H
@@ -45,6 +48,45 @@ enum partition_index_function {
   CUSTOM
 };
 
+// Gathers the address bits selected by a mask into the low bits of the
+// result (PEXT), or scatters low bits back into the mask positions (PDEP).
+// Uses the BMI2 instructions when the simulator is built with -mbmi2;
+// otherwise the mask is split once into runs of contiguous bits and each run
+// is moved into place with one mask and shift.
+class addrdec_bit_extract {
+ public:
+  addrdec_bit_extract() : m_mask(0), m_n_runs(0) {}
+  void init(new_addr_type mask);
+
+  new_addr_type operator()(new_addr_type val) const {
+#ifdef __BMI2__
+    return _pext_u64(val, m_mask);
+#else
+    new_addr_type result = 0;
+    for (unsigned i = 0; i < m_n_runs; i++)
+      result |= (val & m_run_mask[i]) >> m_run_shift[i];
+    return result;
+#endif
+  }
+
+  new_addr_type deposit(new_addr_type val) const {
+#ifdef __BMI2__
+    return _pdep_u64(val, m_mask);
+#else
+    new_addr_type result = 0;
+    for (unsigned i = 0; i < m_n_runs; i++)
+      result |= (val << m_run_shift[i]) & m_run_mask[i];
+    return result;
+#endif
+  }
+
+ private:
+  new_addr_type m_mask;
+  unsigned m_n_runs;
+  new_addr_type m_run_mask[32];  // a 64-bit mask has at most 32 runs
+  unsigned char m_run_shift[32];
+};
+
 struct addrdec_t {
   void print(FILE *fp) const;
 
@@ -66,12 +108,21 @@ class linear_to_raw_address_translation {
   // accessors
   void addrdec_tlx(new_addr_type addr, addrdec_t *tlx) const;
   new_addr_type partition_address(new_addr_type addr) const;
+  // inverse of partition_address(): the linear address that lands at
+  // partition_addr in the given (global) sub partition; false for random
+  // interleaving, which has no inverse
+  bool raw_address(new_addr_type partition_addr, unsigned sub_partition,
+                   new_addr_type *addr) const;
+  bool has_raw_address() const { return memory_partition_indexing != RANDOM; }
 
  private:
   void addrdec_parseoption(const char *option);
+  void init_chip_hash();
   void sweep_test() const;  // sanity check to ensure no overlapping
+  unsigned chip_hash(new_addr_type row, unsigned bk) const;
 
   enum { CHIP = 0, BK = 1, ROW = 2, COL = 3, BURST = 4, N_ADDRDEC };
+  enum { N_CHIP_HASH_BITS = 5 };
 
   const char *addrdec_option;
   int gpgpu_mem_address_mask;
@@ -84,6 +135,17 @@ class linear_to_raw_address_translation {
   new_addr_type addrdec_mask[N_ADDRDEC];
   new_addr_type sub_partition_id_mask;
 
+  // decoders built from the masks above by init()
+  addrdec_bit_extract m_extract[N_ADDRDEC];
+  addrdec_bit_extract m_extract_partition;         // !gap
+  addrdec_bit_extract m_extract_no_sub_partition;  // gap
+  addrdec_bit_extract m_extract_sub_partition;
+
+  // IPOLY and PAE as parity masks: chip bit i is flipped by the parity of
+  // (row & m_chip_hash_row[i]) ^ (bk & m_chip_hash_bk[i])
+  new_addr_type m_chip_hash_row[N_CHIP_HASH_BITS];
+  unsigned m_chip_hash_bk[N_CHIP_HASH_BITS];
+
   unsigned int gap;
   unsigned m_n_channel;
   int m_n_sub_partition_in_channel;
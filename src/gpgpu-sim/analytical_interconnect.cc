@@ -0,0 +1,198 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <assert.h>
+#include <iostream>
+
+#include "analytical_interconnect.h"
+
+// packets are not split into flits; the size only reports bandwidth
+#define ANALYTICAL_INCT_FLIT_SIZE 40
+
+AnalyticalInterconnect* AnalyticalInterconnect::New(
+    const struct anicnt_config& m_config) {
+  return new AnalyticalInterconnect(m_config);
+}
+
+AnalyticalInterconnect::AnalyticalInterconnect(
+    const struct anicnt_config& config)
+    : m_config(config) {
+  n_shader = 0;
+  n_mem = 0;
+  n_subnets = config.subnets;
+  cycles = 0;
+  assert(n_subnets == 1 || n_subnets == 2);
+  assert(config.port_bandwidth > 0);
+}
+
+AnalyticalInterconnect::~AnalyticalInterconnect() {}
+
+void AnalyticalInterconnect::CreateInterconnect(unsigned m_n_shader,
+                                                unsigned m_n_mem) {
+  n_shader = m_n_shader;
+  n_mem = m_n_mem;
+  unsigned total_nodes = n_shader + n_mem;
+
+  net.resize(n_subnets);
+  for (unsigned i = 0; i < n_subnets; ++i) {
+    subnet& s = net[i];
+    s.in_free.assign(total_nodes, 0);
+    s.out_free.assign(total_nodes, 0);
+    s.in_flight.assign(total_nodes, 0);
+    s.out_queues.resize(total_nodes);
+    s.in_flight_total = 0;
+    s.packets_num = 0;
+    s.bytes = 0;
+    s.total_latency = 0;
+    s.queueing_delay = 0;
+    s.in_buffer_full = 0;
+  }
+}
+
+void AnalyticalInterconnect::Init() {
+  // there is no network state to warm up
+}
+
+unsigned AnalyticalInterconnect::get_push_subnet(
+    unsigned input_deviceID) const {
+  // same split as the local xbar: shaders inject requests, memory replies
+  if (n_subnets == 1 || input_deviceID < n_shader) return 0;
+  return 1;
+}
+
+unsigned AnalyticalInterconnect::get_pop_subnet(
+    unsigned output_deviceID) const {
+  if (n_subnets == 1 || output_deviceID >= n_shader) return 0;
+  return 1;
+}
+
+void AnalyticalInterconnect::Push(unsigned input_deviceID,
+                                  unsigned output_deviceID, void* data,
+                                  unsigned int size) {
+  subnet& s = net[get_push_subnet(input_deviceID)];
+  assert(input_deviceID < s.in_free.size());
+  assert(output_deviceID < s.out_free.size());
+  assert(s.in_flight[input_deviceID] < m_config.in_buffer_limit);
+
+  unsigned long long serialization =
+      (size + m_config.port_bandwidth - 1) / m_config.port_bandwidth;
+  if (serialization == 0) serialization = 1;
+
+  // source port: wait for earlier packets from this node to leave
+  unsigned long long depart = s.in_free[input_deviceID];
+  if (depart < cycles) depart = cycles;
+  s.in_free[input_deviceID] = depart + serialization;
+
+  // destination port: wait for earlier packets to this node to drain
+  unsigned long long arrive = depart + m_config.latency;
+  unsigned long long start = s.out_free[output_deviceID];
+  if (start < arrive) start = arrive;
+  s.out_free[output_deviceID] = start + serialization;
+
+  packet p;
+  p.ready_cycle = start + serialization;
+  p.input_deviceID = input_deviceID;
+  p.data = data;
+  s.out_queues[output_deviceID].push_back(p);
+  s.in_flight[input_deviceID]++;
+  s.in_flight_total++;
+
+  s.packets_num++;
+  s.bytes += size;
+  s.total_latency += p.ready_cycle - cycles;
+  s.queueing_delay += (depart - cycles) + (start - arrive);
+}
+
+void* AnalyticalInterconnect::Pop(unsigned ouput_deviceID) {
+  subnet& s = net[get_pop_subnet(ouput_deviceID)];
+  assert(ouput_deviceID < s.out_queues.size());
+  deque<packet>& q = s.out_queues[ouput_deviceID];
+  if (q.empty() || q.front().ready_cycle > cycles) return NULL;
+
+  packet p = q.front();
+  q.pop_front();
+  assert(s.in_flight[p.input_deviceID] > 0);
+  s.in_flight[p.input_deviceID]--;
+  s.in_flight_total--;
+  return p.data;
+}
+
+void AnalyticalInterconnect::Advance() { cycles++; }
+
+bool AnalyticalInterconnect::Busy() const {
+  for (unsigned i = 0; i < n_subnets; ++i) {
+    if (net[i].in_flight_total) return true;
+  }
+  return false;
+}
+
+bool AnalyticalInterconnect::HasBuffer(unsigned deviceID,
+                                       unsigned int size) const {
+  const subnet& s = net[get_push_subnet(deviceID)];
+  bool has_buffer = s.in_flight[deviceID] < m_config.in_buffer_limit;
+  if (!has_buffer) s.in_buffer_full++;
+  return has_buffer;
+}
+
+void AnalyticalInterconnect::display_subnet_stats(const char* name,
+                                                  const subnet& s) const {
+  cout << name << "_Network_injected_packets_num = " << s.packets_num << endl;
+  cout << name << "_Network_cycles = " << cycles << endl;
+  cout << name << "_Network_injected_packets_per_cycle = "
+       << (float)(s.packets_num) / cycles << endl;
+  cout << name << "_Network_bytes_per_cycle = " << (float)(s.bytes) / cycles
+       << endl;
+  cout << name << "_Network_avg_latency = "
+       << (float)(s.total_latency) / s.packets_num << endl;
+  cout << name << "_Network_avg_queueing_delay = "
+       << (float)(s.queueing_delay) / s.packets_num << endl;
+  cout << name << "_Network_in_buffer_full_per_cycle = "
+       << (float)(s.in_buffer_full) / cycles << endl;
+}
+
+void AnalyticalInterconnect::DisplayStats() const {
+  display_subnet_stats("Req", net[0]);
+  if (n_subnets > 1) {
+    cout << endl;
+    display_subnet_stats("Reply", net[1]);
+  }
+}
+
+void AnalyticalInterconnect::DisplayOverallStats() const {}
+
+unsigned AnalyticalInterconnect::GetFlitSize() const {
+  return ANALYTICAL_INCT_FLIT_SIZE;
+}
+
+void AnalyticalInterconnect::DisplayState(FILE* fp) const {
+  for (unsigned i = 0; i < n_subnets; ++i) {
+    fprintf(fp, "GPGPU-Sim uArch: ICNT: subnet %u: %llu packets in flight\n",
+            i, net[i].in_flight_total);
+  }
+}
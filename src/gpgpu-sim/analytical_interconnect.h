@@ -0,0 +1,106 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef _ANALYTICAL_INTERCONNECT_HPP_
+#define _ANALYTICAL_INTERCONNECT_HPP_
+
+#include <stdio.h>
+#include <deque>
+#include <vector>
+using namespace std;
+
+struct anicnt_config {
+  unsigned latency;          // fixed pipeline latency (cycles)
+  unsigned port_bandwidth;   // bytes per cycle per input/output port
+  unsigned in_buffer_limit;  // packets in flight per input port
+  unsigned subnets;
+};
+
+// Queueing model of a crossbar: no flits or arbiters are simulated. Every
+// input and output port keeps the cycle at which it becomes free again, so a
+// packet of S bytes occupies its source port for ceil(S / port_bandwidth)
+// cycles, crosses the fixed pipeline latency and then waits for (and
+// occupies) its destination port. Contention therefore shows up as queueing
+// delay on the port occupancy counters, and each push/pop is O(1).
+class AnalyticalInterconnect {
+ public:
+  AnalyticalInterconnect(const struct anicnt_config& m_config);
+  ~AnalyticalInterconnect();
+  static AnalyticalInterconnect* New(const struct anicnt_config& m_config);
+  void CreateInterconnect(unsigned n_shader, unsigned n_mem);
+
+  // node side functions
+  void Init();
+  void Push(unsigned input_deviceID, unsigned output_deviceID, void* data,
+            unsigned int size);
+  void* Pop(unsigned ouput_deviceID);
+  void Advance();
+  bool Busy() const;
+  bool HasBuffer(unsigned deviceID, unsigned int size) const;
+  void DisplayStats() const;
+  void DisplayOverallStats() const;
+  unsigned GetFlitSize() const;
+
+  void DisplayState(FILE* fp) const;
+
+ private:
+  struct packet {
+    unsigned long long ready_cycle;
+    unsigned input_deviceID;
+    void* data;
+  };
+
+  struct subnet {
+    vector<unsigned long long> in_free;   // cycle each input port frees up
+    vector<unsigned long long> out_free;  // cycle each output port frees up
+    vector<unsigned> in_flight;           // undelivered packets per input
+    vector<deque<packet> > out_queues;    // ready_cycle is non-decreasing
+    unsigned long long in_flight_total;
+
+    // stats
+    unsigned long long packets_num;
+    unsigned long long bytes;
+    unsigned long long total_latency;
+    unsigned long long queueing_delay;
+    mutable unsigned long long in_buffer_full;
+  };
+
+  unsigned get_push_subnet(unsigned input_deviceID) const;
+  unsigned get_pop_subnet(unsigned output_deviceID) const;
+  void display_subnet_stats(const char* name, const subnet& s) const;
+
+  const anicnt_config& m_config;
+
+  unsigned n_shader, n_mem;
+  unsigned n_subnets;
+  unsigned long long cycles;
+  vector<subnet> net;
+};
+
+#endif
@@ -111,6 +111,15 @@ dram_t::dram_t(unsigned int partition_id, const memory_config *config,
   }
   prio = 0;
 
+  REFIc = refresh_interval();
+  ref_owed = 0;
+  ref_bank = 0;
+  ref_pending = false;
+  pwr_state = DRAM_POWER_ACTIVE;
+  pwr_idle = 0;
+  pwr_exit = 0;
+  rwq_pending = 0;
+
   rwq = new fifo_pipeline<dram_req_t>("rwq", m_config->CL, m_config->CL + 1);
   mrqq = new fifo_pipeline<dram_req_t>("mrqq", 0, 2);
   returnq = new fifo_pipeline<mem_fetch>(
@@ -126,10 +135,19 @@ dram_t::dram_t(unsigned int partition_id, const memory_config *config,
   n_nop = 0;
   n_act = 0;
   n_pre = 0;
+  n_ref = 0;
+  n_ref_bank = 0;
+  n_ref_postponed = 0;
+  n_pd_entry = 0;
+  n_pd_cycles = 0;
+  n_sr_entry = 0;
+  n_sr_cycles = 0;
+  n_pwr_exit_cycles = 0;
   n_rd = 0;
   n_wr = 0;
   n_wr_WB = 0;
   n_rd_L2_A = 0;
+  n_rd_L2_P = 0;
   n_req = 0;
   max_mrqs_temp = 0;
   bwutil = 0;
@@ -280,6 +298,7 @@ void dram_t::cycle() {
   if (!returnq->full()) {
     dram_req_t *cmd = rwq->pop();
     if (cmd) {
+      rwq_pending--;
 #ifdef DRAM_VIEWCMD
       printf("\tDQ: BK%d Row:%03x Col:%03x", cmd->bk, cmd->row,
              cmd->col + cmd->dqbytes);
@@ -335,6 +354,16 @@ void dram_t::cycle() {
     ave_mrqs_partial += mrqq->get_length();
   }
 
+  if (m_config->tREFI && pwr_state != DRAM_SELF_REFRESH) {
+    if (--REFIc == 0) {
+      if (ref_owed > 0) n_ref_postponed++;
+      ref_owed++;
+      REFIc = refresh_interval();
+    }
+    ref_pending = refresh_wanted();
+  }
+  bool cmd_ready = power_cycle();
+
   unsigned k = m_config->nbk;
   bool issued = false;
 
@@ -393,18 +422,20 @@ void dram_t::cycle() {
   if (memory_Pending_ready > 0) banks_access_ready_total++;
   ///////////////////////////////////////////////////////////////////////////////////
 
+  // refresh and the precharges it needs go out on the row command bus
   bool issued_col_cmd = false;
-  bool issued_row_cmd = false;
+  bool issued_row_cmd = cmd_ready && issue_refresh_command();
 
   if (m_config->dual_bus_interface) {
     // dual bus interface
     // issue one row command and one column command
-    for (unsigned i = 0; i < m_config->nbk; i++) {
+    for (unsigned i = 0; cmd_ready && i < m_config->nbk; i++) {
       unsigned j = (i + prio) % m_config->nbk;
       issued_col_cmd = issue_col_command(j);
       if (issued_col_cmd) break;
     }
-    for (unsigned i = 0; i < m_config->nbk; i++) {
+    for (unsigned i = 0; cmd_ready && !issued_row_cmd && i < m_config->nbk;
+         i++) {
       unsigned j = (i + prio) % m_config->nbk;
       issued_row_cmd = issue_row_command(j);
       if (issued_row_cmd) break;
@@ -413,7 +444,7 @@ void dram_t::cycle() {
       unsigned j = (i + prio) % m_config->nbk;
       if (!bk[j]->mrq) {
         if (!CCDc && !RRDc && !RTWc && !WTRc && !bk[j]->RCDc && !bk[j]->RASc &&
-            !bk[j]->RCc && !bk[j]->RPc && !bk[j]->RCDWRc)
+            !bk[j]->RCc && !bk[j]->RPc && !bk[j]->RCDWRc && !bk[j]->RFCc)
           k--;
         bk[j]->n_idle++;
       }
@@ -421,16 +452,17 @@ void dram_t::cycle() {
   } else {
     // single bus interface
     // issue only one row/column command
+    bool bus_free = cmd_ready && !issued_row_cmd;
     for (unsigned i = 0; i < m_config->nbk; i++) {
       unsigned j = (i + prio) % m_config->nbk;
-      if (!issued_col_cmd) issued_col_cmd = issue_col_command(j);
+      if (bus_free && !issued_col_cmd) issued_col_cmd = issue_col_command(j);
 
-      if (!issued_col_cmd && !issued_row_cmd)
+      if (bus_free && !issued_col_cmd && !issued_row_cmd)
         issued_row_cmd = issue_row_command(j);
 
       if (!bk[j]->mrq) {
         if (!CCDc && !RRDc && !RTWc && !WTRc && !bk[j]->RCDc && !bk[j]->RASc &&
-            !bk[j]->RCc && !bk[j]->RPc && !bk[j]->RCDWRc)
+            !bk[j]->RCc && !bk[j]->RPc && !bk[j]->RCDWRc && !bk[j]->RFCc)
           k--;
         bk[j]->n_idle++;
       }
@@ -530,6 +562,7 @@ void dram_t::cycle() {
     DEC2ZERO(bk[j]->RCDWRc);
     DEC2ZERO(bk[j]->WTPc);
     DEC2ZERO(bk[j]->RTPc);
+    DEC2ZERO(bk[j]->RFCc);
   }
   for (unsigned j = 0; j < m_config->nbkgrp; j++) {
     DEC2ZERO(bkgrp[j]->CCDLc);
@@ -550,12 +583,14 @@ bool dram_t::issue_col_command(int j) {
     // correct row activated for a READ
     if (!issued && !CCDc && !bk[j]->RCDc && !(bkgrp[grp]->CCDLc) &&
         (bk[j]->curr_row == bk[j]->mrq->row) && (bk[j]->mrq->rw == READ) &&
-        (WTRc == 0) && (bk[j]->state == BANK_ACTIVE) && !rwq->full()) {
+        (WTRc == 0) && (bk[j]->state == BANK_ACTIVE) && !rwq->full() &&
+        !refresh_blocked(j)) {
       if (rw == WRITE) {
         rw = READ;
         rwq->set_min_length(m_config->CL);
       }
       rwq->push(bk[j]->mrq);
+      rwq_pending++;
       bk[j]->mrq->txbytes += m_config->dram_atom_size;
       CCDc = m_config->tCCD;
       bkgrp[grp]->CCDLc = m_config->tCCDL;
@@ -565,6 +600,8 @@ bool dram_t::issue_col_command(int j) {
       issued = true;
       if (bk[j]->mrq->data->get_access_type() == L2_WR_ALLOC_R)
         n_rd_L2_A++;
+      else if (bk[j]->mrq->data->get_access_type() == L2_PREFETCH_ACC)
+        n_rd_L2_P++;
       else
         n_rd++;
 
@@ -585,12 +622,14 @@ bool dram_t::issue_col_command(int j) {
         // correct row activated for a WRITE
         if (!issued && !CCDc && !bk[j]->RCDWRc && !(bkgrp[grp]->CCDLc) &&
             (bk[j]->curr_row == bk[j]->mrq->row) && (bk[j]->mrq->rw == WRITE) &&
-            (RTWc == 0) && (bk[j]->state == BANK_ACTIVE) && !rwq->full()) {
+            (RTWc == 0) && (bk[j]->state == BANK_ACTIVE) && !rwq->full() &&
+            !refresh_blocked(j)) {
       if (rw == READ) {
         rw = WRITE;
         rwq->set_min_length(m_config->WL);
       }
       rwq->push(bk[j]->mrq);
+      rwq_pending++;
 
       bk[j]->mrq->txbytes += m_config->dram_atom_size;
       CCDc = m_config->tCCD;
@@ -629,7 +668,7 @@ bool dram_t::issue_row_command(int j) {
     //     bank is idle
     // else
     if (!issued && !RRDc && (bk[j]->state == BANK_IDLE) && !bk[j]->RPc &&
-        !bk[j]->RCc) {  //
+        !bk[j]->RCc && !bk[j]->RFCc && !refresh_blocked(j)) {  //
 #ifdef DRAM_VERIFY
       PRINT_CYCLE = 1;
       printf("\tACT BK:%d NewRow:%03x From:%03x \n", j, bk[j]->mrq->row,
@@ -671,6 +710,160 @@ bool dram_t::issue_row_command(int j) {
   return issued;
 }
 
+unsigned dram_t::refresh_interval() const {
+  // per-bank refresh visits every bank once per tREFI
+  if (m_config->refresh_mode == DRAM_REF_PER_BANK)
+    return m_config->tREFI / m_config->nbk;
+  return m_config->tREFI;
+}
+
+bool dram_t::refresh_wanted() const {
+  int max_postpone = m_config->refresh_max_postpone;
+  if (m_config->refresh_policy == DRAM_REF_EAGER) return ref_owed > 0;
+  if (ref_owed <= 0 && m_config->refresh_policy != DRAM_REF_ELASTIC)
+    return false;
+
+  bool busy;
+  if (m_config->refresh_mode == DRAM_REF_PER_BANK) {
+    busy = bk[ref_bank]->mrq != NULL;
+  } else {
+    busy = que_length() > 0;
+    for (unsigned j = 0; !busy && j < m_config->nbk; j++)
+      busy = bk[j]->mrq != NULL;
+  }
+
+  // under load, postpone until the limit is reached
+  if (busy) return ref_owed > max_postpone;
+  if (m_config->refresh_policy == DRAM_REF_ELASTIC)
+    return ref_owed > -max_postpone;
+  return true;
+}
+
+bool dram_t::refresh_blocked(unsigned j) const {
+  return ref_pending &&
+         (m_config->refresh_mode == DRAM_REF_ALL_BANK || j == ref_bank);
+}
+
+// Precharges the banks covered by the pending refresh, then issues the
+// refresh once they are all idle.  Returns true if a command was issued.
+bool dram_t::issue_refresh_command() {
+  if (!ref_pending) return false;
+
+  bool per_bank = m_config->refresh_mode == DRAM_REF_PER_BANK;
+  unsigned first = per_bank ? ref_bank : 0;
+  unsigned last = per_bank ? ref_bank + 1 : m_config->nbk;
+  bool ready = true;
+  for (unsigned j = first; j < last; j++) {
+    unsigned grp = get_bankgrp_number(j);
+    if (bk[j]->state == BANK_ACTIVE) {
+      ready = false;
+      if (!bk[j]->RASc && !bk[j]->WTPc && !bk[j]->RTPc && !bkgrp[grp]->RTPLc) {
+        bk[j]->state = BANK_IDLE;
+        bk[j]->RPc = m_config->tRP;
+        n_pre++;
+        n_pre_partial++;
+#ifdef DRAM_VERIFY
+        PRINT_CYCLE = 1;
+        printf("\tPRE BK:%d Row:%03x (refresh)\n", j, bk[j]->curr_row);
+#endif
+        return true;
+      }
+    } else if (bk[j]->RPc || bk[j]->RFCc) {
+      ready = false;
+    }
+  }
+  if (!ready || (per_bank && RRDc)) return false;
+
+  for (unsigned j = first; j < last; j++) {
+    bk[j]->RFCc = per_bank ? m_config->tRFCpb : m_config->tRFC;
+  }
+  if (per_bank) {
+    RRDc = m_config->tRRD;
+    ref_bank = (ref_bank + 1) % m_config->nbk;
+  }
+#ifdef DRAM_VERIFY
+  PRINT_CYCLE = 1;
+  printf("\tREF BK:%d-%d\n", first, last - 1);
+#endif
+  n_ref++;
+  n_ref_bank += last - first;
+  ref_owed--;
+  ref_pending = false;
+  return true;
+}
+
+void dram_t::close_all_banks() {
+  for (unsigned j = 0; j < m_config->nbk; j++) {
+    if (bk[j]->state == BANK_ACTIVE) {
+      bk[j]->state = BANK_IDLE;
+      n_pre++;
+      n_pre_partial++;
+    }
+  }
+}
+
+// Advances the power-down state machine.  Returns true if the device can
+// accept commands this cycle.
+bool dram_t::power_cycle() {
+  if (!m_config->power_down_idle && !m_config->self_refresh_idle) return true;
+
+  bool requests = que_length() > 0;
+  for (unsigned j = 0; !requests && j < m_config->nbk; j++)
+    requests = bk[j]->mrq != NULL;
+
+  // refresh wakes the device but does not reset the idle count
+  switch (pwr_state) {
+    case DRAM_POWER_ACTIVE:
+      if (requests || rwq_pending) {
+        pwr_idle = 0;
+        return true;
+      }
+      if (ref_pending) return true;
+      pwr_idle++;
+      break;
+    case DRAM_POWER_DOWN:
+    case DRAM_SELF_REFRESH:
+      if (pwr_state == DRAM_POWER_DOWN)
+        n_pd_cycles++;
+      else
+        n_sr_cycles++;
+      if (!requests && !ref_pending) {
+        pwr_idle++;
+        break;
+      }
+      pwr_exit = pwr_state == DRAM_POWER_DOWN ? m_config->tXP : m_config->tXS;
+      if (pwr_state == DRAM_SELF_REFRESH) {
+        // the device kept itself refreshed; restart the interval
+        REFIc = refresh_interval();
+        ref_owed = 0;
+      }
+      pwr_state = DRAM_POWER_EXIT;
+      if (requests) pwr_idle = 0;
+      // fall through
+    case DRAM_POWER_EXIT:
+      if (pwr_exit) {
+        n_pwr_exit_cycles++;
+        pwr_exit--;
+        return false;
+      }
+      pwr_state = DRAM_POWER_ACTIVE;
+      return true;
+  }
+
+  if (m_config->self_refresh_idle && pwr_state != DRAM_SELF_REFRESH &&
+      pwr_idle >= m_config->self_refresh_idle) {
+    // self-refresh entry implies a precharge-all
+    close_all_banks();
+    pwr_state = DRAM_SELF_REFRESH;
+    n_sr_entry++;
+  } else if (m_config->power_down_idle && pwr_state == DRAM_POWER_ACTIVE &&
+             pwr_idle >= m_config->power_down_idle) {
+    pwr_state = DRAM_POWER_DOWN;
+    n_pd_entry++;
+  }
+  return pwr_state == DRAM_POWER_ACTIVE;
+}
+
 // if mrq is being serviced by dram, gets popped after CL latency fulfilled
 class mem_fetch *dram_t::return_queue_pop() {
   return returnq->pop();
@@ -695,6 +888,14 @@ void dram_t::print(FILE *simFile) const {
       (float)bwutil / n_cmd);
   fprintf(simFile, "n_activity=%llu dram_eff=%.4g\n", n_activity,
           (float)bwutil / n_activity);
+  if (m_config->tREFI || m_config->power_down_idle ||
+      m_config->self_refresh_idle)
+    fprintf(simFile,
+            "n_ref=%llu n_ref_bank=%llu n_ref_postponed=%llu n_pd_entry=%llu "
+            "n_pd_cycles=%llu n_sr_entry=%llu n_sr_cycles=%llu "
+            "n_pwr_exit_cycles=%llu\n",
+            n_ref, n_ref_bank, n_ref_postponed, n_pd_entry, n_pd_cycles,
+            n_sr_entry, n_sr_cycles, n_pwr_exit_cycles);
   for (i = 0; i < m_config->nbk; i++) {
     fprintf(simFile, "bk%d: %da %di ", i, bk[i]->n_access, bk[i]->n_idle);
   }
@@ -743,12 +944,19 @@ void dram_t::print(FILE *simFile) const {
   printf("Read = %llu \n", n_rd);
   printf("Write = %llu \n", n_wr);
   printf("L2_Alloc = %llu \n", n_rd_L2_A);
+  if (m_config->l2_prefetcher != L2_PREFETCH_NONE)
+    printf("L2_Prefetch = %llu \n", n_rd_L2_P);
   printf("L2_WB = %llu \n", n_wr_WB);
   printf("n_act = %llu \n", n_act);
   printf("n_pre = %llu \n", n_pre);
   printf("n_ref = %llu \n", n_ref);
+  if (m_config->tREFI) printf("n_ref_postponed = %llu \n", n_ref_postponed);
+  if (m_config->power_down_idle) printf("n_pd_cycles = %llu \n", n_pd_cycles);
+  if (m_config->self_refresh_idle)
+    printf("n_sr_cycles = %llu \n", n_sr_cycles);
   printf("n_req = %llu \n", n_req);
-  printf("total_req = %llu \n", n_rd + n_wr + n_rd_L2_A + n_wr_WB);
+  printf("total_req = %llu \n",
+         n_rd + n_wr + n_rd_L2_A + n_rd_L2_P + n_wr_WB);
 
   printf("\nDual Bus Interface Util: \n");
   printf("issued_total_row = %llu \n", issued_total_row);
@@ -854,8 +1062,10 @@ void dram_t::set_dram_power_stats(unsigned &cmd, unsigned &activity,
   activity = n_activity;
   nop = n_nop;
   act = n_act;
-  pre = n_pre;
-  rd = n_rd;
+  // GPUWattch has no refresh term; a bank refresh is an internal row
+  // activate/precharge, so charge it as a precharge
+  pre = n_pre + n_ref_bank;
+  rd = n_rd + n_rd_L2_P;
   wr = n_wr;
   req = n_req;
 }
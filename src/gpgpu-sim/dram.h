@@ -83,6 +83,7 @@ struct bank_t {
   unsigned int RCc;
   unsigned int WTPc;  // write to precharge
   unsigned int RTPc;  // read to precharge
+  unsigned int RFCc;  // refresh in progress
 
   unsigned char rw;     // is the bank reading or writing?
   unsigned char state;  // is the bank active or idle?
@@ -105,6 +106,13 @@ enum bank_index_function {
 
 enum bank_grp_bits_position { HIGHER_BITS = 0, LOWER_BITS };
 
+enum dram_power_state {
+  DRAM_POWER_ACTIVE = 0,
+  DRAM_POWER_DOWN,
+  DRAM_SELF_REFRESH,
+  DRAM_POWER_EXIT
+};
+
 class mem_fetch;
 class memory_config;
 
@@ -155,6 +163,23 @@ class dram_t {
   bool issue_col_command(int j);
   bool issue_row_command(int j);
 
+  // refresh and power-down
+  unsigned refresh_interval() const;
+  bool refresh_wanted() const;
+  bool refresh_blocked(unsigned j) const;
+  bool issue_refresh_command();
+  bool power_cycle();
+  void close_all_banks();
+
+  unsigned int REFIc;  // cycles until the next refresh becomes due
+  int ref_owed;        // due refreshes not yet issued (< 0 when pulled in)
+  unsigned ref_bank;   // next bank for per-bank refresh
+  bool ref_pending;    // a refresh is being scheduled; block new accesses
+  enum dram_power_state pwr_state;
+  unsigned pwr_idle;  // consecutive idle cycles
+  unsigned pwr_exit;  // remaining power-down/self-refresh exit latency
+  unsigned rwq_pending;  // data bursts still in flight in rwq
+
   unsigned int RRDc;
   unsigned int CCDc;
   unsigned int RTWc;  // read to write penalty applies across banks
@@ -181,8 +206,16 @@ class dram_t {
   unsigned long long n_act;
   unsigned long long n_pre;
   unsigned long long n_ref;
+  unsigned long long n_ref_bank;  // bank refreshes (nbk per all-bank refresh)
+  unsigned long long n_ref_postponed;
+  unsigned long long n_pd_entry;
+  unsigned long long n_pd_cycles;
+  unsigned long long n_sr_entry;
+  unsigned long long n_sr_cycles;
+  unsigned long long n_pwr_exit_cycles;
   unsigned long long n_rd;
   unsigned long long n_rd_L2_A;
+  unsigned long long n_rd_L2_P;
   unsigned long long n_wr;
   unsigned long long n_wr_WB;
   unsigned long long n_req;
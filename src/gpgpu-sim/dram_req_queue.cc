@@ -0,0 +1,192 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "dram_req_queue.h"
+#include <assert.h>
+#include "dram.h"
+
+static const unsigned MIN_LOG2_SLOTS = 4;
+
+dram_req_queue::dram_req_queue(unsigned n_bank, unsigned capacity)
+    : m_free(NIL), m_bank(n_bank) {
+  for (unsigned i = 0; i < n_bank; i++) {
+    bank_queue &b = m_bank[i];
+    b.oldest = b.newest = NIL;
+    b.size = 0;
+    b.n_rows = 0;
+    b.log2_slots = MIN_LOG2_SLOTS;
+    b.slots.resize(1 << MIN_LOG2_SLOTS);
+    for (unsigned s = 0; s < b.slots.size(); s++) b.slots[s].oldest = NIL;
+    b.streak = false;
+    b.streak_row = 0;
+  }
+  // a bounded queue never allocates after construction
+  m_node.resize(capacity);
+  for (unsigned n = capacity; n-- > 0;) {
+    m_node[n].newer = m_free;
+    m_free = n;
+  }
+}
+
+static inline unsigned row_hash(unsigned row, unsigned log2_slots) {
+  return (row * 2654435761u) >> (32 - log2_slots);
+}
+
+unsigned dram_req_queue::find_slot(const bank_queue &b, unsigned row) const {
+  unsigned mask = b.slots.size() - 1;
+  for (unsigned s = row_hash(row, b.log2_slots);; s = (s + 1) & mask) {
+    if (b.slots[s].oldest == NIL) return NIL;
+    if (b.slots[s].row == row) return s;
+  }
+}
+
+unsigned dram_req_queue::insert_slot(bank_queue &b, unsigned row) {
+  if (2 * (b.n_rows + 1) > b.slots.size()) grow(b);
+  unsigned mask = b.slots.size() - 1;
+  unsigned s = row_hash(row, b.log2_slots);
+  while (b.slots[s].oldest != NIL) {
+    if (b.slots[s].row == row) return s;
+    s = (s + 1) & mask;
+  }
+  b.slots[s].row = row;
+  b.n_rows++;
+  return s;
+}
+
+// Backward-shift deletion keeps every probe sequence free of holes, so
+// no tombstones are needed.
+void dram_req_queue::erase_slot(bank_queue &b, unsigned s) {
+  unsigned mask = b.slots.size() - 1;
+  unsigned hole = s;
+  for (unsigned j = (s + 1) & mask; b.slots[j].oldest != NIL;
+       j = (j + 1) & mask) {
+    unsigned home = row_hash(b.slots[j].row, b.log2_slots);
+    // move j into the hole unless its home lies cyclically in (hole, j]
+    bool stays = hole <= j ? (hole < home && home <= j)
+                           : (hole < home || home <= j);
+    if (!stays) {
+      b.slots[hole] = b.slots[j];
+      hole = j;
+    }
+  }
+  b.slots[hole].oldest = NIL;
+  b.n_rows--;
+}
+
+void dram_req_queue::grow(bank_queue &b) {
+  std::vector<row_slot> old;
+  old.swap(b.slots);
+  b.log2_slots++;
+  b.slots.resize(1 << b.log2_slots);
+  for (unsigned s = 0; s < b.slots.size(); s++) b.slots[s].oldest = NIL;
+  unsigned mask = b.slots.size() - 1;
+  for (unsigned i = 0; i < old.size(); i++) {
+    if (old[i].oldest == NIL) continue;
+    unsigned s = row_hash(old[i].row, b.log2_slots);
+    while (b.slots[s].oldest != NIL) s = (s + 1) & mask;
+    b.slots[s] = old[i];
+  }
+}
+
+unsigned dram_req_queue::alloc_node() {
+  if (m_free == NIL) {
+    m_node.push_back(node());
+    return m_node.size() - 1;
+  }
+  unsigned n = m_free;
+  m_free = m_node[n].newer;
+  return n;
+}
+
+void dram_req_queue::push(dram_req_t *req) {
+  unsigned n = alloc_node();
+  bank_queue &b = m_bank[req->bk];
+  node &nd = m_node[n];
+  nd.req = req;
+
+  // newest at the tail of the age list
+  nd.older = b.newest;
+  nd.newer = NIL;
+  if (b.newest != NIL)
+    m_node[b.newest].newer = n;
+  else
+    b.oldest = n;
+  b.newest = n;
+  b.size++;
+
+  row_slot &rs = b.slots[insert_slot(b, req->row)];
+  nd.row_newer = NIL;
+  if (rs.oldest == NIL)
+    rs.oldest = n;
+  else
+    m_node[rs.newest].row_newer = n;
+  rs.newest = n;
+}
+
+dram_req_t *dram_req_queue::schedule(unsigned bank, unsigned curr_row,
+                                     bool &row_hit) {
+  bank_queue &b = m_bank[bank];
+  row_hit = true;
+  if (!b.streak) {
+    if (b.size == 0) return NULL;
+    if (find_slot(b, curr_row) != NIL) {
+      b.streak_row = curr_row;
+    } else {
+      b.streak_row = m_node[b.oldest].req->row;
+      row_hit = false;
+    }
+    b.streak = true;
+  }
+
+  unsigned s = find_slot(b, b.streak_row);
+  assert(s != NIL);  // where did the request go???
+  unsigned n = b.slots[s].oldest;
+  node &nd = m_node[n];
+
+  b.slots[s].oldest = nd.row_newer;
+  if (nd.row_newer == NIL) {
+    erase_slot(b, s);
+    b.streak = false;
+  }
+
+  if (nd.older != NIL)
+    m_node[nd.older].newer = nd.newer;
+  else
+    b.oldest = nd.newer;
+  if (nd.newer != NIL)
+    m_node[nd.newer].older = nd.older;
+  else
+    b.newest = nd.older;
+  b.size--;
+
+  dram_req_t *req = nd.req;
+  nd.newer = m_free;
+  m_free = n;
+  return req;
+}
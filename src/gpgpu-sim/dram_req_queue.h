@@ -0,0 +1,93 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef DRAM_REQ_QUEUE_H
+#define DRAM_REQ_QUEUE_H
+
+#include <vector>
+
+class dram_req_t;
+
+// Pending DRAM requests of one scheduler queue, kept per bank in arrival
+// order and indexed by row.
+//
+// Requests live in a shared node pool and are threaded on two intrusive
+// lists: the bank's age list and the list of its row.  Each bank maps row
+// to its row list with an open-addressing table, so insertion and FR-FCFS
+// selection are O(1) and no container allocates once the pool has warmed
+// up.
+class dram_req_queue {
+ public:
+  explicit dram_req_queue(unsigned n_bank, unsigned capacity = 0);
+
+  void push(dram_req_t *req);
+
+  // FR-FCFS pick for a bank: keep draining the row picked last time; when
+  // it runs dry, take the oldest request for curr_row, or else the oldest
+  // request in the bank (row_hit is then false).  Returns NULL if the bank
+  // has nothing pending.
+  dram_req_t *schedule(unsigned bank, unsigned curr_row, bool &row_hit);
+
+  bool empty(unsigned bank) const { return m_bank[bank].size == 0; }
+  unsigned size(unsigned bank) const { return m_bank[bank].size; }
+
+ private:
+  static const unsigned NIL = ~0u;
+
+  struct node {
+    dram_req_t *req;
+    unsigned older, newer;  // bank age list
+    unsigned row_newer;     // row list, oldest first
+  };
+  struct row_slot {
+    unsigned row;
+    unsigned oldest, newest;  // oldest == NIL marks a free slot
+  };
+  struct bank_queue {
+    unsigned oldest, newest;
+    unsigned size;
+    unsigned n_rows;
+    unsigned log2_slots;
+    std::vector<row_slot> slots;
+    bool streak;  // a row has been picked and still has requests
+    unsigned streak_row;
+  };
+
+  unsigned find_slot(const bank_queue &b, unsigned row) const;
+  unsigned insert_slot(bank_queue &b, unsigned row);
+  void erase_slot(bank_queue &b, unsigned s);
+  void grow(bank_queue &b);
+  unsigned alloc_node();
+
+  std::vector<node> m_node;
+  unsigned m_free;
+  std::vector<bank_queue> m_bank;
+};
+
+#endif
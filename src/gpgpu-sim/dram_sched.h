@@ -32,6 +32,7 @@
 #include <list>
 #include <map>
 #include "dram.h"
+#include "dram_req_queue.h"
 #include "gpu-misc.h"
 #include "gpu-sim.h"
 #include "shader.h"
@@ -54,17 +55,12 @@ class frfcfs_scheduler {
   dram_t *m_dram;
   unsigned m_num_pending;
   unsigned m_num_write_pending;
-  std::list<dram_req_t *> *m_queue;
-  std::map<unsigned, std::list<std::list<dram_req_t *>::iterator> > *m_bins;
-  std::list<std::list<dram_req_t *>::iterator> **m_last_row;
+  dram_req_queue *m_queue;
   unsigned *curr_row_service_time;  // one set of variables for each bank.
   unsigned *row_service_timestamp;  // tracks when scheduler began servicing
                                     // current row
 
-  std::list<dram_req_t *> *m_write_queue;
-  std::map<unsigned, std::list<std::list<dram_req_t *>::iterator> >
-      *m_write_bins;
-  std::list<std::list<dram_req_t *>::iterator> **m_last_write_row;
+  dram_req_queue *m_write_queue;
 
   enum memory_mode m_mode;
   memory_stats_t *m_stats;
@@ -851,6 +851,9 @@ void cache_stats::get_sub_stats(struct cache_sub_stats &css) const {
   t_css.clear();
 
   for (unsigned type = 0; type < NUM_MEM_ACCESS_TYPE; ++type) {
+    // keep demand totals comparable with prefetching off; prefetch tag
+    // lookups show in the breakdown and the L1D/L2 prefetch stats
+    if (type == L1_PREFETCH_ACC || type == L2_PREFETCH_ACC) continue;
     for (unsigned status = 0; status < NUM_CACHE_REQUEST_STATUS; ++status) {
       if (status == HIT || status == MISS || status == SECTOR_MISS ||
           status == HIT_RESERVED)
@@ -1028,7 +1031,8 @@ bool baseline_cache::bandwidth_management::fill_port_free() const {
 void baseline_cache::cycle() {
   if (!m_miss_queue.empty()) {
     mem_fetch *mf = m_miss_queue.front();
-    if (!m_memport->full(mf->size(), mf->get_is_write())) {
+    if (!m_memport->full(mf->size(), mf->get_is_write(),
+                         mf->get_kernel_id())) {
       m_miss_queue.pop_front();
       m_memport->push(mf);
     }
@@ -1728,7 +1732,7 @@ void tex_cache::cycle() {
   // send next request to lower level of memory
   if (!m_request_fifo.empty()) {
     mem_fetch *mf = m_request_fifo.peek();
-    if (!m_memport->full(mf->get_ctrl_size(), false)) {
+    if (!m_memport->full(mf->get_ctrl_size(), false, mf->get_kernel_id())) {
       m_request_fifo.pop();
       m_memport->push(mf);
     }
@@ -714,6 +714,7 @@ class cache_config {
     return addr & ~(new_addr_type)(m_atom_sz - 1);
   }
   enum mshr_config_t get_mshr_type() const { return m_mshr_type; }
+  unsigned get_mshr_entries() const { return m_mshr_entries; }
   void set_assoc(unsigned n) {
     // set new assoc. L1 cache dynamically resized in Volta
     m_assoc = n;
@@ -901,6 +902,8 @@ class mshr_table {
   bool full(new_addr_type block_addr) const;
   /// Add or merge this access
   void add(new_addr_type block_addr, mem_fetch *mf);
+  /// Number of block addresses with requests pending
+  unsigned occupancy() const { return m_data.size(); }
   /// Returns true if cannot accept new fill responses
   bool busy() const { return false; }
   /// Accept a new cache fill response: mark entry ready for processing
@@ -1163,6 +1166,13 @@ class baseline_cache : public cache_t {
                                            std::list<cache_event> &events) = 0;
   /// Sends next request to lower level of memory
   void cycle();
+  /// True when cycle() has nothing to send and both ports are free
+  bool idle() const {
+    return m_miss_queue.empty() && m_bandwidth_management.data_port_free() &&
+           m_bandwidth_management.fill_port_free();
+  }
+  /// Equivalent of cycle() for an idle cache (only samples port utility)
+  void idle_cycle() { m_stats.sample_cache_port_utility(false, false); }
   /// Interface for response from lower memory level (model bandwidth
   /// restictions in caller)
   void fill(mem_fetch *mf, unsigned time);
@@ -1214,6 +1224,16 @@ class baseline_cache : public cache_t {
                         mem_access_sector_mask_t mask) {
     m_tag_array->fill(addr, time, mask);
   }
+  // Tag lookup that changes no cache state (replacement, stats), for
+  // prefetchers filtering blocks that are already present or on their way
+  enum cache_request_status probe(new_addr_type addr,
+                                  mem_access_sector_mask_t mask) const {
+    unsigned idx;
+    return m_tag_array->probe(m_config.block_addr(addr), idx, mask);
+  }
+  // MSHR entries in use, so prefetchers can back off before demand misses
+  // start failing reservation
+  unsigned mshr_occupancy() const { return m_mshrs.occupancy(); }
 
  protected:
   // Constructor that can be used by derived classes with custom tag arrays
@@ -1610,6 +1630,11 @@ class tex_cache : public cache_t {
                                    unsigned time,
                                    std::list<cache_event> &events);
   void cycle();
+  /// True when cycle() has no request to send and no fragment to retire
+  bool idle() const {
+    return m_request_fifo.empty() && m_fragment_fifo.empty() &&
+           m_result_fifo.empty();
+  }
   /// Place returning cache block into reorder buffer
   void fill(mem_fetch *mf, unsigned time);
   /// Are any (accepted) accesses that had to wait for memory now ready? (does
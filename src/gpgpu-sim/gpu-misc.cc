@@ -52,3 +52,14 @@ unsigned int LOGB2(unsigned int v) {
 
   return r;
 }
+
+unsigned long long fnv1a_hash(const void *data, size_t length,
+                              unsigned long long seed) {
+  const unsigned char *bytes = (const unsigned char *)data;
+  unsigned long long h = seed;
+  for (size_t i = 0; i < length; i++) {
+    h ^= bytes[i];
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
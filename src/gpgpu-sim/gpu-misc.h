@@ -34,8 +34,15 @@
 // good for a single shader configuration
 #define DEBUGL1MISS 0
 
+#include <stddef.h>
+
 unsigned int LOGB2(unsigned int v);
 
+// 64-bit FNV-1a over a byte buffer; pass a previous result as seed to chain
+#define FNV1A_64_INIT 0xcbf29ce484222325ULL
+unsigned long long fnv1a_hash(const void *data, size_t length,
+                              unsigned long long seed = FNV1A_64_INIT);
+
 #define gs_min2(a, b) (((a) < (b)) ? (a) : (b))
 #define min3(x, y, z) (((x) < (y) && (x) < (z)) ? (x) : (gs_min2((y), (z))))
 
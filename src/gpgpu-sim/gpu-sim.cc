@@ -47,6 +47,8 @@
 #include "gpu-cache.h"
 #include "gpu-misc.h"
 #include "icnt_wrapper.h"
+#include "inst_trace.h"
+#include "kernel_memo.h"
 #include "l2cache.h"
 #include "shader.h"
 #include "stat-tool.h"
@@ -82,8 +84,6 @@ class gpgpu_sim_wrapper {};
 
 bool g_interactive_debugger_enabled = false;
 
-tr1_hash_map<new_addr_type, unsigned> address_random_interleaving;
-
 /* Clock Domains */
 
 #define CORE 0x01
@@ -151,6 +151,27 @@ void memory_config::reg_options(class OptionParser *opp) {
   option_parser_register(opp, "-gpgpu_cache:dl2_texture_only", OPT_BOOL,
                          &m_L2_texure_only, "L2 cache used for texture only",
                          "1");
+  option_parser_register(
+      opp, "-gpgpu_l2_prefetcher", OPT_INT32, &l2_prefetcher,
+      "memory-side L2 prefetcher: 0 = none, 1 = next-N-line, 2 = stream/stride",
+      "0");
+  option_parser_register(opp, "-gpgpu_l2_prefetch_degree", OPT_UINT32,
+                         &l2_prefetch_degree,
+                         "L2 blocks prefetched per trigger", "2");
+  option_parser_register(
+      opp, "-gpgpu_l2_prefetch_distance", OPT_UINT32, &l2_prefetch_distance,
+      "how far (in strides) a stream prefetcher may run ahead of demand; "
+      "also the reach for matching a miss to a stream",
+      "16");
+  option_parser_register(opp, "-gpgpu_l2_prefetch_streams", OPT_UINT32,
+                         &l2_prefetch_streams,
+                         "streams tracked per L2 bank by the stream prefetcher",
+                         "16");
+  option_parser_register(opp, "-gpgpu_l2_prefetch_queue_size", OPT_UINT32,
+                         &l2_prefetch_queue_size,
+                         "prefetch requests waiting per L2 bank; the oldest "
+                         "is dropped on overflow",
+                         "32");
   option_parser_register(
       opp, "-gpgpu_n_mem", OPT_UINT32, &m_n_mem,
       "number of memory modules (e.g. memory controllers) in gpu", "8");
@@ -218,8 +239,9 @@ void memory_config::reg_options(class OptionParser *opp) {
 }
 
 void shader_core_config::reg_options(class OptionParser *opp) {
-  option_parser_register(opp, "-gpgpu_simd_model", OPT_INT32, &model,
-                         "1 = post-dominator", "1");
+  option_parser_register(
+      opp, "-gpgpu_simd_model", OPT_INT32, &model,
+      "1 = post-dominator, 2 = independent thread scheduling", "1");
   option_parser_register(
       opp, "-gpgpu_shader_core_pipeline", OPT_CSTR,
       &gpgpu_shader_core_pipeline_opt,
@@ -270,6 +292,32 @@ void shader_core_config::reg_options(class OptionParser *opp) {
                          "global memory access skip L1D cache (implements "
                          "-Xptxas -dlcm=cg, default=no skip)",
                          "0");
+  option_parser_register(opp, "-gpgpu_l1d_prefetcher", OPT_INT32,
+                         &l1d_prefetcher,
+                         "core-side L1D prefetcher: 0 = none, 1 = per-PC "
+                         "stride",
+                         "0");
+  option_parser_register(opp, "-gpgpu_l1d_prefetch_degree", OPT_UINT32,
+                         &l1d_prefetch_degree,
+                         "strides prefetched per trained load", "2");
+  option_parser_register(opp, "-gpgpu_l1d_prefetch_distance", OPT_UINT32,
+                         &l1d_prefetch_distance,
+                         "strides skipped ahead of the demand address before "
+                         "the first prefetch",
+                         "1");
+  option_parser_register(opp, "-gpgpu_l1d_prefetch_table_size", OPT_UINT32,
+                         &l1d_prefetch_table_size,
+                         "entries in the per-(PC, warp) stride table", "64");
+  option_parser_register(opp, "-gpgpu_l1d_prefetch_queue_size", OPT_UINT32,
+                         &l1d_prefetch_queue_size,
+                         "prefetch requests waiting per core; the oldest is "
+                         "dropped on overflow",
+                         "16");
+  option_parser_register(opp, "-gpgpu_l1d_prefetch_mshr_reserve", OPT_UINT32,
+                         &l1d_prefetch_mshr_reserve,
+                         "L1D MSHR entries kept free for demand misses; "
+                         "prefetches stall while fewer are available",
+                         "8");
 
   option_parser_register(opp, "-gpgpu_perfect_mem", OPT_BOOL,
                          &gpgpu_perfect_mem,
@@ -337,6 +385,17 @@ void shader_core_config::reg_options(class OptionParser *opp) {
   option_parser_register(
       opp, "-gpgpu_shmem_limited_broadcast", OPT_BOOL, &shmem_limited_broadcast,
       "Limit shared memory to do one broadcast per cycle (default on)", "1");
+  option_parser_register(opp, "-gpgpu_shmem_bank_width", OPT_UINT32,
+                         &shmem_bank_width,
+                         "Width of each shared memory bank in bytes "
+                         "(default 4)",
+                         "4");
+  option_parser_register(
+      opp, "-gpgpu_shmem_wide_access_phases", OPT_BOOL,
+      &shmem_wide_access_phases,
+      "Serve shared memory accesses wider than a bank (64/128-bit, vector) in "
+      "phases spanning several banks per thread (default off)",
+      "0");
   option_parser_register(opp, "-gpgpu_shmem_warp_parts", OPT_INT32,
                          &mem_warp_parts,
                          "Number of portions a warp is divided into for shared "
@@ -473,6 +532,12 @@ void shader_core_config::reg_options(class OptionParser *opp) {
                          "Select the simulation order of cores in a cluster "
                          "(0=Fix, 1=Round-Robin)",
                          "1");
+  option_parser_register(opp, "-gpgpu_skip_idle_core_cycles", OPT_BOOL,
+                         &gpgpu_skip_idle_core_cycles,
+                         "Skip the pipeline of cores whose warps all wait on "
+                         "memory responses, replaying only their per-cycle "
+                         "statistics (cycle-exact, default = 0)",
+                         "0");
   option_parser_register(
       opp, "-gpgpu_pipeline_widths", OPT_CSTR, &pipeline_widths_string,
       "Pipeline widths "
@@ -573,6 +638,33 @@ void gpgpu_sim_config::reg_options(option_parser_t opp) {
   option_parser_register(
       opp, "-gpgpu_max_concurrent_kernel", OPT_INT32, &max_concurrent_kernel,
       "maximum kernels that can run concurrently on GPU", "8");
+  option_parser_register(
+      opp, "-gpgpu_kernel_memo", OPT_BOOL, &gpgpu_kernel_memo,
+      "Reuse the timing of previously simulated identical kernel launches "
+      "and only run them functionally (1=on, 0=off (default))",
+      "0");
+  option_parser_register(opp, "-gpgpu_kernel_memo_file", OPT_CSTR,
+                         &gpgpu_kernel_memo_file,
+                         "File the kernel memo is loaded from and appended to "
+                         "(only valid for one configuration)",
+                         "gpgpusim_kernel_memo.txt");
+  option_parser_register(
+      opp, "-gpgpu_kernel_memo_steady_state", OPT_BOOL,
+      &gpgpu_kernel_memo_steady_state,
+      "Assume global memory contents do not affect kernel timing and leave "
+      "them out of the launch fingerprint",
+      "0");
+  option_parser_register(
+      opp, "-gpgpu_inst_trace_mode", OPT_INT32, &gpgpu_inst_trace_mode,
+      "Per-warp instruction trace: 0=off (default), 1=capture from the PTX "
+      "functional model, 2=replay instead of executing PTX",
+      "0");
+  option_parser_register(opp, "-gpgpu_inst_trace_prefix", OPT_CSTR,
+                         &gpgpu_inst_trace_prefix,
+                         "Instruction trace files are named "
+                         "<prefix>_kernel_<uid>.gz; a capture also writes "
+                         "<prefix>_launches.txt and the PTX it loaded",
+                         "gpgpusim_inst_trace");
   option_parser_register(
       opp, "-gpgpu_cflog_interval", OPT_INT32, &gpgpu_cflog_interval,
       "Interval between each snapshot in control flow logger", "0");
@@ -682,6 +774,70 @@ void gpgpu_sim::launch(kernel_info_t *kinfo) {
     }
   }
   assert(n < m_running_kernels.size());
+
+  if (m_config.gpgpu_inst_trace_mode != INST_TRACE_OFF) {
+    assert(m_inst_traces.find(kinfo->get_uid()) == m_inst_traces.end());
+    m_inst_traces[kinfo->get_uid()] = new kernel_inst_trace(
+        m_config.gpgpu_inst_trace_prefix, *kinfo,
+        m_config.gpgpu_inst_trace_mode == INST_TRACE_CAPTURE,
+        m_shader_config->warp_size);
+    if (m_inst_trace_index)
+      m_inst_trace_index->add_kernel(kinfo->get_uid(), kinfo->name());
+  }
+
+  if (m_kernel_memo) {
+    // timing is only recorded for kernels that have the GPU to themselves
+    bool alone = true;
+    for (unsigned k = 0; k < m_running_kernels.size(); k++)
+      if (m_running_kernels[k] && m_running_kernels[k] != kinfo &&
+          !m_running_kernels[k]->done())
+        alone = false;
+    if (alone)
+      m_kernel_memo->begin(
+          kinfo->get_uid(),
+          m_kernel_memo->fingerprint(*kinfo, get_global_memory()),
+          gpu_tot_sim_cycle + gpu_sim_cycle, gpu_tot_sim_insn + gpu_sim_insn);
+    else
+      m_kernel_memo->cancel_pending();
+  }
+}
+
+bool gpgpu_sim::launch_memoized(kernel_info_t *kinfo) {
+  if (!m_kernel_memo) return false;
+  for (unsigned n = 0; n < m_running_kernels.size(); n++)
+    if (m_running_kernels[n] && !m_running_kernels[n]->done()) return false;
+  if (active()) return false;
+
+  kernel_memo_entry entry;
+  if (!m_kernel_memo->lookup(
+          m_kernel_memo->fingerprint(*kinfo, get_global_memory()), entry))
+    return false;
+
+  unsigned long long now = gpu_tot_sim_cycle + gpu_sim_cycle;
+  unsigned uid = kinfo->get_uid();
+  kinfo->start_cycle = now;
+  kinfo->end_cycle = now + entry.cycles;
+  gpu_sim_cycle += entry.cycles;
+  gpu_sim_insn += entry.insn;
+  m_total_cta_launched += kinfo->num_blocks();
+  if (uid < m_config.get_max_concurrent_kernel()) {
+    gpu_sim_start_kernel_cycle[uid] = now;
+    gpu_sim_insn_per_kernel[uid] += entry.insn;
+  }
+  m_kernel_memo->inc_hits();
+  printf("GPGPU-Sim uArch: kernel %u '%s' replayed from kernel memo "
+         "(%llu cycles, %llu insn)\n",
+         uid, kinfo->name().c_str(), entry.cycles, entry.insn);
+
+  functional_launch(kinfo);
+  m_functional_memoized = true;
+  return true;
+}
+
+kernel_inst_trace *gpgpu_sim::get_inst_trace(unsigned kernel_uid) const {
+  std::map<unsigned, kernel_inst_trace *>::const_iterator t =
+      m_inst_traces.find(kernel_uid);
+  return t == m_inst_traces.end() ? NULL : t->second;
 }
 
 bool gpgpu_sim::can_start_kernel() {
@@ -790,6 +946,15 @@ void gpgpu_sim::set_kernel_done(kernel_info_t *kernel) {
   for (k = m_running_kernels.begin(); k != m_running_kernels.end(); k++) {
     if (*k == kernel) {
       kernel->end_cycle = gpu_sim_cycle + gpu_tot_sim_cycle;
+      if (m_kernel_memo)
+        m_kernel_memo->end(uid, kernel->name(), kernel->end_cycle,
+                           gpu_tot_sim_insn + gpu_sim_insn);
+      std::map<unsigned, kernel_inst_trace *>::iterator t =
+          m_inst_traces.find(uid);
+      if (t != m_inst_traces.end()) {
+        delete t->second;
+        m_inst_traces.erase(t);
+      }
       *k = NULL;
       break;
     }
@@ -798,6 +963,8 @@ void gpgpu_sim::set_kernel_done(kernel_info_t *kernel) {
 }
 
 void gpgpu_sim::stop_all_running_kernels() {
+  // kernels cut short must not be recorded as complete
+  if (m_kernel_memo) m_kernel_memo->cancel_pending();
   std::vector<kernel_info_t *>::iterator k;
   for (k = m_running_kernels.begin(); k != m_running_kernels.end(); ++k) {
     if (*k != NULL) {       // If a kernel is active
@@ -893,9 +1060,20 @@ gpgpu_sim::gpgpu_sim(const gpgpu_sim_config &config, gpgpu_context *ctx)
   gpu_sim_start_kernel_inst = new unsigned long long[config.get_max_concurrent_kernel()];
 
 
+  m_kernel_memo = NULL;
+  if (m_config.gpgpu_kernel_memo)
+    m_kernel_memo = new kernel_memo(m_config.gpgpu_kernel_memo_file,
+                                    m_config.gpgpu_kernel_memo_steady_state);
+
+  m_inst_trace_index = NULL;
+  if (m_config.gpgpu_inst_trace_mode == INST_TRACE_CAPTURE)
+    m_inst_trace_index =
+        new inst_trace_index(m_config.gpgpu_inst_trace_prefix);
+
   // Jin: functional simulation for CDP
   m_functional_sim = false;
   m_functional_sim_kernel = NULL;
+  m_functional_memoized = false;
 }
 
 int gpgpu_sim::shared_mem_size() const {
@@ -1071,6 +1249,33 @@ void gpgpu_sim::update_stats() {
   gpu_occupancy = occupancy_stats();
 }
 
+void gpgpu_sim::sample_power_stats() {
+  for (unsigned i = 0; i < m_memory_config->m_n_mem; i++)
+    m_memory_partition_unit[i]->set_dram_power_stats(
+        m_power_stats->pwr_mem_stat->n_cmd[CURRENT_STAT_IDX][i],
+        m_power_stats->pwr_mem_stat->n_activity[CURRENT_STAT_IDX][i],
+        m_power_stats->pwr_mem_stat->n_nop[CURRENT_STAT_IDX][i],
+        m_power_stats->pwr_mem_stat->n_act[CURRENT_STAT_IDX][i],
+        m_power_stats->pwr_mem_stat->n_pre[CURRENT_STAT_IDX][i],
+        m_power_stats->pwr_mem_stat->n_rd[CURRENT_STAT_IDX][i],
+        m_power_stats->pwr_mem_stat->n_wr[CURRENT_STAT_IDX][i],
+        m_power_stats->pwr_mem_stat->n_req[CURRENT_STAT_IDX][i]);
+
+  m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX].clear();
+  for (unsigned i = 0; i < m_memory_config->m_n_mem_sub_partition; i++)
+    m_memory_sub_partition[i]->accumulate_L2cache_stats(
+        m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
+
+  m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX].clear();
+  for (unsigned i = 0; i < m_shader_config->n_simt_clusters; i++) {
+    m_cluster[i]->get_icnt_stats(
+        m_power_stats->pwr_mem_stat->n_simt_to_mem[CURRENT_STAT_IDX][i],
+        m_power_stats->pwr_mem_stat->n_mem_to_simt[CURRENT_STAT_IDX][i]);
+    m_cluster[i]->get_cache_stats(
+        m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX]);
+  }
+}
+
 void gpgpu_sim::print_stats() {
   gpgpu_ctx->stats->ptx_file_line_stats_write_file();
   gpu_print_stat();
@@ -1361,6 +1566,7 @@ void gpgpu_sim::gpu_print_stat() {
  
  printf("gpu_tot_issued_cta = %lld\n",
          gpu_tot_issued_cta + m_total_cta_launched);
+  if (m_kernel_memo) m_kernel_memo->print(stdout);
   printf("gpu_occupancy = %.4f%% \n", gpu_occupancy.get_occ_fraction() * 100);
   printf("gpu_tot_occupancy = %.4f%% \n",
          (gpu_occupancy + gpu_tot_occupancy).get_occ_fraction() * 100);
@@ -1485,6 +1691,13 @@ void gpgpu_sim::gpu_print_stat() {
       l2_stats.print_fail_stats(stdout, "L2_cache_stats_fail_breakdown");
       total_l2_css.print_port_stats(stdout, "L2_cache");
     }
+    if (m_memory_config->l2_prefetcher != L2_PREFETCH_NONE) {
+      l2_prefetch_stats prefetch_stats;
+      for (unsigned i = 0; i < m_memory_config->m_n_mem_sub_partition; i++)
+        m_memory_sub_partition[i]->accumulate_L2_prefetch_stats(
+            prefetch_stats);
+      prefetch_stats.print(stdout);
+    }
   }
 
   if (m_config.gpgpu_cflog_interval != 0) {
@@ -1682,6 +1895,7 @@ void shader_core_ctx::release_shader_resource_1block(unsigned hw_ctaid,
  */
 
 void shader_core_ctx::issue_block2core(kernel_info_t &kernel) {
+  wake_up();
   if (!m_config->gpgpu_concurrent_kernel_sm)
     set_max_cta(kernel);
   else 
@@ -2164,7 +2378,8 @@ void gpgpu_sim::cycle() {
       if (mf) {
         unsigned response_size =
             mf->get_is_write() ? mf->get_ctrl_size() : mf->size();
-        if (::icnt_has_buffer(m_shader_config->mem2device(i), response_size)) {
+        if (::icnt_has_buffer(m_shader_config->mem2device(i), response_size,
+                              mf->get_kernel_id())) {
           // if (!mf->get_is_write())
           mf->set_return_timestamp(gpu_sim_cycle + gpu_tot_sim_cycle);
           mf->set_status(IN_ICNT_TO_SHADER, gpu_sim_cycle + gpu_tot_sim_cycle);
@@ -2189,23 +2404,12 @@ void gpgpu_sim::cycle() {
       else
         m_memory_partition_unit[i]
             ->dram_cycle();  // Issue the dram command (scheduler + delay model)
-      // Update performance counters for DRAM
-      m_memory_partition_unit[i]->set_dram_power_stats(
-          m_power_stats->pwr_mem_stat->n_cmd[CURRENT_STAT_IDX][i],
-          m_power_stats->pwr_mem_stat->n_activity[CURRENT_STAT_IDX][i],
-          m_power_stats->pwr_mem_stat->n_nop[CURRENT_STAT_IDX][i],
-          m_power_stats->pwr_mem_stat->n_act[CURRENT_STAT_IDX][i],
-          m_power_stats->pwr_mem_stat->n_pre[CURRENT_STAT_IDX][i],
-          m_power_stats->pwr_mem_stat->n_rd[CURRENT_STAT_IDX][i],
-          m_power_stats->pwr_mem_stat->n_wr[CURRENT_STAT_IDX][i],
-          m_power_stats->pwr_mem_stat->n_req[CURRENT_STAT_IDX][i]);
     }
   }
 
   // L2 operations follow L2 clock domain
   unsigned partiton_reqs_in_parallel_per_cycle = 0;
   if (clock_mask & L2) {
-    m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX].clear();
     for (unsigned i = 0; i < m_memory_config->m_n_mem_sub_partition; i++) {
       // move memory request from interconnect into memory partition (if not
       // backed up) Note:This needs to be called in DRAM clock domain if there
@@ -2219,8 +2423,6 @@ void gpgpu_sim::cycle() {
         if (mf) partiton_reqs_in_parallel_per_cycle++;
       }
       m_memory_sub_partition[i]->cache_cycle(gpu_sim_cycle + gpu_tot_sim_cycle);
-      m_memory_sub_partition[i]->accumulate_L2cache_stats(
-          m_power_stats->pwr_mem_stat->l2_cache_stats[CURRENT_STAT_IDX]);
     }
   }
   partiton_reqs_in_parallel += partiton_reqs_in_parallel_per_cycle;
@@ -2235,30 +2437,24 @@ void gpgpu_sim::cycle() {
 
   if (clock_mask & CORE) {
     // L1 cache + shader core pipeline stages
-    m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX].clear();
     for (unsigned i = 0; i < m_shader_config->n_simt_clusters; i++) {
       if (m_cluster[i]->get_not_completed() || get_more_cta_left()) {
         m_cluster[i]->core_cycle();
-        *active_sms += m_cluster[i]->get_n_active_sms();
+        if (m_config.g_power_simulation_enabled)
+          *active_sms += m_cluster[i]->get_n_active_sms();
       }
-      // Update core icnt/cache stats for GPUWattch
-      m_cluster[i]->get_icnt_stats(
-          m_power_stats->pwr_mem_stat->n_simt_to_mem[CURRENT_STAT_IDX][i],
-          m_power_stats->pwr_mem_stat->n_mem_to_simt[CURRENT_STAT_IDX][i]);
-      m_cluster[i]->get_cache_stats(
-          m_power_stats->pwr_mem_stat->core_cache_stats[CURRENT_STAT_IDX]);
-      m_cluster[i]->get_current_occupancy(
-          gpu_occupancy.aggregate_warp_slot_filled,
-          gpu_occupancy.aggregate_theoretical_warp_slots);
     }
-    float temp = 0;
-    for (unsigned i = 0; i < m_shader_config->num_shader(); i++) {
-      temp += m_shader_stats->m_pipeline_duty_cycle[i];
+    gpu_occupancy.aggregate_warp_slot_filled +=
+        m_shader_stats->m_active_warps_sum;
+    gpu_occupancy.aggregate_theoretical_warp_slots +=
+        m_shader_stats->m_occupied_warp_slots;
+    if (m_config.g_power_simulation_enabled) {
+      float max_committed_thread_instructions =
+          m_shader_config->warp_size * m_shader_config->pipe_widths[EX_WB];
+      *average_pipeline_duty_cycle +=
+          (float)m_shader_stats->m_pipeline_committed_sum /
+          max_committed_thread_instructions / m_shader_config->num_shader();
     }
-    temp = temp / m_shader_config->num_shader();
-    *average_pipeline_duty_cycle = ((*average_pipeline_duty_cycle) + temp);
-    // cout<<"Average pipeline duty cycle:
-    // "<<*average_pipeline_duty_cycle<<endl;
 
     if (g_single_step &&
         ((gpu_sim_cycle + gpu_tot_sim_cycle) >= g_single_step)) {
@@ -2271,6 +2467,11 @@ void gpgpu_sim::cycle() {
       // McPAT main cycle (interface with McPAT)
 #ifdef GPGPUSIM_POWER_MODEL
     if (m_config.g_power_simulation_enabled) {
+      // the power counters are only read by McPAT on sample boundaries
+      if ((unsigned)(gpu_tot_sim_cycle + gpu_sim_cycle) %
+              m_config.gpu_stat_sample_freq ==
+          0)
+        sample_power_stats();
       mcpat_cycle(m_config, getShaderCoreConfig(), m_gpgpusim_wrapper,
                   m_power_stats, m_config.gpu_stat_sample_freq,
                   gpu_tot_sim_cycle, gpu_sim_cycle, gpu_tot_sim_insn,
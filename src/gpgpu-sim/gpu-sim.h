@@ -38,6 +38,7 @@
 #include "../trace.h"
 #include "addrdec.h"
 #include "gpu-cache.h"
+#include "l2_prefetcher.h"
 #include "shader.h"
 
 // constants for statistics printouts
@@ -64,10 +65,16 @@
 
 class gpgpu_context;
 
-extern tr1_hash_map<new_addr_type, unsigned> address_random_interleaving;
-
 enum dram_ctrl_t { DRAM_FIFO = 0, DRAM_FRFCFS = 1 };
 
+enum dram_refresh_mode_t { DRAM_REF_ALL_BANK = 0, DRAM_REF_PER_BANK = 1 };
+
+enum dram_refresh_policy_t {
+  DRAM_REF_EAGER = 0,    // refresh as soon as it is due
+  DRAM_REF_DEFER = 1,    // postpone while requests are pending
+  DRAM_REF_ELASTIC = 2,  // postpone under load, pull in when idle
+};
+
 struct power_config {
   power_config() { m_valid = true; }
   void init() {
@@ -148,6 +155,17 @@ class memory_config {
       nbkgrp = 1;
       tCCDL = 0;
       tRTPL = 0;
+      // Refresh and power-down are only available with named options
+      tREFI = 0;
+      tRFC = 0;
+      tRFCpb = 0;
+      refresh_mode = DRAM_REF_ALL_BANK;
+      refresh_policy = DRAM_REF_EAGER;
+      refresh_max_postpone = 0;
+      power_down_idle = 0;
+      tXP = 0;
+      self_refresh_idle = 0;
+      tXS = 0;
       sscanf(gpgpu_dram_timing_opt, "%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d:%d",
              &nbk, &tCCD, &tRRD, &tRCD, &tRAS, &tRP, &tRC, &CL, &WL, &tCDLR,
              &tWR, &nbkgrp, &tCCDL, &tRTPL);
@@ -192,6 +210,39 @@ class memory_config {
           "read to precharge delay between accesses to different bank groups",
           "0");
 
+      // Refresh is disabled unless REFI is specified
+      option_parser_register(dram_opp, "REFI", OPT_UINT32, &tREFI,
+                             "average refresh interval (0 = no refresh)", "0");
+      option_parser_register(dram_opp, "RFC", OPT_UINT32, &tRFC,
+                             "all-bank refresh cycle time", "0");
+      option_parser_register(dram_opp, "RFCpb", OPT_UINT32, &tRFCpb,
+                             "per-bank refresh cycle time", "0");
+      option_parser_register(dram_opp, "REFmode", OPT_UINT32, &refresh_mode,
+                             "refresh granularity (0 = all-bank, 1 = per-bank "
+                             "round robin every REFI/nbk)",
+                             "0");
+      option_parser_register(dram_opp, "REFpolicy", OPT_UINT32,
+                             &refresh_policy,
+                             "refresh scheduling (0 = eager, 1 = defer under "
+                             "load, 2 = defer under load and pull in when idle)",
+                             "0");
+      option_parser_register(
+          dram_opp, "REFpostpone", OPT_UINT32, &refresh_max_postpone,
+          "max refreshes that can be postponed or pulled in", "8");
+
+      // Power-down is disabled unless an idle threshold is specified
+      option_parser_register(dram_opp, "PDidle", OPT_UINT32, &power_down_idle,
+                             "idle cycles before power-down entry (0 = off)",
+                             "0");
+      option_parser_register(dram_opp, "XP", OPT_UINT32, &tXP,
+                             "power-down exit latency", "0");
+      option_parser_register(dram_opp, "SRidle", OPT_UINT32,
+                             &self_refresh_idle,
+                             "idle cycles before self-refresh entry (0 = off)",
+                             "0");
+      option_parser_register(dram_opp, "XS", OPT_UINT32, &tXS,
+                             "self-refresh exit latency", "0");
+
       option_parser_delimited_string(dram_opp, gpgpu_dram_timing_opt, "=:;");
       fprintf(stdout, "DRAM Timing Options:\n");
       option_parser_print(dram_opp, stdout);
@@ -214,6 +265,26 @@ class memory_config {
       tWTR = (WL + (BL / data_command_freq_ratio) + tCDLR);
     }
     tWTP = (WL + (BL / data_command_freq_ratio) + tWR);
+    if (tREFI) {
+      if (refresh_mode == DRAM_REF_PER_BANK) {
+        if (tREFI < nbk) {
+          printf("GPGPU-Sim uArch: error: REFI=%u is shorter than one cycle "
+                 "per bank for per-bank refresh\n",
+                 tREFI);
+          abort();
+        }
+        if (tRFCpb == 0) tRFCpb = tRFC;
+      } else if (refresh_mode != DRAM_REF_ALL_BANK) {
+        printf("GPGPU-Sim uArch: error: unknown DRAM REFmode %u\n",
+               refresh_mode);
+        abort();
+      }
+      if (refresh_policy > DRAM_REF_ELASTIC) {
+        printf("GPGPU-Sim uArch: error: unknown DRAM REFpolicy %u\n",
+               refresh_policy);
+        abort();
+      }
+    }
     dram_atom_size =
         BL * busW * gpu_n_mem_per_ctrlr;  // burst length x bus width x # chips
                                           // per partition
@@ -229,6 +300,23 @@ class memory_config {
     m_address_mapping.init(m_n_mem, m_n_sub_partition_per_memory_channel);
     m_L2_config.init(&m_address_mapping);
 
+    if (l2_prefetcher != L2_PREFETCH_NONE) {
+      if (m_L2_config.disabled()) {
+        printf("GPGPU-Sim uArch: ERROR ** L2 prefetcher needs an L2 cache\n");
+        abort();
+      }
+      if (!m_address_mapping.has_raw_address()) {
+        printf("GPGPU-Sim uArch: ERROR ** L2 prefetcher cannot map blocks back "
+               "to addresses with -memory_partition_indexing 4 (random)\n");
+        abort();
+      }
+      if (!l2_prefetch_degree || !l2_prefetch_queue_size) {
+        printf("GPGPU-Sim uArch: ERROR ** L2 prefetch degree and queue size "
+               "must be non-zero\n");
+        abort();
+      }
+    }
+
     m_valid = true;
 
     sscanf(write_queue_size_opt, "%d:%d:%d",
@@ -277,6 +365,17 @@ class memory_config {
                    // read)
   unsigned tWR;    // Last data-in to Row precharge
 
+  unsigned tREFI;   // average refresh interval (0 disables refresh)
+  unsigned tRFC;    // all-bank refresh cycle time
+  unsigned tRFCpb;  // per-bank refresh cycle time
+  unsigned refresh_mode;          // enum dram_refresh_mode_t
+  unsigned refresh_policy;        // enum dram_refresh_policy_t
+  unsigned refresh_max_postpone;  // refreshes that may be postponed/pulled in
+  unsigned power_down_idle;       // idle cycles before power-down entry
+  unsigned tXP;                   // power-down exit latency
+  unsigned self_refresh_idle;     // idle cycles before self-refresh entry
+  unsigned tXS;                   // self-refresh exit latency
+
   unsigned CL;    // CAS latency
   unsigned WL;    // WRITE latency
   unsigned BL;    // Burst Length in bytes (4 in GDDR3, 8 in GDDR5)
@@ -315,6 +414,12 @@ class memory_config {
   bool m_perf_sim_memcpy;
   bool simple_dram_model;
 
+  enum l2_prefetcher_type l2_prefetcher;
+  unsigned l2_prefetch_degree;
+  unsigned l2_prefetch_distance;
+  unsigned l2_prefetch_streams;
+  unsigned l2_prefetch_queue_size;
+
   gpgpu_context *gpgpu_ctx;
 };
 
@@ -362,6 +467,10 @@ class gpgpu_sim_config : public power_config,
   unsigned num_shader() const { return m_shader_config.num_shader(); }
   unsigned num_cluster() const { return m_shader_config.n_simt_clusters; }
   unsigned get_max_concurrent_kernel() const { return max_concurrent_kernel; }
+  int get_inst_trace_mode() const { return gpgpu_inst_trace_mode; }
+  const char *get_inst_trace_prefix() const {
+    return gpgpu_inst_trace_prefix;
+  }
   unsigned checkpoint_option;
 
   size_t stack_limit() const { return stack_size_limit; }
@@ -404,6 +513,11 @@ class gpgpu_sim_config : public power_config,
   int gpgpu_cflog_interval;
   char *gpgpu_clock_domains;
   unsigned max_concurrent_kernel;
+  bool gpgpu_kernel_memo;
+  char *gpgpu_kernel_memo_file;
+  bool gpgpu_kernel_memo_steady_state;
+  int gpgpu_inst_trace_mode;
+  char *gpgpu_inst_trace_prefix;
 
   // visualizer
   bool g_visualizer_enabled;
@@ -497,6 +611,14 @@ class gpgpu_sim : public gpgpu_t {
   void set_prop(struct cudaDeviceProp *prop);
 
   void launch(kernel_info_t *kinfo);
+  // replay a launch from the kernel memo; false if it must be timed
+  bool launch_memoized(kernel_info_t *kinfo);
+  // instruction trace of a running kernel, NULL when tracing is off
+  class kernel_inst_trace *get_inst_trace(unsigned kernel_uid) const;
+  // index of PTX modules and launches, NULL unless capturing a trace
+  class inst_trace_index *get_inst_trace_index() const {
+    return m_inst_trace_index;
+  }
   bool can_start_kernel();
   unsigned finished_kernel();
   void set_kernel_done(kernel_info_t *kernel);
@@ -521,6 +643,8 @@ class gpgpu_sim : public gpgpu_t {
   void print_only_ipc_stats(kernel_info_t *kernel);
 
   void update_stats();
+  // reduce the per-unit power counters into m_power_stats for McPAT
+  void sample_power_stats();
   void deadlock_check();
   void inc_completed_cta() { gpu_completed_cta++; }
   void get_pdom_stack_top_info(unsigned sid, unsigned tid, unsigned *pc,
@@ -649,6 +773,9 @@ class gpgpu_sim : public gpgpu_t {
   class memory_stats_t *m_memory_stats;
   class power_stat_t *m_power_stats;
   class gpgpu_sim_wrapper *m_gpgpusim_wrapper;
+  class kernel_memo *m_kernel_memo;
+  std::map<unsigned, class kernel_inst_trace *> m_inst_traces;
+  class inst_trace_index *m_inst_trace_index;
   unsigned long long last_gpu_sim_insn;
   //Nico
   double prev_ws; // previous weighted speedup of conrrung kernels 
@@ -710,9 +837,12 @@ class gpgpu_sim : public gpgpu_t {
   // set by stream operation every time a functoinal simulation is done
   bool m_functional_sim;
   kernel_info_t *m_functional_sim_kernel;
+  // the functional kernel stands in for a memoized timing launch
+  bool m_functional_memoized;
 
  public:
   bool is_functional_sim() { return m_functional_sim; }
+  bool is_memoized_sim() { return m_functional_memoized; }
   kernel_info_t *get_functional_kernel() { return m_functional_sim_kernel; }
   void functional_launch(kernel_info_t *k) {
     m_functional_sim = true;
@@ -723,6 +853,7 @@ class gpgpu_sim : public gpgpu_t {
     assert(m_functional_sim_kernel == k);
     m_functional_sim = false;
     m_functional_sim_kernel = NULL;
+    m_functional_memoized = false;
   }
 };
 
@@ -0,0 +1,113 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "icnt_trace.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+icnt_trace_writer::icnt_trace_writer(const char *filename)
+    : m_filename(filename), m_next_id(0) {
+  m_file = fopen(filename, "wb");
+  if (!m_file) {
+    printf("GPGPU-Sim: cannot open interconnect trace '%s' for writing\n",
+           filename);
+    abort();
+  }
+}
+
+icnt_trace_writer::~icnt_trace_writer() { fclose(m_file); }
+
+void icnt_trace_writer::begin(unsigned n_shader, unsigned n_mem) {
+  icnt_trace_header h;
+  memset(&h, 0, sizeof(h));
+  strncpy(h.magic, ICNT_TRACE_MAGIC, sizeof(h.magic));
+  h.version = ICNT_TRACE_VERSION;
+  h.n_shader = n_shader;
+  h.n_mem = n_mem;
+  fwrite(&h, sizeof(h), 1, m_file);
+  printf("GPGPU-Sim: recording interconnect traffic to %s\n", m_filename);
+}
+
+void icnt_trace_writer::write(const icnt_trace_record &r) {
+  if (fwrite(&r, sizeof(r), 1, m_file) != 1) {
+    printf("GPGPU-Sim: error writing interconnect trace '%s'\n", m_filename);
+    abort();
+  }
+}
+
+void icnt_trace_writer::push(unsigned long long cycle, unsigned src,
+                             unsigned dst, unsigned size, unsigned kernel_id,
+                             unsigned type, void *data) {
+  icnt_trace_record r;
+  memset(&r, 0, sizeof(r));
+  r.cycle = cycle;
+  r.id = m_next_id++;
+  r.src = src;
+  r.dst = dst;
+  r.size = size;
+  r.kernel_id = kernel_id;
+  r.event = ICNT_TRACE_PUSH;
+  r.type = type;
+  write(r);
+  m_in_flight[data] = r;
+}
+
+void icnt_trace_writer::pop(unsigned long long cycle, unsigned dst,
+                            void *data) {
+  std::map<void *, icnt_trace_record>::iterator i = m_in_flight.find(data);
+  assert(i != m_in_flight.end());
+  icnt_trace_record r = i->second;
+  m_in_flight.erase(i);
+  assert(r.dst == dst);
+  r.cycle = cycle;
+  r.event = ICNT_TRACE_POP;
+  write(r);
+}
+
+icnt_trace_reader::icnt_trace_reader(const char *filename) {
+  m_file = fopen(filename, "rb");
+  if (!m_file) {
+    printf("GPGPU-Sim: cannot open interconnect trace '%s'\n", filename);
+    abort();
+  }
+  if (fread(&m_header, sizeof(m_header), 1, m_file) != 1 ||
+      strncmp(m_header.magic, ICNT_TRACE_MAGIC, sizeof(m_header.magic)) ||
+      m_header.version != ICNT_TRACE_VERSION) {
+    printf("GPGPU-Sim: '%s' is not an interconnect trace (version %u)\n",
+           filename, ICNT_TRACE_VERSION);
+    abort();
+  }
+}
+
+icnt_trace_reader::~icnt_trace_reader() { fclose(m_file); }
+
+bool icnt_trace_reader::next(icnt_trace_record &r) {
+  return fread(&r, sizeof(r), 1, m_file) == 1;
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef ICNT_TRACE_H
+#define ICNT_TRACE_H
+
+#include <stdio.h>
+#include <map>
+
+// Binary trace of the traffic crossing the icnt_push/icnt_pop boundary,
+// written with -icnt_trace_record and replayed by debug_tools/icnt_replay.
+//
+// The file is an icnt_trace_header followed by one icnt_trace_record per
+// push or pop, in the order they happened. Cycles count icnt_transfer()
+// calls, i.e. interconnect clock cycles.
+
+#define ICNT_TRACE_MAGIC "ICNTTRC"
+#define ICNT_TRACE_VERSION 1
+
+enum icnt_trace_event { ICNT_TRACE_PUSH = 0, ICNT_TRACE_POP = 1 };
+
+struct icnt_trace_header {
+  char magic[8];
+  unsigned version;
+  unsigned n_shader;
+  unsigned n_mem;
+  unsigned reserved;
+};
+
+struct icnt_trace_record {
+  unsigned long long cycle;
+  unsigned id;  // packet number, shared by a push and its pop
+  unsigned short src;
+  unsigned short dst;
+  unsigned short size;
+  unsigned short kernel_id;
+  unsigned char event;  // icnt_trace_event
+  unsigned char type;   // mf_type of the packet
+  unsigned short reserved;
+};
+
+class icnt_trace_writer {
+ public:
+  icnt_trace_writer(const char *filename);
+  ~icnt_trace_writer();
+
+  void begin(unsigned n_shader, unsigned n_mem);
+  void push(unsigned long long cycle, unsigned src, unsigned dst,
+            unsigned size, unsigned kernel_id, unsigned type, void *data);
+  // pop records repeat the fields of the matching push
+  void pop(unsigned long long cycle, unsigned dst, void *data);
+
+ private:
+  void write(const icnt_trace_record &r);
+
+  FILE *m_file;
+  const char *m_filename;
+  unsigned m_next_id;
+  std::map<void *, icnt_trace_record> m_in_flight;
+};
+
+class icnt_trace_reader {
+ public:
+  icnt_trace_reader(const char *filename);
+  ~icnt_trace_reader();
+
+  const icnt_trace_header &header() const { return m_header; }
+  // false at the end of the trace
+  bool next(icnt_trace_record &r);
+
+ private:
+  FILE *m_file;
+  icnt_trace_header m_header;
+};
+
+#endif
@@ -28,9 +28,14 @@
 
 #include "icnt_wrapper.h"
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
 #include "../intersim2/globals.hpp"
 #include "../intersim2/interconnect_interface.hpp"
+#include "analytical_interconnect.h"
+#include "icnt_trace.h"
 #include "local_interconnect.h"
+#include "mem_fetch.h"
 
 icnt_create_p icnt_create;
 icnt_init_p icnt_init;
@@ -44,30 +49,114 @@ icnt_display_overall_stats_p icnt_display_overall_stats;
 icnt_display_state_p icnt_display_state;
 icnt_get_flit_size_p icnt_get_flit_size;
 
+typedef void (*icnt_set_qos_weight_p)(unsigned qos_class, unsigned weight);
+static icnt_set_qos_weight_p icnt_backend_set_qos_weight;
+
 unsigned g_network_mode;
 char* g_network_config_filename;
 
 struct inct_config g_inct_config;
 LocalInterconnect* g_localicnt_interface;
 
+struct anicnt_config g_anicnt_config;
+AnalyticalInterconnect* g_anicnt_interface;
+
 #include "../option_parser.h"
 
+unsigned g_icnt_qos_classes;
+static char* g_icnt_qos_weights_str;
+static std::vector<unsigned> g_icnt_qos_weights;
+static std::vector<unsigned> g_icnt_kernel_qos_class;  // 0 = default mapping
+
+unsigned icnt_qos_class(unsigned kernel_id) {
+  if (g_icnt_qos_classes <= 1) return 0;
+  if (kernel_id < g_icnt_kernel_qos_class.size() &&
+      g_icnt_kernel_qos_class[kernel_id])
+    return g_icnt_kernel_qos_class[kernel_id] - 1;
+  return kernel_id % g_icnt_qos_classes;
+}
+
+void icnt_set_kernel_qos_class(unsigned kernel_id, unsigned qos_class) {
+  assert(qos_class < g_icnt_qos_classes);
+  if (kernel_id >= g_icnt_kernel_qos_class.size())
+    g_icnt_kernel_qos_class.resize(kernel_id + 1, 0);
+  g_icnt_kernel_qos_class[kernel_id] = qos_class + 1;
+}
+
+const std::vector<unsigned>& icnt_qos_weights() { return g_icnt_qos_weights; }
+
+void icnt_set_qos_weight(unsigned qos_class, unsigned weight) {
+  assert(qos_class < g_icnt_qos_classes);
+  g_icnt_qos_weights[qos_class] = weight;
+  icnt_backend_set_qos_weight(qos_class, weight);
+}
+
+// pushes the configured weights into a freshly created backend
+static void icnt_qos_apply_weights() {
+  for (unsigned c = 0; c < g_icnt_qos_classes; ++c)
+    icnt_backend_set_qos_weight(c, g_icnt_qos_weights[c]);
+}
+
+static unsigned mem_fetch_kernel_id(void* data) {
+  return static_cast<mem_fetch*>(data)->get_kernel_id();
+}
+
+static unsigned mem_fetch_type(void* data) {
+  return static_cast<mem_fetch*>(data)->get_type();
+}
+
+static icnt_packet_kernel_id_p icnt_packet_kernel_id = mem_fetch_kernel_id;
+static icnt_packet_type_p icnt_packet_type = mem_fetch_type;
+
+void icnt_set_packet_accessors(icnt_packet_kernel_id_p kernel_id,
+                               icnt_packet_type_p type) {
+  icnt_packet_kernel_id = kernel_id;
+  icnt_packet_type = type;
+}
+
+static unsigned qos_class_of(void* data) {
+  return icnt_qos_class(icnt_packet_kernel_id(data));
+}
+
+static void icnt_qos_init() {
+  if (g_icnt_qos_classes == 0) g_icnt_qos_classes = 1;
+  assert(g_icnt_qos_classes <= 32);
+  // "-icnt_qos_weights 3,1": missing entries repeat the last weight
+  g_icnt_qos_weights.assign(g_icnt_qos_classes, 1);
+  char* weights = strdup(g_icnt_qos_weights_str);
+  char* save = NULL;
+  unsigned last = 1;
+  unsigned c = 0;
+  for (char* tok = strtok_r(weights, ",", &save); tok;
+       tok = strtok_r(NULL, ",", &save)) {
+    if (c < g_icnt_qos_classes) g_icnt_qos_weights[c++] = last = atoi(tok);
+  }
+  for (; c < g_icnt_qos_classes; ++c) g_icnt_qos_weights[c] = last;
+  free(weights);
+}
+
 // Wrapper to intersim2 to accompany old icnt_wrapper
 // TODO: use delegate/boost/c++11<funtion> instead
 
 static void intersim2_create(unsigned int n_shader, unsigned int n_mem) {
-  g_icnt_interface->CreateInterconnect(n_shader, n_mem);
+  g_icnt_interface->CreateInterconnect(n_shader, n_mem,
+                                       g_icnt_qos_classes);
+  icnt_qos_apply_weights();
 }
 
-static void intersim2_init() { g_icnt_interface->Init(); }
+static void intersim2_init() {
+  g_icnt_interface->SetPacketTypeFunc(icnt_packet_type);
+  g_icnt_interface->Init();
+}
 
-static bool intersim2_has_buffer(unsigned input, unsigned int size) {
-  return g_icnt_interface->HasBuffer(input, size);
+static bool intersim2_has_buffer(unsigned input, unsigned int size,
+                                 unsigned kernel_id) {
+  return g_icnt_interface->HasBuffer(input, size, icnt_qos_class(kernel_id));
 }
 
 static void intersim2_push(unsigned input, unsigned output, void* data,
                            unsigned int size) {
-  g_icnt_interface->Push(input, output, data, size);
+  g_icnt_interface->Push(input, output, data, size, qos_class_of(data));
 }
 
 static void* intersim2_pop(unsigned output) {
@@ -92,22 +181,30 @@ static unsigned intersim2_get_flit_size() {
   return g_icnt_interface->GetFlitSize();
 }
 
+static void intersim2_set_qos_weight(unsigned qos_class, unsigned weight) {
+  g_icnt_interface->SetQoSWeight(qos_class, weight);
+}
+
 //////////////////////////////////////////////////////
 
 static void LocalInterconnect_create(unsigned int n_shader,
                                      unsigned int n_mem) {
-  g_localicnt_interface->CreateInterconnect(n_shader, n_mem);
+  g_localicnt_interface->CreateInterconnect(n_shader, n_mem,
+                                            g_icnt_qos_classes);
+  icnt_qos_apply_weights();
 }
 
 static void LocalInterconnect_init() { g_localicnt_interface->Init(); }
 
-static bool LocalInterconnect_has_buffer(unsigned input, unsigned int size) {
-  return g_localicnt_interface->HasBuffer(input, size);
+static bool LocalInterconnect_has_buffer(unsigned input, unsigned int size,
+                                         unsigned kernel_id) {
+  return g_localicnt_interface->HasBuffer(input, size,
+                                          icnt_qos_class(kernel_id));
 }
 
 static void LocalInterconnect_push(unsigned input, unsigned output, void* data,
                                    unsigned int size) {
-  g_localicnt_interface->Push(input, output, data, size);
+  g_localicnt_interface->Push(input, output, data, size, qos_class_of(data));
 }
 
 static void* LocalInterconnect_pop(unsigned output) {
@@ -134,6 +231,112 @@ static unsigned LocalInterconnect_get_flit_size() {
   return g_localicnt_interface->GetFlitSize();
 }
 
+static void LocalInterconnect_set_qos_weight(unsigned qos_class,
+                                             unsigned weight) {
+  g_localicnt_interface->SetQoSWeight(qos_class, weight);
+}
+
+//////////////////////////////////////////////////////
+
+static void AnalyticalInterconnect_create(unsigned int n_shader,
+                                          unsigned int n_mem) {
+  g_anicnt_interface->CreateInterconnect(n_shader, n_mem);
+}
+
+static void AnalyticalInterconnect_init() { g_anicnt_interface->Init(); }
+
+static bool AnalyticalInterconnect_has_buffer(unsigned input,
+                                              unsigned int size,
+                                              unsigned kernel_id) {
+  return g_anicnt_interface->HasBuffer(input, size);
+}
+
+static void AnalyticalInterconnect_push(unsigned input, unsigned output,
+                                        void* data, unsigned int size) {
+  g_anicnt_interface->Push(input, output, data, size);
+}
+
+static void* AnalyticalInterconnect_pop(unsigned output) {
+  return g_anicnt_interface->Pop(output);
+}
+
+static void AnalyticalInterconnect_transfer() {
+  g_anicnt_interface->Advance();
+}
+
+static bool AnalyticalInterconnect_busy() {
+  return g_anicnt_interface->Busy();
+}
+
+static void AnalyticalInterconnect_display_stats() {
+  g_anicnt_interface->DisplayStats();
+}
+
+static void AnalyticalInterconnect_display_overall_stats() {
+  g_anicnt_interface->DisplayOverallStats();
+}
+
+static void AnalyticalInterconnect_display_state(FILE* fp) {
+  g_anicnt_interface->DisplayState(fp);
+}
+
+static unsigned AnalyticalInterconnect_get_flit_size() {
+  return g_anicnt_interface->GetFlitSize();
+}
+
+// the analytical model has no arbiters, so QoS weights do not apply
+static void AnalyticalInterconnect_set_qos_weight(unsigned qos_class,
+                                                  unsigned weight) {}
+
+//////////////////////////////////////////////////////
+
+// -icnt_trace_record: the backend functions are wrapped to log every push
+// and pop with the interconnect cycle it happened in
+static char* g_icnt_trace_record;
+static icnt_trace_writer* g_icnt_trace_writer;
+static unsigned long long g_icnt_trace_cycle;
+static icnt_create_p icnt_backend_create;
+static icnt_push_p icnt_backend_push;
+static icnt_pop_p icnt_backend_pop;
+static icnt_transfer_p icnt_backend_transfer;
+
+static void icnt_record_create(unsigned int n_shader, unsigned int n_mem) {
+  icnt_backend_create(n_shader, n_mem);
+  g_icnt_trace_writer->begin(n_shader, n_mem);
+}
+
+static void icnt_record_push(unsigned input, unsigned output, void* data,
+                             unsigned int size) {
+  icnt_backend_push(input, output, data, size);
+  g_icnt_trace_writer->push(g_icnt_trace_cycle, input, output, size,
+                            icnt_packet_kernel_id(data),
+                            icnt_packet_type(data), data);
+}
+
+static void* icnt_record_pop(unsigned output) {
+  void* data = icnt_backend_pop(output);
+  if (data) g_icnt_trace_writer->pop(g_icnt_trace_cycle, output, data);
+  return data;
+}
+
+static void icnt_record_transfer() {
+  icnt_backend_transfer();
+  ++g_icnt_trace_cycle;
+}
+
+static void icnt_record_init() {
+  g_icnt_trace_writer = new icnt_trace_writer(g_icnt_trace_record);
+  g_icnt_trace_cycle = 0;
+  icnt_backend_create = icnt_create;
+  icnt_backend_push = icnt_push;
+  icnt_backend_pop = icnt_pop;
+  icnt_backend_transfer = icnt_transfer;
+  icnt_create = icnt_record_create;
+  icnt_push = icnt_record_push;
+  icnt_pop = icnt_record_pop;
+  icnt_transfer = icnt_record_transfer;
+}
+
 ///////////////////////////
 
 void icnt_reg_options(class OptionParser* opp) {
@@ -154,9 +357,43 @@ void icnt_reg_options(class OptionParser* opp) {
                          &g_inct_config.subnets, "subnets", "2");
   option_parser_register(opp, "-arbiter_algo", OPT_UINT32,
                          &g_inct_config.arbiter_algo, "arbiter_algo", "1");
+
+  // kernel-aware QoS (local xbar and intersim2)
+  option_parser_register(opp, "-icnt_qos_classes", OPT_UINT32,
+                         &g_icnt_qos_classes,
+                         "number of per-kernel interconnect traffic classes",
+                         "1");
+  option_parser_register(opp, "-icnt_qos_weights", OPT_CSTR,
+                         &g_icnt_qos_weights_str,
+                         "arbitration weight of each traffic class "
+                         "(comma separated)",
+                         "1");
+
+  // parameters for the analytical model; the latency and bandwidth defaults
+  // are the best fit to the local iSLIP xbar found by
+  // debug_tools/xbar_bench/anicnt_calib
+  option_parser_register(opp, "-anicnt_latency", OPT_UINT32,
+                         &g_anicnt_config.latency,
+                         "analytical icnt pipeline latency (cycles)", "0");
+  option_parser_register(opp, "-anicnt_port_bandwidth", OPT_UINT32,
+                         &g_anicnt_config.port_bandwidth,
+                         "analytical icnt bytes per cycle per port", "136");
+  option_parser_register(opp, "-anicnt_in_buffer_limit", OPT_UINT32,
+                         &g_anicnt_config.in_buffer_limit,
+                         "analytical icnt packets in flight per input", "64");
+  option_parser_register(opp, "-anicnt_subnets", OPT_UINT32,
+                         &g_anicnt_config.subnets, "analytical icnt subnets",
+                         "2");
+
+  option_parser_register(opp, "-icnt_trace_record", OPT_CSTR,
+                         &g_icnt_trace_record,
+                         "record interconnect pushes and pops to this file "
+                         "(for debug_tools/icnt_replay)",
+                         NULL);
 }
 
 void icnt_wrapper_init() {
+  icnt_qos_init();
   switch (g_network_mode) {
     case INTERSIM:
       // FIXME: delete the object: may add icnt_done wrapper
@@ -172,6 +409,7 @@ void icnt_wrapper_init() {
       icnt_display_overall_stats = intersim2_display_overall_stats;
       icnt_display_state = intersim2_display_state;
       icnt_get_flit_size = intersim2_get_flit_size;
+      icnt_backend_set_qos_weight = intersim2_set_qos_weight;
       break;
     case LOCAL_XBAR:
       g_localicnt_interface = LocalInterconnect::New(g_inct_config);
@@ -186,9 +424,27 @@ void icnt_wrapper_init() {
       icnt_display_overall_stats = LocalInterconnect_display_overall_stats;
       icnt_display_state = LocalInterconnect_display_state;
       icnt_get_flit_size = LocalInterconnect_get_flit_size;
+      icnt_backend_set_qos_weight = LocalInterconnect_set_qos_weight;
+      break;
+    case ANALYTICAL:
+      g_anicnt_interface = AnalyticalInterconnect::New(g_anicnt_config);
+      icnt_create = AnalyticalInterconnect_create;
+      icnt_init = AnalyticalInterconnect_init;
+      icnt_has_buffer = AnalyticalInterconnect_has_buffer;
+      icnt_push = AnalyticalInterconnect_push;
+      icnt_pop = AnalyticalInterconnect_pop;
+      icnt_transfer = AnalyticalInterconnect_transfer;
+      icnt_busy = AnalyticalInterconnect_busy;
+      icnt_display_stats = AnalyticalInterconnect_display_stats;
+      icnt_display_overall_stats =
+          AnalyticalInterconnect_display_overall_stats;
+      icnt_display_state = AnalyticalInterconnect_display_state;
+      icnt_get_flit_size = AnalyticalInterconnect_get_flit_size;
+      icnt_backend_set_qos_weight = AnalyticalInterconnect_set_qos_weight;
       break;
     default:
       assert(0);
       break;
   }
+  if (g_icnt_trace_record && g_icnt_trace_record[0]) icnt_record_init();
 }
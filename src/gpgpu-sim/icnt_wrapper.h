@@ -30,12 +30,14 @@
 #define ICNT_WRAPPER_H
 
 #include <stdio.h>
+#include <vector>
 
 // functional interface to the interconnect
 
 typedef void (*icnt_create_p)(unsigned n_shader, unsigned n_mem);
 typedef void (*icnt_init_p)();
-typedef bool (*icnt_has_buffer_p)(unsigned input, unsigned int size);
+typedef bool (*icnt_has_buffer_p)(unsigned input, unsigned int size,
+                                  unsigned kernel_id);
 typedef void (*icnt_push_p)(unsigned input, unsigned output, void* data,
                             unsigned int size);
 typedef void* (*icnt_pop_p)(unsigned output);
@@ -61,9 +63,34 @@ extern icnt_display_state_p icnt_display_state;
 extern icnt_get_flit_size_p icnt_get_flit_size;
 extern unsigned g_network_mode;
 
-enum network_mode { INTERSIM = 1, LOCAL_XBAR = 2, N_NETWORK_MODE };
+enum network_mode {
+  INTERSIM = 1,
+  LOCAL_XBAR = 2,
+  ANALYTICAL = 3,
+  N_NETWORK_MODE
+};
 
 void icnt_wrapper_init();
 void icnt_reg_options(class OptionParser* opp);
 
+// Kernel-aware QoS: packets are mapped to traffic classes by the kernel that
+// issued them. Each class gets its own injection buffer quota and classes
+// share bandwidth by weighted round robin. With -icnt_qos_classes 1 (the
+// default) every packet is in class 0 and arbitration is unchanged.
+extern unsigned g_icnt_qos_classes;
+unsigned icnt_qos_class(unsigned kernel_id);
+void icnt_set_kernel_qos_class(unsigned kernel_id, unsigned qos_class);
+const std::vector<unsigned>& icnt_qos_weights();
+// may be called at any time, e.g. by the SMK controller between kernels
+void icnt_set_qos_weight(unsigned qos_class, unsigned weight);
+
+// The interconnect only looks inside the packets it carries through these
+// accessors. By default packets are mem_fetch objects; standalone users of
+// the interconnect (debug_tools/icnt_replay) install their own before
+// icnt_wrapper_init().
+typedef unsigned (*icnt_packet_kernel_id_p)(void* data);
+typedef unsigned (*icnt_packet_type_p)(void* data);  // an mf_type
+void icnt_set_packet_accessors(icnt_packet_kernel_id_p kernel_id,
+                               icnt_packet_type_p type);
+
 #endif
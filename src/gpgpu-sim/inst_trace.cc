@@ -0,0 +1,271 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "inst_trace.h"
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../cuda-sim/ptx_ir.h"
+
+static const unsigned INST_TRACE_MAGIC = 0x54535047;  // "GPST"
+static const unsigned INST_TRACE_VERSION = 2;
+
+void warp_trace_t::get(void *dst, size_t n) {
+  if (m_pos + n > m_data.size()) {
+    printf(
+        "GPGPU-Sim uArch: ERROR instruction trace of cta %u warp %u ended "
+        "before the warp finished\n",
+        m_ctaid, m_warp);
+    abort();
+  }
+  memcpy(dst, &m_data[m_pos], n);
+  m_pos += n;
+}
+
+static void gz_read_exact(gzFile f, void *dst, unsigned n,
+                          const std::string &filename) {
+  if (gzread(f, dst, n) != (int)n) {
+    printf("GPGPU-Sim uArch: ERROR truncated instruction trace %s\n",
+           filename.c_str());
+    abort();
+  }
+}
+
+static std::string trace_filename(const char *prefix, unsigned kernel_uid) {
+  char buf[1024];
+  snprintf(buf, 1024, "%s_kernel_%u.gz", prefix, kernel_uid);
+  return buf;
+}
+
+static gzFile open_trace(const std::string &filename, bool capture) {
+  gzFile f = gzopen(filename.c_str(), capture ? "wb" : "rb");
+  if (f == NULL) {
+    printf("GPGPU-Sim uArch: ERROR cannot open instruction trace %s\n",
+           filename.c_str());
+    abort();
+  }
+  return f;
+}
+
+/* File header, all fields host-endian:
+ *   u32 magic, u32 version, u32 warp size
+ *   u32 n, n bytes kernel name, u32 start pc
+ *   u32 grid x, y, z, u32 block x, y, z
+ *   u32 lmem, smem, cmem, gmem, regs, maxthreads, ptx_version, sm_target
+ */
+static void write_header(gzFile f, unsigned warp_size,
+                         const inst_trace_launch_t &launch) {
+  unsigned header[3] = {INST_TRACE_MAGIC, INST_TRACE_VERSION, warp_size};
+  gzwrite(f, header, sizeof(header));
+  unsigned n = launch.name.size();
+  gzwrite(f, &n, sizeof(n));
+  gzwrite(f, launch.name.data(), n);
+  const gpgpu_ptx_sim_info &info = launch.info;
+  unsigned fields[15] = {launch.start_pc,
+                         launch.grid.x,
+                         launch.grid.y,
+                         launch.grid.z,
+                         launch.block.x,
+                         launch.block.y,
+                         launch.block.z,
+                         (unsigned)info.lmem,
+                         (unsigned)info.smem,
+                         (unsigned)info.cmem,
+                         (unsigned)info.gmem,
+                         (unsigned)info.regs,
+                         info.maxthreads,
+                         info.ptx_version,
+                         info.sm_target};
+  gzwrite(f, fields, sizeof(fields));
+}
+
+static void read_header(gzFile f, const std::string &filename,
+                        unsigned warp_size, inst_trace_launch_t &launch) {
+  unsigned header[3];
+  gz_read_exact(f, header, sizeof(header), filename);
+  if (header[0] != INST_TRACE_MAGIC || header[1] != INST_TRACE_VERSION ||
+      header[2] != warp_size) {
+    printf(
+        "GPGPU-Sim uArch: ERROR %s is not a version %u instruction trace for "
+        "warp size %u\n",
+        filename.c_str(), INST_TRACE_VERSION, warp_size);
+    abort();
+  }
+  unsigned n;
+  gz_read_exact(f, &n, sizeof(n), filename);
+  std::vector<char> name(n + 1, 0);
+  if (n) gz_read_exact(f, &name[0], n, filename);
+  launch.name = &name[0];
+  unsigned fields[15];
+  gz_read_exact(f, fields, sizeof(fields), filename);
+  launch.start_pc = fields[0];
+  launch.grid = dim3(fields[1], fields[2], fields[3]);
+  launch.block = dim3(fields[4], fields[5], fields[6]);
+  launch.info.lmem = fields[7];
+  launch.info.smem = fields[8];
+  launch.info.cmem = fields[9];
+  launch.info.gmem = fields[10];
+  launch.info.regs = fields[11];
+  launch.info.maxthreads = fields[12];
+  launch.info.ptx_version = fields[13];
+  launch.info.sm_target = fields[14];
+}
+
+static bool same_dim3(const dim3 &a, const dim3 &b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+kernel_inst_trace::kernel_inst_trace(const char *prefix,
+                                     const kernel_info_t &kernel,
+                                     bool capture, unsigned warp_size) {
+  m_filename = trace_filename(prefix, kernel.get_uid());
+  m_capture = capture;
+  m_file = open_trace(m_filename, capture);
+
+  if (capture) {
+    inst_trace_launch_t launch;
+    launch.name = kernel.name();
+    launch.start_pc = kernel.entry()->get_start_PC();
+    launch.grid = kernel.get_grid_dim();
+    launch.block = kernel.get_cta_dim();
+    launch.info = *kernel.entry()->get_kernel_info();
+    write_header(m_file, warp_size, launch);
+    return;
+  }
+
+  inst_trace_launch_t launch;
+  read_header(m_file, m_filename, warp_size, launch);
+  if (launch.name != kernel.name() ||
+      !same_dim3(launch.grid, kernel.get_grid_dim()) ||
+      !same_dim3(launch.block, kernel.get_cta_dim())) {
+    printf(
+        "GPGPU-Sim uArch: ERROR instruction trace %s was captured from a "
+        "different launch (%s)\n",
+        m_filename.c_str(), launch.name.c_str());
+    abort();
+  }
+  unsigned block[3];  // ctaid, warp, nbytes
+  while (gzread(m_file, block, sizeof(block)) == sizeof(block)) {
+    std::vector<unsigned char> &data =
+        m_warps[std::make_pair(block[0], block[1])];
+    data.resize(block[2]);
+    if (block[2]) gz_read_exact(m_file, &data[0], block[2], m_filename);
+  }
+  gzclose(m_file);
+  m_file = NULL;
+  printf("GPGPU-Sim uArch: replaying %zu warps from instruction trace %s\n",
+         m_warps.size(), m_filename.c_str());
+}
+
+void kernel_inst_trace::read_launch(const char *prefix, unsigned kernel_uid,
+                                    unsigned warp_size,
+                                    inst_trace_launch_t &launch) {
+  std::string filename = trace_filename(prefix, kernel_uid);
+  gzFile f = open_trace(filename, false);
+  read_header(f, filename, warp_size, launch);
+  gzclose(f);
+}
+
+kernel_inst_trace::~kernel_inst_trace() {
+  if (m_file) gzclose(m_file);
+}
+
+void kernel_inst_trace::write_warp(warp_trace_t &warp) {
+  assert(m_capture);
+  unsigned block[3] = {warp.m_ctaid, warp.m_warp,
+                       (unsigned)warp.m_data.size()};
+  gzwrite(m_file, block, sizeof(block));
+  if (!warp.m_data.empty())
+    gzwrite(m_file, &warp.m_data[0], warp.m_data.size());
+  warp.m_data.clear();
+}
+
+void kernel_inst_trace::take_warp(unsigned ctaid, unsigned warp,
+                                  warp_trace_t &dst) {
+  assert(!m_capture);
+  std::map<std::pair<unsigned, unsigned>, std::vector<unsigned char> >::
+      iterator w = m_warps.find(std::make_pair(ctaid, warp));
+  if (w == m_warps.end()) {
+    printf(
+        "GPGPU-Sim uArch: ERROR instruction trace %s has no stream for cta "
+        "%u warp %u\n",
+        m_filename.c_str(), ctaid, warp);
+    abort();
+  }
+  dst.bind(this, ctaid, warp);
+  dst.m_data.swap(w->second);
+  m_warps.erase(w);
+}
+
+inst_trace_index::inst_trace_index(const char *prefix) {
+  m_prefix = prefix;
+  m_n_ptx = 0;
+  std::string filename = m_prefix + "_launches.txt";
+  m_file = fopen(filename.c_str(), "w");
+  if (m_file == NULL) {
+    printf("GPGPU-Sim uArch: ERROR cannot create instruction trace index %s\n",
+           filename.c_str());
+    abort();
+  }
+}
+
+inst_trace_index::~inst_trace_index() { fclose(m_file); }
+
+void inst_trace_index::add_ptx(const char *ptx) {
+  char buf[1024];
+  snprintf(buf, 1024, "%s_ptx_%u.ptx", m_prefix.c_str(), m_n_ptx++);
+  FILE *fp = fopen(buf, "w");
+  if (fp == NULL) {
+    printf("GPGPU-Sim uArch: ERROR cannot create %s\n", buf);
+    abort();
+  }
+  fputs(ptx, fp);
+  fclose(fp);
+  fprintf(m_file, "ptx %s\n", buf);
+  fflush(m_file);
+}
+
+void inst_trace_index::add_ptx_file(const char *filename) {
+  FILE *fp = fopen(filename, "r");
+  if (fp == NULL) {
+    printf("GPGPU-Sim uArch: ERROR cannot read %s\n", filename);
+    abort();
+  }
+  std::string ptx;
+  char buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) ptx.append(buf, n);
+  fclose(fp);
+  add_ptx(ptx.c_str());
+}
+
+void inst_trace_index::add_kernel(unsigned uid, const std::string &name) {
+  fprintf(m_file, "kernel %u %s\n", uid, name.c_str());
+  fflush(m_file);
+}
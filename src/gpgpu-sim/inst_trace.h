@@ -0,0 +1,160 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef INST_TRACE_H
+#define INST_TRACE_H
+
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../abstract_hardware_model.h"
+
+// -gpgpu_inst_trace_mode
+enum inst_trace_mode_t {
+  INST_TRACE_OFF = 0,
+  INST_TRACE_CAPTURE = 1,  // record what the PTX functional model executed
+  INST_TRACE_REPLAY = 2    // drive the timing model from a recorded trace
+};
+
+class kernel_inst_trace;
+
+// Launch parameters of a captured kernel. They head its trace file so the
+// kernel can be relaunched without the application that captured it.
+struct inst_trace_launch_t {
+  std::string name;
+  unsigned start_pc;  // checks the PTX was loaded as in the capture
+  dim3 grid;
+  dim3 block;
+  gpgpu_ptx_sim_info info;  // resource usage reported by ptxas
+};
+
+// Dynamic instruction stream of one warp of one CTA. While capturing it is
+// filled by the shader core and written out once the warp has finished;
+// while replaying it holds the warp's recorded stream and a read cursor.
+class warp_trace_t {
+ public:
+  warp_trace_t() : m_kernel(NULL), m_ctaid(0), m_warp(0), m_pos(0) {}
+
+  void bind(kernel_inst_trace *kernel, unsigned ctaid, unsigned warp) {
+    m_kernel = kernel;
+    m_ctaid = ctaid;
+    m_warp = warp;
+    m_data.clear();
+    m_pos = 0;
+  }
+  kernel_inst_trace *kernel() const { return m_kernel; }
+  unsigned ctaid() const { return m_ctaid; }
+  unsigned warp() const { return m_warp; }
+
+  void put(const void *src, size_t n) {
+    const unsigned char *b = (const unsigned char *)src;
+    m_data.insert(m_data.end(), b, b + n);
+  }
+  void put8(unsigned char v) { m_data.push_back(v); }
+  void put32(unsigned v) { put(&v, sizeof(v)); }
+  void put64(unsigned long long v) { put(&v, sizeof(v)); }
+
+  bool at_end() const { return m_pos >= m_data.size(); }
+  void get(void *dst, size_t n);
+  unsigned char get8() {
+    unsigned char v;
+    get(&v, sizeof(v));
+    return v;
+  }
+  unsigned get32() {
+    unsigned v;
+    get(&v, sizeof(v));
+    return v;
+  }
+  unsigned long long get64() {
+    unsigned long long v;
+    get(&v, sizeof(v));
+    return v;
+  }
+
+ private:
+  friend class kernel_inst_trace;
+  kernel_inst_trace *m_kernel;
+  unsigned m_ctaid;
+  unsigned m_warp;  // warp index within the CTA
+  std::vector<unsigned char> m_data;
+  size_t m_pos;
+};
+
+// Compressed per-kernel trace file: the launch parameters followed by one
+// block per (CTA, warp). A replayed kernel loads all of its blocks at launch
+// so warps can be handed their streams in whatever order the CTAs get
+// scheduled.
+class kernel_inst_trace {
+ public:
+  kernel_inst_trace(const char *prefix, const kernel_info_t &kernel,
+                    bool capture, unsigned warp_size);
+  ~kernel_inst_trace();
+
+  // launch parameters of captured kernel kernel_uid
+  static void read_launch(const char *prefix, unsigned kernel_uid,
+                          unsigned warp_size, inst_trace_launch_t &launch);
+
+  void write_warp(warp_trace_t &warp);
+  void take_warp(unsigned ctaid, unsigned warp, warp_trace_t &dst);
+
+ private:
+  std::string m_filename;
+  bool m_capture;
+  gzFile m_file;
+  std::map<std::pair<unsigned, unsigned>, std::vector<unsigned char> >
+      m_warps;
+};
+
+// Text index <prefix>_launches.txt of a capture. It lists, in the order they
+// happened, the PTX modules loaded and the kernels launched:
+//   ptx <copy of the module>
+//   kernel <uid> <name>
+// Loading and launching them in the same order reproduces the PTX pcs and
+// kernel uids of the captured run, which is what inst_trace_replay does.
+class inst_trace_index {
+ public:
+  explicit inst_trace_index(const char *prefix);
+  ~inst_trace_index();
+
+  void add_ptx(const char *ptx);
+  void add_ptx_file(const char *filename);
+  void add_kernel(unsigned uid, const std::string &name);
+
+ private:
+  std::string m_prefix;
+  FILE *m_file;
+  unsigned m_n_ptx;
+};
+
+#endif
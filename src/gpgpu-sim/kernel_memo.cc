@@ -0,0 +1,130 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "kernel_memo.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "../abstract_hardware_model.h"
+#include "../cuda-sim/memory.h"
+#include "../cuda-sim/ptx_ir.h"
+#include "gpu-misc.h"
+
+kernel_memo::kernel_memo(const char *filename, bool steady_state) {
+  m_filename = filename;
+  m_steady_state = steady_state;
+  m_hits = 0;
+  m_recorded = 0;
+  load();
+}
+
+void kernel_memo::load() {
+  FILE *fp = fopen(m_filename.c_str(), "r");
+  if (fp == NULL) return;  // nothing recorded yet
+
+  char line[1024];
+  while (fgets(line, sizeof(line), fp)) {
+    unsigned long long key;
+    kernel_memo_entry entry;
+    if (sscanf(line, "%llx %llu %llu", &key, &entry.cycles, &entry.insn) == 3)
+      m_entries[key] = entry;
+  }
+  fclose(fp);
+  printf("GPGPU-Sim uArch: kernel memo loaded %zu entries from %s\n",
+         m_entries.size(), m_filename.c_str());
+}
+
+unsigned long long kernel_memo::fingerprint(
+    kernel_info_t &kernel, const memory_space *global_mem) const {
+  function_info *entry = kernel.entry();
+  unsigned long long h = entry->get_ptx_hash();
+
+  dim3 dims[2] = {kernel.get_grid_dim(), kernel.get_cta_dim()};
+  h = fnv1a_hash(dims, sizeof(dims), h);
+
+  // parameters are laid out from address 0 by function_info::finalize()
+  unsigned param_size = entry->get_args_aligned_size();
+  if (param_size) {
+    unsigned char *params = (unsigned char *)malloc(param_size);
+    kernel.get_param_memory()->read(0, param_size, params);
+    h = fnv1a_hash(params, param_size, h);
+    free(params);
+  }
+
+  if (!m_steady_state) {
+    unsigned long long mem_hash = global_mem->hash();
+    h = fnv1a_hash(&mem_hash, sizeof(mem_hash), h);
+  }
+  return h;
+}
+
+bool kernel_memo::lookup(unsigned long long fp,
+                         kernel_memo_entry &entry) const {
+  std::map<unsigned long long, kernel_memo_entry>::const_iterator e =
+      m_entries.find(fp);
+  if (e == m_entries.end()) return false;
+  entry = e->second;
+  return true;
+}
+
+void kernel_memo::begin(unsigned uid, unsigned long long fp,
+                        unsigned long long cycle, unsigned long long insn) {
+  pending_t &p = m_pending[uid];
+  p.fp = fp;
+  p.start_cycle = cycle;
+  p.start_insn = insn;
+}
+
+void kernel_memo::end(unsigned uid, const std::string &name,
+                      unsigned long long cycle, unsigned long long insn) {
+  std::map<unsigned, pending_t>::iterator p = m_pending.find(uid);
+  if (p == m_pending.end()) return;
+
+  kernel_memo_entry entry;
+  entry.cycles = cycle - p->second.start_cycle;
+  entry.insn = insn - p->second.start_insn;
+  unsigned long long key = p->second.fp;
+  m_pending.erase(p);
+  m_entries[key] = entry;
+  m_recorded++;
+
+  FILE *fp = fopen(m_filename.c_str(), "a");
+  if (fp == NULL) {
+    printf("GPGPU-Sim uArch: WARNING cannot append to kernel memo file %s\n",
+           m_filename.c_str());
+    return;
+  }
+  fprintf(fp, "%016llx %llu %llu %s\n", key, entry.cycles, entry.insn,
+          name.c_str());
+  fclose(fp);
+}
+
+void kernel_memo::print(FILE *fout) const {
+  fprintf(fout, "gpgpu_kernel_memo_hits = %u\n", m_hits);
+  fprintf(fout, "gpgpu_kernel_memo_recorded = %u\n", m_recorded);
+}
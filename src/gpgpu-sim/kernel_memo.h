@@ -0,0 +1,88 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef KERNEL_MEMO_H
+#define KERNEL_MEMO_H
+
+#include <stdio.h>
+#include <map>
+#include <string>
+
+class kernel_info_t;
+class memory_space;
+
+// Timing reused for a kernel launch whose fingerprint was seen before
+struct kernel_memo_entry {
+  unsigned long long cycles;
+  unsigned long long insn;
+};
+
+// Persistent launch memoization. A launch is fingerprinted from its PTX,
+// grid/block dimensions, parameter bytes and (unless steady state is
+// asserted) the contents of global memory. Timing of kernels that ran alone
+// on the GPU is recorded under that fingerprint and appended to a text file
+// so later launches, in this or a later run, can skip timing simulation.
+// The file is only valid for the configuration that produced it.
+class kernel_memo {
+ public:
+  kernel_memo(const char *filename, bool steady_state);
+
+  unsigned long long fingerprint(kernel_info_t &kernel,
+                                 const memory_space *global_mem) const;
+  bool lookup(unsigned long long fp, kernel_memo_entry &entry) const;
+
+  // bracket a timed launch; only a kernel that stays alone on the GPU from
+  // begin() to end() is recorded
+  void begin(unsigned uid, unsigned long long fp, unsigned long long cycle,
+             unsigned long long insn);
+  void end(unsigned uid, const std::string &name, unsigned long long cycle,
+           unsigned long long insn);
+  void cancel_pending() { m_pending.clear(); }
+
+  void print(FILE *fout) const;
+  void inc_hits() { m_hits++; }
+
+ private:
+  void load();
+
+  struct pending_t {
+    unsigned long long fp;
+    unsigned long long start_cycle;
+    unsigned long long start_insn;
+  };
+
+  std::string m_filename;
+  bool m_steady_state;
+  std::map<unsigned long long, kernel_memo_entry> m_entries;
+  std::map<unsigned, pending_t> m_pending;
+  unsigned m_hits;
+  unsigned m_recorded;
+};
+
+#endif
@@ -0,0 +1,79 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#include "l1d_prefetcher.h"
+#include <assert.h>
+
+l1d_stride_prefetcher::l1d_stride_prefetcher(unsigned n_entries,
+                                             unsigned degree,
+                                             unsigned distance)
+    : m_table(n_entries), m_degree(degree), m_distance(distance) {
+  assert(n_entries > 0);
+  for (unsigned i = 0; i < n_entries; i++) m_table[i].valid = false;
+}
+
+void l1d_stride_prefetcher::observe(address_type pc, unsigned warp_id,
+                                    new_addr_type addr,
+                                    std::vector<long long> &offsets) {
+  unsigned long long h =
+      ((unsigned long long)pc << 16 ^ warp_id) * 0x9e3779b97f4a7c15ULL;
+  stride_entry &e = m_table[(h >> 32) % m_table.size()];
+  if (!e.valid || e.pc != pc || e.warp_id != warp_id) {
+    e.valid = true;
+    e.pc = pc;
+    e.warp_id = warp_id;
+    e.last = addr;
+    e.stride = 0;
+    return;
+  }
+
+  long long stride = (long long)(addr - e.last);
+  e.last = addr;
+  if (stride == 0) return;
+  if (stride != e.stride) {
+    // new step or direction: wait for it to repeat
+    e.stride = stride;
+    return;
+  }
+
+  for (unsigned n = 0; n < m_degree; n++) {
+    long long offset = stride * (long long)(m_distance + n);
+    if (offset < 0 && addr < (new_addr_type)-offset) break;
+    offsets.push_back(offset);
+  }
+}
+
+void l1d_prefetch_stats::print(FILE *fout) const {
+  fprintf(fout,
+          "L1D_prefetch: Issued = %llu, Useful = %llu, Late = %llu, "
+          "Useless = %llu, Dropped = %llu, Accuracy = %.4f, "
+          "Lateness = %.4f\n",
+          issued, useful, late, issued > useful ? issued - useful : 0, dropped,
+          issued ? (double)useful / issued : 0.0,
+          useful ? (double)late / useful : 0.0);
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef L1D_PREFETCHER_H
+#define L1D_PREFETCHER_H
+
+#include <stdio.h>
+#include <vector>
+#include "../abstract_hardware_model.h"
+
+enum l1d_prefetcher_type { L1D_PREFETCH_NONE = 0, L1D_PREFETCH_STRIDE };
+
+// Per-PC stride prefetcher of the L1 data cache of one SM.
+//
+// Loads are tracked per (pc, warp): warps running the same loop each walk
+// their own rows, so the stride only shows within a warp.  An entry keeps
+// the lowest address the last instance of the load accessed.  Once the same
+// non-zero stride has been seen twice in a row, every instance proposes the
+// address offsets of the next 'degree' instances, starting 'distance'
+// instances ahead; the LD/ST unit applies them to each of the instance's
+// coalesced accesses.
+class l1d_stride_prefetcher {
+ public:
+  l1d_stride_prefetcher(unsigned n_entries, unsigned degree,
+                        unsigned distance);
+
+  void observe(address_type pc, unsigned warp_id, new_addr_type addr,
+               std::vector<long long> &offsets);
+
+ private:
+  struct stride_entry {
+    bool valid;
+    address_type pc;
+    unsigned warp_id;
+    new_addr_type last;  // lowest address of the last instance
+    long long stride;
+  };
+
+  std::vector<stride_entry> m_table;
+  unsigned m_degree;
+  unsigned m_distance;
+};
+
+// A prefetch is useful when a demand load uses the block before it is
+// evicted, and late when that load finds the prefetch still in flight.
+// Useless prefetches were never used by a demand load.
+struct l1d_prefetch_stats {
+  l1d_prefetch_stats() : issued(0), useful(0), late(0), dropped(0) {}
+
+  unsigned long long issued;   // sent to the L2
+  unsigned long long useful;   // including late ones
+  unsigned long long late;
+  unsigned long long dropped;  // candidates discarded before issue
+
+  void print(FILE *fout) const;
+};
+
+#endif
@@ -0,0 +1,156 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include "l2_prefetcher.h"
+#include <assert.h>
+#include <stdlib.h>
+
+void next_n_line_prefetcher::observe(new_addr_type block,
+                                     std::vector<new_addr_type> &prefetches) {
+  for (unsigned i = 1; i <= m_degree; i++) prefetches.push_back(block + i);
+}
+
+stream_prefetcher::stream_prefetcher(unsigned n_streams, unsigned degree,
+                                     unsigned distance)
+    : m_streams(n_streams),
+      m_degree(degree),
+      m_distance(distance),
+      m_n_observed(0) {
+  assert(n_streams > 0);
+  for (unsigned i = 0; i < n_streams; i++) m_streams[i].valid = false;
+}
+
+void stream_prefetcher::observe(new_addr_type block,
+                                std::vector<new_addr_type> &prefetches) {
+  m_n_observed++;
+
+  // nearest stream within reach, and the entry to replace if there is none
+  stream_entry *match = NULL;
+  stream_entry *victim = NULL;
+  new_addr_type nearest = (new_addr_type)m_distance + 1;
+  for (unsigned i = 0; i < m_streams.size(); i++) {
+    stream_entry &s = m_streams[i];
+    if (!s.valid) {
+      if (!victim || victim->valid) victim = &s;
+      continue;
+    }
+    new_addr_type gap = (block > s.last) ? block - s.last : s.last - block;
+    if (gap < nearest) {
+      nearest = gap;
+      match = &s;
+    }
+    if (!victim || (victim->valid && s.last_use < victim->last_use))
+      victim = &s;
+  }
+
+  if (!match) {
+    victim->valid = true;
+    victim->last = block;
+    victim->head = block;
+    victim->stride = 0;
+    victim->confirmed = false;
+    victim->last_use = m_n_observed;
+    return;
+  }
+
+  match->last_use = m_n_observed;
+  long long stride = (long long)(block - match->last);
+  if (stride == 0) return;
+  match->last = block;
+  if (stride != match->stride) {
+    // new step or direction: wait for it to repeat
+    match->stride = stride;
+    match->confirmed = false;
+    match->head = block;
+    return;
+  }
+  match->confirmed = true;
+
+  // restart from the demand block if it has overtaken the prefetches
+  long long ahead = (long long)(match->head - block) / stride;
+  if (ahead < 0) {
+    match->head = block;
+    ahead = 0;
+  }
+  for (unsigned n = 0; n < m_degree && ahead < (long long)m_distance;
+       n++, ahead++) {
+    if (stride < 0 && match->head < (new_addr_type)-stride) break;
+    match->head += stride;
+    prefetches.push_back(match->head);
+  }
+}
+
+l2_prefetcher *create_l2_prefetcher(enum l2_prefetcher_type type,
+                                    unsigned degree, unsigned distance,
+                                    unsigned n_streams) {
+  switch (type) {
+    case L2_PREFETCH_NONE:
+      return NULL;
+    case L2_PREFETCH_NEXT_N_LINE:
+      return new next_n_line_prefetcher(degree);
+    case L2_PREFETCH_STREAM:
+      return new stream_prefetcher(n_streams, degree, distance);
+    default:
+      printf("GPGPU-Sim uArch: ERROR ** unknown L2 prefetcher %d\n", type);
+      abort();
+  }
+  return NULL;
+}
+
+l2_prefetch_stats &l2_prefetch_stats::operator+=(
+    const l2_prefetch_stats &other) {
+  for (std::map<unsigned, l2_prefetch_counters>::const_iterator i =
+           other.m_kernel_stats.begin();
+       i != other.m_kernel_stats.end(); ++i) {
+    l2_prefetch_counters &c = m_kernel_stats[i->first];
+    c.issued += i->second.issued;
+    c.useful += i->second.useful;
+    c.late += i->second.late;
+    c.dropped += i->second.dropped;
+    c.demand_misses += i->second.demand_misses;
+  }
+  return *this;
+}
+
+void l2_prefetch_stats::print(FILE *fout) const {
+  for (std::map<unsigned, l2_prefetch_counters>::const_iterator i =
+           m_kernel_stats.begin();
+       i != m_kernel_stats.end(); ++i) {
+    const l2_prefetch_counters &c = i->second;
+    unsigned long long would_miss = c.useful + c.demand_misses;
+    fprintf(fout,
+            "L2_prefetch_kernel[%u]: Issued = %llu, Useful = %llu, Late = "
+            "%llu, Dropped = %llu, Accuracy = %.4lf, Coverage = %.4lf, "
+            "Lateness = %.4lf\n",
+            i->first, c.issued, c.useful, c.late, c.dropped,
+            c.issued ? (double)c.useful / c.issued : 0.0,
+            would_miss ? (double)c.useful / would_miss : 0.0,
+            c.useful ? (double)c.late / c.useful : 0.0);
+  }
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2009-2011, Tor M. Aamodt, George L. Yuan
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation
+// and/or other materials provided with the distribution. Neither the name of
+// The University of British Columbia nor the names of its contributors may be
+// used to endorse or promote products derived from this software without
+// specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef L2_PREFETCHER_H
+#define L2_PREFETCHER_H
+
+#include <stdio.h>
+#include <map>
+#include <vector>
+#include "../abstract_hardware_model.h"
+
+enum l2_prefetcher_type {
+  L2_PREFETCH_NONE = 0,
+  L2_PREFETCH_NEXT_N_LINE,
+  L2_PREFETCH_STREAM
+};
+
+// Memory-side prefetcher of one L2 bank (memory sub partition).
+//
+// A prefetcher only sees the demand stream of its own bank and can only fetch
+// blocks mapped to it, so it works on block numbers in the bank's partition
+// address space (channel and sub partition bits removed).  A sequential sweep
+// of global memory is then sequential in every bank whatever the address
+// interleaving; the bank maps the proposed blocks back to linear addresses.
+class l2_prefetcher {
+ public:
+  virtual ~l2_prefetcher() {}
+
+  // Train on a demand read of 'block' that either missed in the L2 or was
+  // the first use of a prefetched block, and append the blocks worth
+  // fetching ahead of it to 'prefetches'.
+  virtual void observe(new_addr_type block,
+                       std::vector<new_addr_type> &prefetches) = 0;
+};
+
+// Fetches the next 'degree' blocks after every trigger.
+class next_n_line_prefetcher : public l2_prefetcher {
+ public:
+  next_n_line_prefetcher(unsigned degree) : m_degree(degree) {}
+
+  virtual void observe(new_addr_type block,
+                       std::vector<new_addr_type> &prefetches);
+
+ private:
+  unsigned m_degree;
+};
+
+// Tracks up to 'n_streams' constant-stride streams (stride in blocks, either
+// direction).  A trigger continues the stream whose last block is nearest,
+// if it lies within 'distance' blocks; otherwise it starts a new stream in
+// the least recently used entry.  Once a stride has repeated, the stream runs
+// ahead of the demand stream by up to 'distance' strides, fetching at most
+// 'degree' blocks per trigger.
+class stream_prefetcher : public l2_prefetcher {
+ public:
+  stream_prefetcher(unsigned n_streams, unsigned degree, unsigned distance);
+
+  virtual void observe(new_addr_type block,
+                       std::vector<new_addr_type> &prefetches);
+
+ private:
+  struct stream_entry {
+    bool valid;
+    new_addr_type last;  // last demand block
+    new_addr_type head;  // furthest block prefetched
+    long long stride;
+    bool confirmed;  // stride seen twice in a row
+    unsigned long long last_use;
+  };
+
+  std::vector<stream_entry> m_streams;
+  unsigned m_degree;
+  unsigned m_distance;
+  unsigned long long m_n_observed;
+};
+
+l2_prefetcher *create_l2_prefetcher(enum l2_prefetcher_type type,
+                                    unsigned degree, unsigned distance,
+                                    unsigned n_streams);
+
+// Prefetch effectiveness counters, per kernel.  A prefetch is useful when a
+// demand read uses the block before it is evicted, and late when that read
+// finds the prefetch still in flight.  Coverage is measured against the
+// demand reads that missed.
+struct l2_prefetch_counters {
+  l2_prefetch_counters()
+      : issued(0), useful(0), late(0), dropped(0), demand_misses(0) {}
+
+  unsigned long long issued;         // sent to DRAM
+  unsigned long long useful;         // including late ones
+  unsigned long long late;
+  unsigned long long dropped;        // candidates discarded before issue
+  unsigned long long demand_misses;  // demand reads not covered by a prefetch
+};
+
+class l2_prefetch_stats {
+ public:
+  l2_prefetch_counters &operator()(unsigned kernel_id) {
+    return m_kernel_stats[kernel_id];
+  }
+  l2_prefetch_stats &operator+=(const l2_prefetch_stats &other);
+  void print(FILE *fout) const;
+
+ private:
+  std::map<unsigned, l2_prefetch_counters> m_kernel_stats;
+};
+
+#endif
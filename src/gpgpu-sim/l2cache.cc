@@ -434,6 +434,20 @@ memory_sub_partition::memory_sub_partition(unsigned sub_partition_id,
   m_dram_L2_queue = new fifo_pipeline<mem_fetch>("dram-to-L2", 0, dram_L2);
   m_L2_icnt_queue = new fifo_pipeline<mem_fetch>("L2-to-icnt", 0, L2_icnt);
   wb_addr = -1;
+
+  m_prefetcher = NULL;
+  m_prefetch_inflight = 0;
+  if (!m_config->m_L2_config.disabled()) {
+    m_prefetcher = create_l2_prefetcher(
+        m_config->l2_prefetcher, m_config->l2_prefetch_degree,
+        m_config->l2_prefetch_distance, m_config->l2_prefetch_streams);
+  }
+  if (m_prefetcher) {
+    const l2_cache_config &l2 = m_config->m_L2_config;
+    prefetched_atom empty = {false, 0, 0};
+    m_prefetched.assign(
+        l2.get_num_lines() * (l2.get_line_sz() / l2.get_atom_sz()), empty);
+  }
 }
 
 memory_sub_partition::~memory_sub_partition() {
@@ -443,6 +457,7 @@ memory_sub_partition::~memory_sub_partition() {
   delete m_L2_icnt_queue;
   delete m_L2cache;
   delete m_L2interface;
+  delete m_prefetcher;
 }
 
 void memory_sub_partition::cache_cycle(unsigned cycle) {
@@ -450,9 +465,15 @@ void memory_sub_partition::cache_cycle(unsigned cycle) {
   if (!m_config->m_L2_config.disabled()) {
     if (m_L2cache->access_ready() && !m_L2_icnt_queue->full()) {
       mem_fetch *mf = m_L2cache->next_access();
-      if (mf->get_access_type() !=
-          L2_WR_ALLOC_R) {  // Don't pass write allocate read request back to
-                            // upper level cache
+      if (mf->get_access_type() == L2_PREFETCH_ACC) {
+        // the block is in the L2 now; nobody waits for a reply
+        assert(m_prefetch_inflight > 0);
+        m_prefetch_inflight--;
+        m_request_tracker.erase(mf);
+        delete mf;
+      } else if (mf->get_access_type() !=
+                 L2_WR_ALLOC_R) {  // Don't pass write allocate read request
+                                   // back to upper level cache
         mf->set_reply();
         mf->set_status(IN_PARTITION_L2_TO_ICNT_QUEUE,
                        m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle);
@@ -497,6 +518,7 @@ void memory_sub_partition::cache_cycle(unsigned cycle) {
   if (!m_config->m_L2_config.disabled()) m_L2cache->cycle();
 
   // new L2 texture accesses and/or non-texture accesses
+  bool demand_access = false;
   if (!m_L2_dram_queue->full() && !m_icnt_L2_queue->empty()) {
     mem_fetch *mf = m_icnt_L2_queue->top();
     if (!m_config->m_L2_config.disabled() &&
@@ -516,6 +538,9 @@ void memory_sub_partition::cache_cycle(unsigned cycle) {
         bool read_sent = was_read_sent(events);
         MEM_SUBPART_DPRINTF("Probing L2 cache Address=%llx, status=%u\n",
                             mf->get_addr(), status);
+        demand_access = true;
+        if (m_prefetcher && !mf->is_write())
+          train_prefetcher(mf, status, read_sent);
 
         if (status == HIT) {
           if (!write_sent) {
@@ -563,6 +588,9 @@ void memory_sub_partition::cache_cycle(unsigned cycle) {
     }
   }
 
+  // prefetches only use the L2 in cycles without a demand access
+  if (m_prefetcher && !demand_access) issue_prefetch();
+
   // ROP delay queue
   if (!m_rop.empty() && (cycle >= m_rop.front().ready_cycle) &&
       !m_icnt_L2_queue->full()) {
@@ -574,6 +602,128 @@ void memory_sub_partition::cache_cycle(unsigned cycle) {
   }
 }
 
+memory_sub_partition::prefetched_atom &memory_sub_partition::prefetched_slot(
+    new_addr_type atom) {
+  // the atoms of one bank are scattered over the address space; hash them
+  new_addr_type h = (atom / m_config->m_L2_config.get_atom_sz()) *
+                    0x9e3779b97f4a7c15ULL;
+  return m_prefetched[(h >> 32) % m_prefetched.size()];
+}
+
+void memory_sub_partition::train_prefetcher(mem_fetch *mf,
+                                            enum cache_request_status status,
+                                            bool read_sent) {
+  if (status == RESERVATION_FAIL) return;  // retried next cycle
+
+  // a read that missed without sending a request merged into an
+  // outstanding one
+  bool miss = (status != HIT) && read_sent;
+  bool pending = (status != HIT) && !read_sent;
+  unsigned kernel_id = mf->get_kernel_id();
+  new_addr_type atom = m_config->m_L2_config.mshr_addr(mf->get_addr());
+  prefetched_atom &p = prefetched_slot(atom);
+  bool first_use = false;
+  if (p.valid && p.addr == atom) {
+    // a miss means the prefetched atom was evicted before it was read
+    p.valid = false;
+    if (!miss) {
+      l2_prefetch_counters &c = m_prefetch_stats(p.kernel_id);
+      c.useful++;
+      if (pending) c.late++;
+      first_use = true;
+    }
+  }
+  if (miss) m_prefetch_stats(kernel_id).demand_misses++;
+  if (!miss && !first_use) return;
+
+  const l2_cache_config &l2 = m_config->m_L2_config;
+  m_prefetch_blocks.clear();
+  m_prefetcher->observe(mf->get_partition_addr() / l2.get_line_sz(),
+                        m_prefetch_blocks);
+  for (unsigned i = 0; i < m_prefetch_blocks.size(); i++)
+    queue_prefetch(m_prefetch_blocks[i], kernel_id);
+}
+
+void memory_sub_partition::queue_prefetch(new_addr_type block,
+                                          unsigned kernel_id) {
+  const l2_cache_config &l2 = m_config->m_L2_config;
+  new_addr_type line;
+  if (!m_config->m_address_mapping.raw_address(block * l2.get_line_sz(), m_id,
+                                               &line))
+    return;
+
+  for (new_addr_type atom = line; atom < line + l2.get_line_sz();
+       atom += l2.get_atom_sz()) {
+    prefetched_atom &p = prefetched_slot(atom);
+    if (p.valid && p.addr == atom) continue;
+    bool queued = false;
+    for (unsigned i = 0; i < m_prefetch_queue.size() && !queued; i++)
+      queued = (m_prefetch_queue[i].addr == atom);
+    if (queued) continue;
+
+    if (m_prefetch_queue.size() >= m_config->l2_prefetch_queue_size) {
+      m_prefetch_stats(m_prefetch_queue.front().kernel_id).dropped++;
+      m_prefetch_queue.pop_front();
+    }
+    prefetch_req req = {atom, kernel_id};
+    m_prefetch_queue.push_back(req);
+  }
+}
+
+void memory_sub_partition::issue_prefetch() {
+  // Lowest priority: wait until the L2 has no miss to send and both ports
+  // are free, keep the L2-to-DRAM queue from filling up, and leave at least
+  // half of the MSHRs to demand misses.
+  if (m_prefetch_queue.empty() || !m_L2cache->idle() ||
+      m_L2_dram_queue->full() ||
+      m_prefetch_inflight >= m_config->m_L2_config.get_mshr_entries() / 2)
+    return;
+
+  prefetch_req req = m_prefetch_queue.front();
+  m_prefetch_queue.pop_front();
+
+  const l2_cache_config &l2 = m_config->m_L2_config;
+  mem_access_sector_mask_t sector_mask;
+  unsigned first_sector = (req.addr % l2.get_line_sz()) / SECTOR_SIZE;
+  for (unsigned s = 0; s < l2.get_atom_sz() / SECTOR_SIZE; s++)
+    sector_mask.set(first_sector + s);
+
+  enum cache_request_status probe = m_L2cache->probe(req.addr, sector_mask);
+  if (probe == HIT || probe == HIT_RESERVED) return;  // present or on its way
+  if (probe == RESERVATION_FAIL) {
+    m_prefetch_stats(req.kernel_id).dropped++;
+    return;
+  }
+
+  mem_access_t access(req.kernel_id, L2_PREFETCH_ACC, req.addr,
+                      l2.get_atom_sz(), false, active_mask_t(),
+                      mem_access_byte_mask_t(), sector_mask, m_gpu->gpgpu_ctx);
+  mem_fetch *mf =
+      new mem_fetch(access, NULL, READ_PACKET_SIZE, -1, -1, -1, m_config,
+                    m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle);
+  assert(mf->get_sub_partition_id() == m_id);
+
+  std::list<cache_event> events;
+  enum cache_request_status status = m_L2cache->access(
+      req.addr, mf,
+      m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle + m_memcpy_cycle_offset,
+      events);
+  if (status == RESERVATION_FAIL) {
+    m_prefetch_stats(req.kernel_id).dropped++;
+    delete mf;
+    return;
+  }
+  assert(status == MISS);
+
+  m_request_tracker.insert(mf);
+  m_prefetch_inflight++;
+  m_prefetch_stats(req.kernel_id).issued++;
+  prefetched_atom &p = prefetched_slot(req.addr);
+  p.valid = true;
+  p.addr = req.addr;
+  p.kernel_id = req.kernel_id;
+}
+
 bool memory_sub_partition::full() const { return m_icnt_L2_queue->full(); }
 
 bool memory_sub_partition::full(unsigned size) const {
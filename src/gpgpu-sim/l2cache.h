@@ -31,7 +31,9 @@
 
 #include "../abstract_hardware_model.h"
 #include "dram.h"
+#include "l2_prefetcher.h"
 
+#include <deque>
 #include <list>
 #include <queue>
 
@@ -185,6 +187,9 @@ class memory_sub_partition {
 
   void accumulate_L2cache_stats(class cache_stats &l2_stats) const;
   void get_L2cache_sub_stats(struct cache_sub_stats &css) const;
+  void accumulate_L2_prefetch_stats(l2_prefetch_stats &stats) const {
+    stats += m_prefetch_stats;
+  }
 
   // Support for getting per-window L2 stats for AerialVision
   void get_L2cache_sub_stats_pw(struct cache_sub_stats_pw &css) const;
@@ -225,6 +230,30 @@ class memory_sub_partition {
 
   std::set<mem_fetch *> m_request_tracker;
 
+  // memory-side prefetching; m_prefetcher is NULL when it is disabled
+  struct prefetch_req {
+    new_addr_type addr;  // one L2 atom (sector, or line if not sectored)
+    unsigned kernel_id;
+  };
+  struct prefetched_atom {
+    bool valid;
+    new_addr_type addr;
+    unsigned kernel_id;
+  };
+  l2_prefetcher *m_prefetcher;
+  std::deque<prefetch_req> m_prefetch_queue;
+  // atoms fetched by a prefetch and not yet read, direct mapped
+  std::vector<prefetched_atom> m_prefetched;
+  std::vector<new_addr_type> m_prefetch_blocks;
+  unsigned m_prefetch_inflight;
+  l2_prefetch_stats m_prefetch_stats;
+
+  void train_prefetcher(mem_fetch *mf, enum cache_request_status status,
+                        bool read_sent);
+  void queue_prefetch(new_addr_type block, unsigned kernel_id);
+  void issue_prefetch();
+  prefetched_atom &prefetched_slot(new_addr_type atom);
+
   friend class L2interface;
 
   std::vector<mem_fetch *> breakdown_request_to_sector_requests(mem_fetch *mf);
@@ -242,7 +271,7 @@ class L2interface : public mem_fetch_interface {
  public:
   L2interface(memory_sub_partition *unit) { m_unit = unit; }
   virtual ~L2interface() {}
-  virtual bool full(unsigned size, bool write) const {
+  virtual bool full(unsigned size, bool write, unsigned kernel_id) const {
     // assume read and write packets all same size
     return m_unit->m_L2_dram_queue->full();
   }
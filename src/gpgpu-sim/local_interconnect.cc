@@ -35,23 +35,55 @@
 #include <utility>
 
 #include "local_interconnect.h"
-#include "mem_fetch.h"
 
 xbar_router::xbar_router(unsigned router_id, enum Interconnect_type m_type,
                          unsigned n_shader, unsigned n_mem,
                          unsigned m_in_buffer_limit,
                          unsigned m_out_buffer_limit,
-                         enum Arbiteration_type m_arbit_type) {
+                         enum Arbiteration_type m_arbit_type,
+                         unsigned m_qos_classes) {
   m_id = router_id;
   router_type = m_type;
   _n_mem = n_mem;
   _n_shader = n_shader;
   total_nodes = n_shader + n_mem;
-  in_buffers.resize(total_nodes);
-  out_buffers.resize(total_nodes);
-  next_node.resize(total_nodes, 0);
   in_buffer_limit = m_in_buffer_limit;
   out_buffer_limit = m_out_buffer_limit;
+  qos_classes = m_qos_classes;
+  assert(qos_classes >= 1 && qos_classes <= 32);
+  in_class_limit = std::max(1u, in_buffer_limit / qos_classes);
+  out_class_limit = std::max(1u, out_buffer_limit / qos_classes);
+  qos_weights.assign(qos_classes, 1);
+  class_packets_num.assign(qos_classes, 0);
+
+  unsigned n_slots = total_nodes * qos_classes;
+  in_buffers.resize(n_slots);
+  requests.resize(n_slots);
+  for (unsigned i = 0; i < n_slots; ++i) {
+    in_buffers[i].init(in_class_limit);
+    requests[i].init(total_nodes);
+  }
+  n_requests.resize(n_slots, 0);
+  out_class_count.resize(n_slots, 0);
+  out_buffers.resize(total_nodes);
+  out_wrr.resize(total_nodes);
+  in_wrr.resize(total_nodes);
+  for (unsigned i = 0; i < total_nodes; ++i) {
+    out_buffers[i].init(out_buffer_limit);
+    out_wrr[i].init(qos_classes);
+    in_wrr[i].init(qos_classes);
+  }
+  output_classes.resize(total_nodes, 0);
+  input_classes.resize(total_nodes, 0);
+  requested_outputs.init(total_nodes);
+  nonempty_inputs.init(total_nodes);
+  issued.init(total_nodes);
+  n_heads = 0;
+  n_requested_outputs = 0;
+  n_full_outputs = 0;
+  in_occupancy = 0;
+  out_occupancy = 0;
+  next_node.resize(total_nodes, 0);
   arbit_type = m_arbit_type;
   next_node_id = 0;
   if (m_type == REQ_NET) {
@@ -73,11 +105,77 @@ xbar_router::xbar_router(unsigned router_id, enum Interconnect_type m_type,
 
 xbar_router::~xbar_router() {}
 
+void xbar_router::Set_QoS_Weight(unsigned qos_class, unsigned weight) {
+  assert(qos_class < qos_classes);
+  qos_weights[qos_class] = weight;
+}
+
+void xbar_router::add_head(unsigned input_deviceID, unsigned qos_class) {
+  unsigned output =
+      in_buffers[slot(input_deviceID, qos_class)].front().output_deviceID;
+  unsigned s = slot(output, qos_class);
+  requests[s].set(input_deviceID);
+  if (n_requests[s]++ == 0) {
+    if (!output_classes[output]) {
+      requested_outputs.set(output);
+      n_requested_outputs++;
+    }
+    output_classes[output] |= 1u << qos_class;
+  }
+}
+
+void xbar_router::remove_head(unsigned input_deviceID, unsigned qos_class) {
+  unsigned output =
+      in_buffers[slot(input_deviceID, qos_class)].front().output_deviceID;
+  unsigned s = slot(output, qos_class);
+  requests[s].clear(input_deviceID);
+  if (--n_requests[s] == 0) {
+    output_classes[output] &= ~(1u << qos_class);
+    if (!output_classes[output]) {
+      requested_outputs.clear(output);
+      n_requested_outputs--;
+    }
+  }
+}
+
+void xbar_router::push_out(unsigned output_deviceID, const Packet& packet) {
+  out_buffers[output_deviceID].push(packet);
+  out_class_count[slot(output_deviceID, packet.qos_class)]++;
+  out_occupancy++;
+  if (!Has_Buffer_Out(output_deviceID, 1)) n_full_outputs++;
+}
+
+void xbar_router::pop_in(unsigned input_deviceID, unsigned qos_class) {
+  remove_head(input_deviceID, qos_class);
+  xbar_ring<Packet>& buffer = in_buffers[slot(input_deviceID, qos_class)];
+  buffer.pop();
+  in_occupancy--;
+  if (!buffer.empty()) {
+    add_head(input_deviceID, qos_class);
+    return;
+  }
+  n_heads--;
+  input_classes[input_deviceID] &= ~(1u << qos_class);
+  if (!input_classes[input_deviceID]) nonempty_inputs.clear(input_deviceID);
+}
+
 void xbar_router::Push(unsigned input_deviceID, unsigned output_deviceID,
-                       void* data, unsigned int size) {
+                       void* data, unsigned int size, unsigned qos_class) {
   assert(input_deviceID < total_nodes);
-  in_buffers[input_deviceID].push(Packet(data, output_deviceID));
+  assert(output_deviceID < total_nodes);
+  assert(qos_class < qos_classes);
+  xbar_ring<Packet>& buffer = in_buffers[slot(input_deviceID, qos_class)];
+  bool was_empty = buffer.empty();
+  buffer.push(Packet(data, output_deviceID, qos_class));
+  in_occupancy++;
+  if (was_empty) {
+    n_heads++;
+    input_classes[input_deviceID] |= 1u << qos_class;
+    nonempty_inputs.set(input_deviceID);
+    add_head(input_deviceID, qos_class);
+  }
   packets_num++;
+  class_packets_num[qos_class]++;
 }
 
 void* xbar_router::Pop(unsigned ouput_deviceID) {
@@ -85,19 +183,24 @@ void* xbar_router::Pop(unsigned ouput_deviceID) {
   void* data = NULL;
 
   if (!out_buffers[ouput_deviceID].empty()) {
-    data = out_buffers[ouput_deviceID].front().data;
+    if (!Has_Buffer_Out(ouput_deviceID, 1)) n_full_outputs--;
+    const Packet& packet = out_buffers[ouput_deviceID].front();
+    data = packet.data;
+    out_class_count[slot(ouput_deviceID, packet.qos_class)]--;
     out_buffers[ouput_deviceID].pop();
+    out_occupancy--;
   }
 
   return data;
 }
 
 bool xbar_router::Has_Buffer_In(unsigned input_deviceID, unsigned size,
-                                bool update_counter) {
+                                bool update_counter, unsigned qos_class) {
   assert(input_deviceID < total_nodes);
 
   bool has_buffer =
-      (in_buffers[input_deviceID].size() + size <= in_buffer_limit);
+      (in_buffers[slot(input_deviceID, qos_class)].size() + size <=
+       in_class_limit);
   if (update_counter && !has_buffer) in_buffer_full++;
 
   return has_buffer;
@@ -116,39 +219,75 @@ void xbar_router::Advance() {
     assert(0);
 }
 
+// the class output_deviceID grants next among the classes requesting it that
+// still have room in its buffer, or -1
+int xbar_router::output_class(unsigned output_deviceID) const {
+  unsigned eligible = output_classes[output_deviceID];
+  if (qos_classes > 1) {
+    for (unsigned c = 0; c < qos_classes; ++c)
+      if (out_class_count[slot(output_deviceID, c)] >= out_class_limit)
+        eligible &= ~(1u << c);
+  }
+  return out_wrr[output_deviceID].peek(eligible, qos_weights);
+}
+
+void xbar_router::RR_Arbitrate(unsigned node_id) {
+  // send the head of a class whose output grants that class this cycle, so
+  // the QoS weights hold per output as with iSLIP
+  unsigned granted = 0;
+  for (unsigned c = 0; c < qos_classes; ++c) {
+    if (!((input_classes[node_id] >> c) & 1)) continue;
+    unsigned output = in_buffers[slot(node_id, c)].front().output_deviceID;
+    if (Has_Buffer_Out(output, 1) && !issued.test(output) &&
+        output_class(output) == (int)c)
+      granted |= 1u << c;
+  }
+  if (granted) {
+    unsigned qos_class = in_wrr[node_id].pick(granted, qos_weights);
+    const Packet& _packet = in_buffers[slot(node_id, qos_class)].front();
+    unsigned output = _packet.output_deviceID;
+    out_wrr[output].grant(qos_class, qos_weights);
+    push_out(output, _packet);
+    pop_in(node_id, qos_class);
+    issued.set(output);
+    return;
+  }
+
+  // blocked: account for the head this input would have sent
+  unsigned qos_class =
+      in_wrr[node_id].peek(input_classes[node_id], qos_weights);
+  unsigned output =
+      in_buffers[slot(node_id, qos_class)].front().output_deviceID;
+  if (Has_Buffer_Out(output, 1) && Has_Class_Buffer_Out(output, qos_class)) {
+    conflicts++;  // issued already, or granting another class
+  } else {
+    out_buffer_full++;
+
+    if (issued.test(output)) conflicts++;
+  }
+}
+
 void xbar_router::RR_Advance() {
   cycles++;
 
-  vector<bool> issued(total_nodes, false);
+  issued.reset();
 
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    unsigned node_id = (i + next_node_id) % total_nodes;
-
-    if (!in_buffers[node_id].empty()) {
-      Packet _packet = in_buffers[node_id].front();
-      // ensure that the outbuffer has space and not issued before in this cycle
-      if (Has_Buffer_Out(_packet.output_deviceID, 1)) {
-        if (!issued[_packet.output_deviceID]) {
-          out_buffers[_packet.output_deviceID].push(_packet);
-          in_buffers[node_id].pop();
-          issued[_packet.output_deviceID] = true;
-        } else
-          conflicts++;
-      } else {
-        out_buffer_full++;
-
-        if (issued[_packet.output_deviceID]) conflicts++;
-      }
-    }
-  }
+  // visit each non-empty input once, starting at next_node_id; inputs only
+  // drain during arbitration, so walking the live mask is safe
+  int node_id;
+  for (node_id = nonempty_inputs.find_from(next_node_id); node_id >= 0;
+       node_id = nonempty_inputs.find_from(node_id + 1))
+    RR_Arbitrate(node_id);
+  for (node_id = nonempty_inputs.find_from(0);
+       node_id >= 0 && (unsigned)node_id < next_node_id;
+       node_id = nonempty_inputs.find_from(node_id + 1))
+    RR_Arbitrate(node_id);
 
-  next_node_id = (++next_node_id % total_nodes);
+  next_node_id = (next_node_id + 1) % total_nodes;
 
   // collect some stats about buffer util
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    in_buffer_util += in_buffers[i].size();
-    out_buffer_util += out_buffers[i].size();
-  }
+  in_buffer_util += in_occupancy;
+  out_buffer_util += out_occupancy;
 }
 
 // iSLIP algorithm
@@ -158,59 +297,35 @@ void xbar_router::RR_Advance() {
 void xbar_router::iSLIP_Advance() {
   cycles++;
 
-  vector<unsigned> node_tmp;
-
-  // calcaulte how many conflicts are there for stats
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    if (!in_buffers[i].empty()) {
-      Packet _packet_tmp = in_buffers[i].front();
-      if (!node_tmp.empty()) {
-        if (std::find(node_tmp.begin(), node_tmp.end(),
-                      _packet_tmp.output_deviceID) != node_tmp.end()) {
-          conflicts++;
-        } else
-          node_tmp.push_back(_packet_tmp.output_deviceID);
-      } else {
-        node_tmp.push_back(_packet_tmp.output_deviceID);
-      }
-    }
-  }
-
-  // do iSLIP
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    if (Has_Buffer_Out(i, 1)) {
-      for (unsigned j = 0; j < total_nodes; ++j) {
-        unsigned node_id = (j + next_node[i]) % total_nodes;
-
-        if (!in_buffers[node_id].empty()) {
-          Packet _packet = in_buffers[node_id].front();
-          if (_packet.output_deviceID == i) {
-            out_buffers[_packet.output_deviceID].push(_packet);
-            in_buffers[node_id].pop();
-            next_node[i] = (++node_id % total_nodes);
-            break;
-          }
-        }
-      }
-    } else
-      out_buffer_full++;
+  // every head packet beyond the first one for an output is a conflict
+  conflicts += n_heads - n_requested_outputs;
+
+  // full outputs are only counted; they cannot drain during Advance, so
+  // their state at the start of the cycle is the state each one is seen in
+  out_buffer_full += n_full_outputs;
+
+  // do iSLIP, over outputs in increasing order. Granting an input exposes
+  // its next packet, which may request a later output in this same cycle.
+  for (int i = requested_outputs.find_from(0); i >= 0;
+       i = requested_outputs.find_from(i + 1)) {
+    if (!Has_Buffer_Out(i, 1)) continue;
+    // pick the class first (weighted), then the input within that class
+    int qos_class = output_class(i);
+    if (qos_class < 0) continue;
+    out_wrr[i].grant(qos_class, qos_weights);
+    int node_id = requests[slot(i, qos_class)].find_next(next_node[i]);
+    assert(node_id >= 0);
+    push_out(i, in_buffers[slot(node_id, qos_class)].front());
+    pop_in(node_id, qos_class);
+    next_node[i] = (node_id + 1) % total_nodes;
   }
 
   // collect some stats about buffer util
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    in_buffer_util += in_buffers[i].size();
-    out_buffer_util += out_buffers[i].size();
-  }
+  in_buffer_util += in_occupancy;
+  out_buffer_util += out_occupancy;
 }
 
-bool xbar_router::Busy() const {
-  for (unsigned i = 0; i < total_nodes; ++i) {
-    if (!in_buffers[i].empty()) return true;
-
-    if (!out_buffers[i].empty()) return true;
-  }
-  return false;
-}
+bool xbar_router::Busy() const { return in_occupancy || out_occupancy; }
 
 ////////////////////////////////////////////////////
 /////////////LocalInterconnect/////////////////////
@@ -231,6 +346,7 @@ LocalInterconnect::LocalInterconnect(
   n_shader = 0;
   n_mem = 0;
   n_subnets = m_localinct_config.subnets;
+  n_qos_classes = 1;
 }
 
 LocalInterconnect::~LocalInterconnect() {
@@ -240,16 +356,18 @@ LocalInterconnect::~LocalInterconnect() {
 }
 
 void LocalInterconnect::CreateInterconnect(unsigned m_n_shader,
-                                           unsigned m_n_mem) {
+                                           unsigned m_n_mem,
+                                           unsigned qos_classes) {
   n_shader = m_n_shader;
   n_mem = m_n_mem;
+  n_qos_classes = qos_classes;
 
   net.resize(n_subnets);
   for (unsigned i = 0; i < n_subnets; ++i) {
     net[i] = new xbar_router(i, static_cast<Interconnect_type>(i), m_n_shader,
                              m_n_mem, m_inct_config.in_buffer_limit,
                              m_inct_config.out_buffer_limit,
-                             m_inct_config.arbiter_algo);
+                             m_inct_config.arbiter_algo, n_qos_classes);
   }
 }
 
@@ -259,7 +377,8 @@ void LocalInterconnect::Init() {
 }
 
 void LocalInterconnect::Push(unsigned input_deviceID, unsigned output_deviceID,
-                             void* data, unsigned int size) {
+                             void* data, unsigned int size,
+                             unsigned qos_class) {
   unsigned subnet;
   if (n_subnets == 1) {
     subnet = 0;
@@ -274,9 +393,9 @@ void LocalInterconnect::Push(unsigned input_deviceID, unsigned output_deviceID,
   // it should have free buffer
   // assume all the packets have size of one
   // no flits are implemented
-  assert(net[subnet]->Has_Buffer_In(input_deviceID, 1));
+  assert(net[subnet]->Has_Buffer_In(input_deviceID, 1, false, qos_class));
 
-  net[subnet]->Push(input_deviceID, output_deviceID, data, size);
+  net[subnet]->Push(input_deviceID, output_deviceID, data, size, qos_class);
 }
 
 void* LocalInterconnect::Pop(unsigned ouput_deviceID) {
@@ -300,17 +419,24 @@ bool LocalInterconnect::Busy() const {
   return false;
 }
 
-bool LocalInterconnect::HasBuffer(unsigned deviceID, unsigned int size) const {
+bool LocalInterconnect::HasBuffer(unsigned deviceID, unsigned int size,
+                                  unsigned qos_class) const {
   bool has_buffer = false;
 
   if ((n_subnets > 1) && deviceID >= n_shader)  // deviceID is memory node
-    has_buffer = net[REPLY_NET]->Has_Buffer_In(deviceID, 1, true);
+    has_buffer = net[REPLY_NET]->Has_Buffer_In(deviceID, 1, true, qos_class);
   else
-    has_buffer = net[REQ_NET]->Has_Buffer_In(deviceID, 1, true);
+    has_buffer = net[REQ_NET]->Has_Buffer_In(deviceID, 1, true, qos_class);
 
   return has_buffer;
 }
 
+void LocalInterconnect::SetQoSWeight(unsigned qos_class, unsigned weight) {
+  for (unsigned i = 0; i < n_subnets; ++i) {
+    net[i]->Set_QoS_Weight(qos_class, weight);
+  }
+}
+
 void LocalInterconnect::DisplayStats() const {
   cout << "Req_Network_injected_packets_num = " << net[REQ_NET]->packets_num
        << endl;
@@ -357,6 +483,16 @@ void LocalInterconnect::DisplayStats() const {
        << ((float)(net[REPLY_NET]->out_buffer_util) / (net[REPLY_NET]->cycles) /
            net[REPLY_NET]->active_out_buffers)
        << endl;
+
+  if (n_qos_classes > 1) {
+    cout << endl;
+    for (unsigned c = 0; c < n_qos_classes; ++c) {
+      cout << "Req_Network_class" << c << "_injected_packets_num = "
+           << net[REQ_NET]->class_packets_num[c] << endl;
+      cout << "Reply_Network_class" << c << "_injected_packets_num = "
+           << net[REPLY_NET]->class_packets_num[c] << endl;
+    }
+  }
 }
 
 void LocalInterconnect::DisplayOverallStats() const {}
@@ -29,6 +29,7 @@
 #ifndef _LOCAL_INTERCONNECT_HPP_
 #define _LOCAL_INTERCONNECT_HPP_
 
+#include <assert.h>
 #include <iostream>
 #include <map>
 #include <queue>
@@ -47,21 +48,142 @@ struct inct_config {
   Arbiteration_type arbiter_algo;
 };
 
+// Fixed-capacity FIFO used for the crossbar port buffers
+template <class T>
+class xbar_ring {
+ public:
+  xbar_ring() : m_head(0), m_count(0), m_mask(0) {}
+  void init(unsigned capacity) {
+    unsigned size = 1;
+    while (size < capacity) size <<= 1;
+    m_data.resize(size);
+    m_mask = size - 1;
+    m_head = 0;
+    m_count = 0;
+  }
+  bool empty() const { return m_count == 0; }
+  unsigned size() const { return m_count; }
+  const T& front() const { return m_data[m_head]; }
+  void push(const T& v) {
+    assert(m_count < m_data.size());
+    m_data[(m_head + m_count) & m_mask] = v;
+    m_count++;
+  }
+  void pop() {
+    assert(m_count > 0);
+    m_head = (m_head + 1) & m_mask;
+    m_count--;
+  }
+
+ private:
+  vector<T> m_data;
+  unsigned m_head, m_count, m_mask;
+};
+
+// One bit per crossbar port
+class xbar_port_mask {
+ public:
+  void init(unsigned n_bits) {
+    m_bits = n_bits;
+    m_words.assign((n_bits + 63) / 64, 0);
+  }
+  void set(unsigned i) { m_words[i >> 6] |= 1ULL << (i & 63); }
+  void clear(unsigned i) { m_words[i >> 6] &= ~(1ULL << (i & 63)); }
+  void reset() { m_words.assign(m_words.size(), 0); }
+  bool test(unsigned i) const { return (m_words[i >> 6] >> (i & 63)) & 1; }
+
+  // lowest set bit >= from, or -1
+  int find_from(unsigned from) const {
+    if (from >= m_bits) return -1;
+    unsigned w = from >> 6;
+    unsigned long long bits = m_words[w] & (~0ULL << (from & 63));
+    while (!bits) {
+      if (++w == m_words.size()) return -1;
+      bits = m_words[w];
+    }
+    return (w << 6) + __builtin_ctzll(bits);
+  }
+  // round-robin: first set bit at or after from, wrapping around
+  int find_next(unsigned from) const {
+    int i = find_from(from);
+    return (i >= 0) ? i : find_from(0);
+  }
+
+ private:
+  unsigned m_bits;
+  vector<unsigned long long> m_words;
+};
+
+// Weighted round robin between QoS classes: a class keeps winning until it
+// has used up its weight, then the next eligible class takes over. Classes
+// compete for output bandwidth, so both arbiters keep one per output and
+// only charge a class once one of its packets is granted the output. Naive
+// RR keeps another one per input to choose among the input's classes.
+class xbar_qos_wrr {
+ public:
+  xbar_qos_wrr() : m_current(0) {}
+  void init(unsigned n_classes) {
+    m_credits.assign(n_classes, 0);
+    m_current = 0;
+  }
+  // eligible has one bit per class; returns the granted class or -1
+  int pick(unsigned eligible, const vector<unsigned>& weights) {
+    int c = peek(eligible, weights);
+    if (c >= 0) grant(c, weights);
+    return c;
+  }
+  // the class pick() would grant, without charging it
+  int peek(unsigned eligible, const vector<unsigned>& weights) const {
+    if (!eligible) return -1;
+    unsigned n = m_credits.size();
+    if (n == 1) return 0;
+    for (unsigned k = 0; k < n; ++k) {
+      unsigned c = (m_current + k) % n;
+      if (((eligible >> c) & 1) && m_credits[c] > 0) return c;
+    }
+    // every waiting class has spent its share: a new round starts
+    for (unsigned k = 0; k < n; ++k) {
+      unsigned c = (m_current + k) % n;
+      if (((eligible >> c) & 1) && weights[c] > 0) return c;
+    }
+    // only zero-weight classes are waiting; stay work conserving
+    for (unsigned k = 0; k < n; ++k) {
+      unsigned c = (m_current + k) % n;
+      if ((eligible >> c) & 1) return c;
+    }
+    return -1;
+  }
+  // charge class c, as returned by peek()
+  void grant(unsigned c, const vector<unsigned>& weights) {
+    if (m_credits.size() == 1) return;
+    if (m_credits[c] == 0)
+      for (unsigned k = 0; k < m_credits.size(); ++k) m_credits[k] = weights[k];
+    if (m_credits[c] > 0) m_credits[c]--;
+    m_current = c;
+  }
+
+ private:
+  vector<unsigned> m_credits;
+  unsigned m_current;
+};
+
 class xbar_router {
  public:
   xbar_router(unsigned router_id, enum Interconnect_type m_type,
               unsigned n_shader, unsigned n_mem, unsigned m_in_buffer_limit,
-              unsigned m_out_buffer_limit, enum Arbiteration_type m_arbit_type);
+              unsigned m_out_buffer_limit, enum Arbiteration_type m_arbit_type,
+              unsigned m_qos_classes = 1);
   ~xbar_router();
   void Push(unsigned input_deviceID, unsigned output_deviceID, void* data,
-            unsigned int size);
+            unsigned int size, unsigned qos_class = 0);
   void* Pop(unsigned ouput_deviceID);
   void Advance();
 
   bool Busy() const;
   bool Has_Buffer_In(unsigned input_deviceID, unsigned size,
-                     bool update_counter = false);
+                     bool update_counter = false, unsigned qos_class = 0);
   bool Has_Buffer_Out(unsigned output_deviceID, unsigned size);
+  void Set_QoS_Weight(unsigned qos_class, unsigned weight);
 
   // some stats
   unsigned long long cycles;
@@ -71,25 +193,65 @@ class xbar_router {
   unsigned long long in_buffer_full;
   unsigned long long in_buffer_util;
   unsigned long long packets_num;
+  vector<unsigned long long> class_packets_num;
 
  private:
   void iSLIP_Advance();
   void RR_Advance();
+  void RR_Arbitrate(unsigned node_id);
 
   struct Packet {
-    Packet(void* m_data, unsigned m_output_deviceID) {
+    Packet() : data(NULL), output_deviceID(0), qos_class(0) {}
+    Packet(void* m_data, unsigned m_output_deviceID, unsigned m_qos_class) {
       data = m_data;
       output_deviceID = m_output_deviceID;
+      qos_class = m_qos_class;
     }
     void* data;
     unsigned output_deviceID;
+    unsigned qos_class;
   };
-  vector<queue<Packet> > in_buffers;
-  vector<queue<Packet> > out_buffers;
+
+  // buffers, request masks and counters are kept per (port, QoS class)
+  unsigned slot(unsigned port, unsigned qos_class) const {
+    return port * qos_classes + qos_class;
+  }
+  bool Has_Class_Buffer_Out(unsigned output_deviceID, unsigned qos_class) {
+    return out_class_count[slot(output_deviceID, qos_class)] < out_class_limit;
+  }
+
+  // the request matrix tracks head-of-line packets, so it changes whenever
+  // an input buffer gains or loses its front packet
+  void add_head(unsigned input_deviceID, unsigned qos_class);
+  void remove_head(unsigned input_deviceID, unsigned qos_class);
+  void push_out(unsigned output_deviceID, const Packet& packet);
+  void pop_in(unsigned input_deviceID, unsigned qos_class);
+  int output_class(unsigned output_deviceID) const;
+
+  vector<xbar_ring<Packet> > in_buffers;  // per (input, class)
+  vector<xbar_ring<Packet> > out_buffers;
   unsigned _n_shader, _n_mem, total_nodes;
   unsigned in_buffer_limit, out_buffer_limit;
   vector<unsigned> next_node;  // used for iSLIP arbit
   unsigned next_node_id;       // used for RR arbit
+
+  // QoS: each class gets an equal share of every port buffer
+  unsigned qos_classes;
+  unsigned in_class_limit, out_class_limit;
+  vector<unsigned> qos_weights;
+  vector<unsigned> out_class_count;  // per (output, class)
+  vector<xbar_qos_wrr> out_wrr;      // class arbitration per output
+  vector<xbar_qos_wrr> in_wrr;       // RR: class choice per input
+
+  vector<xbar_port_mask> requests;  // per (output, class): requesting inputs
+  vector<unsigned> n_requests;      // popcount of requests[slot]
+  vector<unsigned> output_classes;  // per output: classes with requests
+  vector<unsigned> input_classes;   // per input: non-empty class buffers
+  xbar_port_mask requested_outputs;
+  xbar_port_mask nonempty_inputs;
+  xbar_port_mask issued;  // RR: outputs granted this cycle
+  unsigned n_heads, n_requested_outputs, n_full_outputs;
+  unsigned long long in_occupancy, out_occupancy;
   unsigned m_id;
   enum Interconnect_type router_type;
   unsigned active_in_buffers, active_out_buffers;
@@ -103,16 +265,19 @@ class LocalInterconnect {
   LocalInterconnect(const struct inct_config& m_localinct_config);
   ~LocalInterconnect();
   static LocalInterconnect* New(const struct inct_config& m_inct_config);
-  void CreateInterconnect(unsigned n_shader, unsigned n_mem);
+  void CreateInterconnect(unsigned n_shader, unsigned n_mem,
+                          unsigned qos_classes = 1);
 
   // node side functions
   void Init();
   void Push(unsigned input_deviceID, unsigned output_deviceID, void* data,
-            unsigned int size);
+            unsigned int size, unsigned qos_class = 0);
   void* Pop(unsigned ouput_deviceID);
   void Advance();
   bool Busy() const;
-  bool HasBuffer(unsigned deviceID, unsigned int size) const;
+  bool HasBuffer(unsigned deviceID, unsigned int size,
+                 unsigned qos_class = 0) const;
+  void SetQoSWeight(unsigned qos_class, unsigned weight);
   void DisplayStats() const;
   void DisplayOverallStats() const;
   unsigned GetFlitSize() const;
@@ -124,6 +289,7 @@ class LocalInterconnect {
 
   unsigned n_shader, n_mem;
   unsigned n_subnets;
+  unsigned n_qos_classes;
   vector<xbar_router*> net;
 };
 
@@ -65,6 +65,14 @@ mem_fetch::mem_fetch(const mem_access_t &access, const warp_inst_t *inst,
   icnt_flit_size = config->icnt_flit_size;
   original_mf = m_original_mf;
   original_wr_mf = m_original_wr_mf;
+  // sector and write-allocate requests are made with kernel id 0; they
+  // belong to the kernel of the request they were split from
+  if (m_original_mf)
+    kernel_id = m_original_mf->get_kernel_id();
+  else if (m_original_wr_mf)
+    kernel_id = m_original_wr_mf->get_kernel_id();
+  else
+    kernel_id = m_access.get_kernel_id();
   mem_access_t acc = access; 
   if (inst != NULL)
     inst->m_kernel_id;;
@@ -239,8 +239,10 @@ void memory_stats_t::memlatstat_dram_access(mem_fetch *mf) {
       }
       totalbankwrites[dram_id][bank]++;
     } else {
-      bankreads[mf->get_sid()][dram_id][bank]++;
-      shader_mem_acc_log(mf->get_sid(), dram_id, bank, 'r');
+      if (mf->get_sid() < m_n_shader) {  // L2 prefetches have no shader
+        bankreads[mf->get_sid()][dram_id][bank]++;
+        shader_mem_acc_log(mf->get_sid(), dram_id, bank, 'r');
+      }
       totalbankreads[dram_id][bank]++;
     }
     mem_access_type_stats[mf->get_access_type()][dram_id][bank]++;
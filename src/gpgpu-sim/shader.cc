@@ -118,6 +118,14 @@ shader_core_ctx::shader_core_ctx(class gpgpu_sim *gpu,
     if (m_config->gpgpu_num_int_units > 0)
       assert(m_config->gpgpu_num_sched_per_core ==
              m_pipeline_reg[ID_OC_INT].get_size());
+    // execution units are divided evenly between the sub-cores
+    unsigned n_sched = m_config->gpgpu_num_sched_per_core;
+    assert(m_config->gpgpu_num_sp_units % n_sched == 0);
+    assert(m_config->gpgpu_num_sfu_units % n_sched == 0);
+    assert(m_config->gpgpu_num_dp_units % n_sched == 0);
+    assert(m_config->gpgpu_num_int_units % n_sched == 0);
+    assert(m_config->gpgpu_num_tensor_core_units % n_sched == 0);
+    assert(m_config->pipe_widths[EX_WB] >= (int)n_sched);
   }
 
   m_threadState =
@@ -153,6 +161,8 @@ shader_core_ctx::shader_core_ctx(class gpgpu_sim *gpu,
                               IN_L1I_MISS_QUEUE);
 
   m_warp.resize(m_config->max_warps_per_shader, shd_warp_t(this, warp_size));
+  m_fetch_candidates.init(m_config->max_warps_per_shader);
+  m_ibuffer_filled.init(m_config->max_warps_per_shader);
   m_scoreboard = new Scoreboard(m_sid, m_config->max_warps_per_shader, gpu);
 
   // scedulers
@@ -217,6 +227,18 @@ shader_core_ctx::shader_core_ctx(class gpgpu_sim *gpu,
     };
   }
 
+  // the two level scheduler reshuffles its active set every cycle, so its
+  // idle cycles are not exact copies of each other
+  m_idle_skip_enabled = m_config->gpgpu_skip_idle_core_cycles &&
+                        scheduler != CONCRETE_SCHEDULER_TWO_LEVEL_ACTIVE;
+  m_idle_state = CORE_AWAKE;
+
+  m_inst_trace_mode = m_gpu->get_config().get_inst_trace_mode();
+  if (m_inst_trace_mode != INST_TRACE_OFF) {
+    assert(m_config->warp_size <= 32);  // lane masks are stored as 32 bits
+    m_warp_trace.resize(m_config->max_warps_per_shader);
+  }
+
   for (unsigned i = 0; i < m_warp.size(); i++) {
     // distribute i's evenly though schedulers;
     schedulers[i % m_config->gpgpu_num_sched_per_core]->add_supervised_warp_id(
@@ -403,6 +425,27 @@ shader_core_ctx::shader_core_ctx(class gpgpu_sim *gpu,
     this->m_result_bus.push_back(new std::bitset<MAX_ALU_LATENCY>());
   }
 
+  // in the sub-core model, unit k of each kind belongs to sub-core
+  // k % num_sched and each sub-core gets an equal share of the result buses;
+  // the LD/ST unit stays shared
+  if (m_config->sub_core_model) {
+    unsigned n_sched = m_config->gpgpu_num_sched_per_core;
+    unsigned buses = num_result_bus / n_sched;
+    for (unsigned i = 0; i < n_sched; i++)
+      m_partitions.push_back(
+          shader_core_partition(i, i * buses, (i + 1) * buses));
+  }
+  unsigned units_of_kind[N_PIPELINE_STAGES] = {0};
+  for (unsigned n = 0; n < m_fu.size(); n++) {
+    if (m_partitions.empty() || m_fu[n] == m_ldst_unit) {
+      m_shared_fu.push_back(n);
+      continue;
+    }
+    unsigned k = units_of_kind[m_issue_port[n]]++;
+    m_partitions[k % m_partitions.size()].add_function_unit(m_fu[n],
+                                                            m_issue_port[n]);
+  }
+
   m_last_inst_gpu_sim_cycle = 0;
   m_last_inst_gpu_tot_sim_cycle = 0;
 
@@ -417,6 +460,7 @@ shader_core_ctx::shader_core_ctx(class gpgpu_sim *gpu,
 
 void shader_core_ctx::reinit(unsigned start_thread, unsigned end_thread,
                              bool reset_not_completed) {
+  wake_up();
   if (reset_not_completed) {
     m_not_completed = 0;
     m_active_threads.reset();
@@ -428,7 +472,7 @@ void shader_core_ctx::reinit(unsigned start_thread, unsigned end_thread,
     m_occupied_ctas = 0;
     m_occupied_hwtid.reset();
     m_occupied_cta_to_hwtid.clear();
-    m_active_warps = 0;
+    set_active_warps(0);
   }
   for (unsigned i = start_thread; i < end_thread; i++) {
     m_threadState[i].n_insn = 0;
@@ -445,7 +489,8 @@ void shader_core_ctx::init_warps(unsigned cta_id, unsigned start_thread,
                                  unsigned end_thread, unsigned ctaid,
                                  int cta_size, unsigned kernel_id) {
   address_type start_pc = next_pc(start_thread);
-  if (m_config->model == POST_DOMINATOR) {
+  if (m_config->model == POST_DOMINATOR ||
+      m_config->model == INDEPENDENT_THREAD_SCHEDULING) {
     unsigned start_warp = start_thread / m_config->warp_size;
     unsigned warp_per_cta = cta_size / m_config->warp_size;
     unsigned end_warp = end_thread / m_config->warp_size +
@@ -480,9 +525,15 @@ void shader_core_ctx::init_warps(unsigned cta_id, unsigned start_thread,
       }
 
       m_warp[i].init(start_pc, cta_id, i, active_threads, m_dynamic_warp_id, kernel_id);
+      if (m_inst_trace_mode == INST_TRACE_CAPTURE)
+        m_warp_trace[i].bind(m_gpu->get_inst_trace(kernel_id), ctaid,
+                             i - start_warp);
+      else if (m_inst_trace_mode == INST_TRACE_REPLAY)
+        m_gpu->get_inst_trace(kernel_id)->take_warp(ctaid, i - start_warp,
+                                                     m_warp_trace[i]);
       ++m_dynamic_warp_id;
       m_not_completed += n_active;
-      ++m_active_warps;
+      set_active_warps(m_active_warps + 1);
     }
   }
 }
@@ -509,6 +560,15 @@ void shader_core_ctx::get_pdom_stack_top_info(unsigned tid, unsigned *pc,
   m_simt_stack[warp_id]->get_pdom_stack_top_info(pc, rpc);
 }
 
+void shader_core_ctx::set_active_warps(int n) {
+  m_stats->m_active_warps_sum += n - m_active_warps;
+  if (m_active_warps == 0 && n > 0)
+    m_stats->m_occupied_warp_slots += m_warp.size();
+  else if (m_active_warps > 0 && n == 0)
+    m_stats->m_occupied_warp_slots -= m_warp.size();
+  m_active_warps = n;
+}
+
 float shader_core_ctx::get_current_occupancy(unsigned long long &active,
                                              unsigned long long &total) const {
   // To match the achieved_occupancy in nvprof, only SMs that are active are
@@ -522,6 +582,15 @@ float shader_core_ctx::get_current_occupancy(unsigned long long &active,
   }
 }
 
+static void print_shmem_conflict_distro(
+    FILE *fout, const char *name, unsigned id, bool hex,
+    const std::vector<unsigned long long> &distro) {
+  fprintf(fout, hex ? "%s[0x%04x] =" : "%s[%u] =", name, id);
+  for (unsigned d = 1; d < distro.size(); d++)
+    if (distro[d]) fprintf(fout, " %u:%llu", d, distro[d]);
+  fprintf(fout, "\n");
+}
+
 void shader_core_stats::print(FILE *fout) const {
   unsigned long long thread_icount_uarch = 0;
   unsigned long long warp_icount_uarch = 0;
@@ -550,10 +619,26 @@ void shader_core_stats::print(FILE *fout) const {
   fprintf(fout, "gpgpu_n_param_mem_insn = %d\n", gpgpu_n_param_insn);
 
   fprintf(fout, "gpgpu_n_shmem_bkconflict = %d\n", gpgpu_n_shmem_bkconflict);
+  fprintf(fout, "gpgpu_n_shmem_phase_cycles = %d\n",
+          gpgpu_n_shmem_phase_cycles);
+  // conflict degree -> number of warp accesses; per instruction only for
+  // those that conflicted
+  std::map<unsigned, std::vector<unsigned long long>>::const_iterator k;
+  for (k = m_shmem_conflict_kernel.begin(); k != m_shmem_conflict_kernel.end();
+       ++k)
+    print_shmem_conflict_distro(fout, "gpgpu_shmem_conflict_degree_kernel",
+                                k->first, false, k->second);
+  std::map<address_type, std::vector<unsigned long long>>::const_iterator p;
+  for (p = m_shmem_conflict_pc.begin(); p != m_shmem_conflict_pc.end(); ++p)
+    if (p->second.size() > 2)
+      print_shmem_conflict_distro(fout, "gpgpu_shmem_conflict_degree_pc",
+                                  p->first, true, p->second);
   fprintf(fout, "gpgpu_n_cache_bkconflict = %d\n", gpgpu_n_cache_bkconflict);
 
   fprintf(fout, "gpgpu_n_intrawarp_mshr_merge = %d\n",
           gpgpu_n_intrawarp_mshr_merge);
+  if (m_config->l1d_prefetcher != L1D_PREFETCH_NONE)
+    m_l1d_prefetch_stats.print(fout);
   fprintf(fout, "gpgpu_n_cmem_portconflict = %d\n", gpgpu_n_cmem_portconflict);
 
   fprintf(fout, "gpgpu_stall_shd_mem[c_mem][resource_stall] = %d\n",
@@ -629,6 +714,9 @@ void shader_core_stats::print(FILE *fout) const {
 
   fprintf(fout, "gpu_reg_bank_conflict_stalls = %d\n",
           gpu_reg_bank_conflict_stalls);
+  if (m_config->gpgpu_skip_idle_core_cycles)
+    fprintf(fout, "gpgpu_n_skipped_idle_cycles = %llu\n",
+            gpgpu_n_skipped_idle_cycles);
 
   fprintf(fout, "Warp Occupancy Distribution:\n");
   fprintf(fout, "Stall:%d\t", shader_cycle_distro[2]);
@@ -666,6 +754,24 @@ void shader_core_stats::event_warp_issued(unsigned s_id, unsigned warp_id,
   }
 }
 
+void shader_core_stats::event_shmem_access(unsigned kernel_id,
+                                           address_type pc,
+                                           unsigned conflict_degree,
+                                           unsigned phases) {
+  // a wide access served in phases is not conflicting; only the cycles
+  // beyond one per phase are
+  assert(phases > 0 && conflict_degree >= phases);
+  gpgpu_n_shmem_bkconflict += conflict_degree - phases;
+  gpgpu_n_shmem_phase_cycles += phases - 1;
+  conflict_degree -= phases - 1;
+  std::vector<unsigned long long> &k = m_shmem_conflict_kernel[kernel_id];
+  if (k.size() <= conflict_degree) k.resize(conflict_degree + 1);
+  k[conflict_degree]++;
+  std::vector<unsigned long long> &p = m_shmem_conflict_pc[pc];
+  if (p.size() <= conflict_degree) p.resize(conflict_degree + 1);
+  p[conflict_degree]++;
+}
+
 void shader_core_stats::visualizer_print(gzFile visualizer_file) {
   // warp divergence breakdown
   gzprintf(visualizer_file, "WarpDivergenceBreakdown:");
@@ -831,9 +937,21 @@ void shader_core_ctx::fetch() {
       // find an active warp with space in instruction buffer that is not
       // already waiting on a cache miss and get next 1-2 instructions from
       // i-cache...
-      for (unsigned i = 0; i < m_config->max_warps_per_shader; i++) {
-        unsigned warp_id =
-            (m_last_warp_fetched + 1 + i) % m_config->max_warps_per_shader;
+      unsigned n_warps = m_config->max_warps_per_shader;
+      unsigned first = (m_last_warp_fetched + 1) % n_warps;
+      for (unsigned i = 0; i < n_warps; i++) {
+        // skip ahead to the next candidate in round robin order: first the
+        // warps in [first, n_warps), then those in [0, first)
+        unsigned from = (first + i) % n_warps;
+        int next =
+            m_fetch_candidates.find(from, from < first ? first : n_warps);
+        if (next < 0) {
+          if (from < first || first == 0) break;
+          i = n_warps - first - 1;
+          continue;
+        }
+        i += next - from;
+        unsigned warp_id = next;
 
         // this code checks if this warp has finished executing and can be
         // reclaimed
@@ -854,7 +972,7 @@ void shader_core_ctx::fetch() {
             }
           }
           if (did_exit) m_warp[warp_id].set_done_exit();
-          --m_active_warps;
+          set_active_warps(m_active_warps - 1);
           assert(m_active_warps >= 0);
         }
 
@@ -904,6 +1022,11 @@ void shader_core_ctx::fetch() {
           }
           break;
         }
+
+        // not fetchable and nothing left to reclaim; shd_warp_t adds the warp
+        // back once either may have changed
+        if (!m_warp[warp_id].functional_done() || m_warp[warp_id].done_exit())
+          m_fetch_candidates.clear(warp_id);
       }
     }
   }
@@ -912,13 +1035,165 @@ void shader_core_ctx::fetch() {
 }
 
 void shader_core_ctx::func_exec_inst(warp_inst_t &inst) {
-  execute_warp_inst_t(inst);
+  if (m_inst_trace_mode == INST_TRACE_REPLAY) {
+    replay_warp_inst(inst);
+  } else if (m_inst_trace_mode == INST_TRACE_CAPTURE) {
+    active_mask_t issued = inst.get_active_mask();
+    execute_warp_inst_t(inst);
+    capture_warp_inst(inst, issued);
+  } else {
+    execute_warp_inst_t(inst);
+  }
   if (inst.is_load() || inst.is_store()) {
     inst.generate_mem_accesses();
     // inst.print_m_accessq();
   }
 }
 
+/* Trace record of one dynamic warp instruction, all fields host-endian:
+ *   u32 pc, u32 active lanes (after predication), u32 lanes that exited
+ *   u8 n, n x {u32 lanes, u32 next pc}      for the other issued lanes
+ *   u32 return pc                           if reconvergence_pc is the
+ *                                           RECONVERGE_RETURN_PC marker
+ *   u8 space, u32 bank, u32 data_size, u8 atomic
+ *   per active lane: u8 n, n x u64 address  for loads and stores
+ * Local addresses are stored before translate_local_memaddr() so a replay
+ * may place the CTA on different hardware threads.
+ */
+void shader_core_ctx::capture_warp_inst(const warp_inst_t &inst,
+                                        const active_mask_t &issued) {
+  unsigned warp_id = inst.warp_id();
+  unsigned wtid = warp_id * m_config->warp_size;
+  warp_trace_t &trace = m_warp_trace[warp_id];
+
+  unsigned active = 0, exited = 0, n_groups = 0;
+  unsigned group_lanes[MAX_WARP_SIZE];
+  address_type group_pc[MAX_WARP_SIZE];
+  for (unsigned t = 0; t < m_config->warp_size; t++) {
+    if (!issued.test(t)) continue;
+    if (inst.active(t)) active |= 1u << t;
+    if (ptx_thread_done(wtid + t)) {
+      exited |= 1u << t;
+      continue;
+    }
+    address_type npc = m_thread[wtid + t]->get_pc();
+    unsigned g = 0;
+    while (g < n_groups && group_pc[g] != npc) g++;
+    if (g == n_groups) {
+      group_lanes[n_groups] = 0;
+      group_pc[n_groups++] = npc;
+    }
+    group_lanes[g] |= 1u << t;
+  }
+  trace.put32(inst.pc);
+  trace.put32(active);
+  trace.put32(exited);
+  trace.put8(n_groups);
+  for (unsigned g = 0; g < n_groups; g++) {
+    trace.put32(group_lanes[g]);
+    trace.put32(group_pc[g]);
+  }
+  if (inst.reconvergence_pc == RECONVERGE_RETURN_PC) {
+    // resolved the same way updateSIMTStack() will
+    address_type rpc = RECONVERGE_RETURN_PC;
+    for (unsigned t = 0; t < m_config->warp_size; t++) {
+      if (!ptx_thread_done(wtid + t)) {
+        rpc = get_return_pc(m_thread[wtid + t]);
+        break;
+      }
+    }
+    trace.put32(rpc);
+  }
+
+  trace.put8(inst.space.get_type());
+  trace.put32(inst.space.get_bank());
+  trace.put32(inst.data_size);
+  trace.put8(inst.isatomic());
+  if (inst.is_load() || inst.is_store()) {
+    for (unsigned t = 0; t < m_config->warp_size; t++) {
+      if (!inst.active(t)) continue;
+      if (inst.space.is_local()) {
+        trace.put8(1);
+        trace.put64(m_trace_local_addr[t]);
+        continue;
+      }
+      unsigned n = 1;
+      while (n < MAX_ACCESSES_PER_INSN_PER_THREAD && inst.get_addr(t, n)) n++;
+      trace.put8(n);
+      for (unsigned i = 0; i < n; i++) trace.put64(inst.get_addr(t, i));
+    }
+  }
+
+  if (m_warp[warp_id].functional_done()) trace.kernel()->write_warp(trace);
+}
+
+void shader_core_ctx::replay_warp_inst(warp_inst_t &inst) {
+  unsigned warp_id = inst.warp_id();
+  unsigned wtid = warp_id * m_config->warp_size;
+  warp_trace_t &trace = m_warp_trace[warp_id];
+  active_mask_t issued = inst.get_active_mask();
+
+  unsigned pc = trace.get32();
+  if (pc != inst.pc) {
+    printf(
+        "GPGPU-Sim uArch: ERROR instruction trace out of sync: shader %u "
+        "warp %u issued pc 0x%x, trace has 0x%x (cta %u warp %u)\n",
+        m_sid, warp_id, inst.pc, pc, trace.ctaid(), trace.warp());
+    abort();
+  }
+  unsigned active = trace.get32();
+  unsigned exited = trace.get32();
+  address_type next_pc[MAX_WARP_SIZE];
+  unsigned n_groups = trace.get8();
+  for (unsigned g = 0; g < n_groups; g++) {
+    unsigned lanes = trace.get32();
+    address_type npc = trace.get32();
+    for (unsigned t = 0; t < m_config->warp_size; t++)
+      if (lanes & (1u << t)) next_pc[t] = npc;
+  }
+  if (inst.reconvergence_pc == RECONVERGE_RETURN_PC)
+    inst.reconvergence_pc = trace.get32();
+
+  memory_space_t space((enum _memory_space_t)trace.get8());
+  space.set_bank(trace.get32());
+  unsigned data_size = trace.get32();
+  bool atomic = trace.get8();
+
+  for (unsigned t = 0; t < m_config->warp_size; t++) {
+    if (!issued.test(t)) continue;
+    if (!(active & (1u << t))) {
+      inst.set_not_active(t);
+      continue;
+    }
+    inst.space = space;
+    inst.data_size = data_size;
+    if (atomic) inst.add_callback(t, NULL, NULL, NULL, true);
+    if (inst.is_load() || inst.is_store()) {
+      new_addr_type addrs[MAX_ACCESSES_PER_INSN_PER_THREAD];
+      unsigned n = trace.get8();
+      assert(n <= MAX_ACCESSES_PER_INSN_PER_THREAD);
+      for (unsigned i = 0; i < n; i++) addrs[i] = trace.get64();
+      inst.set_addr(t, addrs, n);
+    }
+  }
+
+  // thread state the timing model reads back: next pc for the SIMT stack,
+  // and exit for warp and CTA completion
+  for (unsigned t = 0; t < m_config->warp_size; t++) {
+    if (!issued.test(t)) continue;
+    unsigned tid = wtid + t;
+    if (exited & (1u << t)) {
+      m_thread[tid]->set_done();
+      m_thread[tid]->exitCore();
+      m_thread[tid]->registerExit();
+    } else {
+      m_thread[tid]->set_npc(next_pc[t]);
+      m_thread[tid]->update_pc();
+    }
+    checkExecutionStatusAndUpdate(inst, t, tid);
+  }
+}
+
 void shader_core_ctx::issue_warp(register_set &pipe_reg_set,
                                  const warp_inst_t *next_inst,
                                  const active_mask_t &active_mask,
@@ -1073,6 +1348,9 @@ void scheduler_unit::cycle() {
     SCHED_DPRINTF("Testing (warp_id %u, dynamic_warp_id %u)\n",
                   (*iter)->get_warp_id(), (*iter)->get_dynamic_warp_id());
     unsigned warp_id = (*iter)->get_warp_id();
+    // nothing to issue; skipping waiting() here only defers releasing a
+    // drained memory barrier to the next look at this warp
+    if (!m_shader->ibuffer_filled(warp_id)) continue;
     unsigned checked = 0;
     unsigned issued = 0;
     exec_unit_type_t previous_issued_inst_exec_type = exec_unit_type_t::NONE;
@@ -1532,8 +1810,9 @@ unsigned shader_core_ctx::translate_local_memaddr(
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////
-int shader_core_ctx::test_res_bus(int latency) {
-  for (unsigned i = 0; i < num_result_bus; i++) {
+int shader_core_ctx::test_res_bus(int latency, unsigned begin,
+                                  unsigned end) {
+  for (unsigned i = begin; i < end; i++) {
     if (!m_result_bus[i]->test(latency)) {
       return i;
     }
@@ -1545,26 +1824,40 @@ void shader_core_ctx::execute() {
   for (unsigned i = 0; i < num_result_bus; i++) {
     *(m_result_bus[i]) >>= 1;
   }
-  for (unsigned n = 0; n < m_num_function_units; n++) {
-    unsigned multiplier = m_fu[n]->clock_multiplier();
-    for (unsigned c = 0; c < multiplier; c++) m_fu[n]->cycle();
-    m_fu[n]->active_lanes_in_pipeline();
-    enum pipeline_stage_name_t issue_port = m_issue_port[n];
-    register_set &issue_inst = m_pipeline_reg[issue_port];
-    warp_inst_t **ready_reg = issue_inst.get_ready();
-    if (issue_inst.has_ready() && m_fu[n]->can_issue(**ready_reg)) {
-      bool schedule_wb_now = !m_fu[n]->stallable();
-      int resbus = -1;
-      if (schedule_wb_now &&
-          (resbus = test_res_bus((*ready_reg)->latency)) != -1) {
-        assert((*ready_reg)->latency < MAX_ALU_LATENCY);
-        m_result_bus[resbus]->set((*ready_reg)->latency);
-        m_fu[n]->issue(issue_inst);
-      } else if (!schedule_wb_now) {
-        m_fu[n]->issue(issue_inst);
-      } else {
-        // stall issue (cannot reserve result bus)
-      }
+  // a sub-core only dispatches to its own units and result buses
+  for (unsigned p = 0; p < m_partitions.size(); p++) {
+    const shader_core_partition &part = m_partitions[p];
+    for (unsigned n = 0; n < part.num_function_units(); n++)
+      execute_unit(part.get_function_unit(n), part.get_issue_port(n),
+                   part.result_bus_begin(), part.result_bus_end());
+  }
+  for (unsigned n = 0; n < m_shared_fu.size(); n++)
+    execute_unit(m_fu[m_shared_fu[n]], m_issue_port[m_shared_fu[n]], 0,
+                 num_result_bus);
+}
+
+void shader_core_ctx::execute_unit(simd_function_unit *fu,
+                                   enum pipeline_stage_name_t issue_port,
+                                   unsigned result_bus_begin,
+                                   unsigned result_bus_end) {
+  unsigned multiplier = fu->clock_multiplier();
+  for (unsigned c = 0; c < multiplier; c++) fu->cycle();
+  fu->active_lanes_in_pipeline();
+  register_set &issue_inst = m_pipeline_reg[issue_port];
+  warp_inst_t **ready_reg = fu->get_ready(issue_inst);
+  if (ready_reg && fu->can_issue(**ready_reg)) {
+    bool schedule_wb_now = !fu->stallable();
+    int resbus = -1;
+    if (schedule_wb_now &&
+        (resbus = test_res_bus((*ready_reg)->latency, result_bus_begin,
+                               result_bus_end)) != -1) {
+      assert((*ready_reg)->latency < MAX_ALU_LATENCY);
+      m_result_bus[resbus]->set((*ready_reg)->latency);
+      fu->issue(issue_inst);
+    } else if (!schedule_wb_now) {
+      fu->issue(issue_inst);
+    } else {
+      // stall issue (cannot reserve result bus)
     }
   }
 }
@@ -1622,10 +1915,14 @@ void shader_core_ctx::writeback() {
   unsigned max_committed_thread_instructions =
       m_config->warp_size *
       (m_config->pipe_widths[EX_WB]);  // from the functional units
+  unsigned committed =
+      m_stats->m_num_sim_insn[m_sid] - m_stats->m_last_num_sim_insn[m_sid];
   m_stats->m_pipeline_duty_cycle[m_sid] =
-      ((float)(m_stats->m_num_sim_insn[m_sid] -
-               m_stats->m_last_num_sim_insn[m_sid])) /
-      max_committed_thread_instructions;
+      ((float)committed) / max_committed_thread_instructions;
+  m_stats->m_pipeline_committed_sum -=
+      m_stats->m_pipeline_committed_insn[m_sid];
+  m_stats->m_pipeline_committed_sum += committed;
+  m_stats->m_pipeline_committed_insn[m_sid] = committed;
 
   m_stats->m_last_num_sim_insn[m_sid] = m_stats->m_num_sim_insn[m_sid];
   m_stats->m_last_num_sim_winsn[m_sid] = m_stats->m_num_sim_winsn[m_sid];
@@ -1757,9 +2054,9 @@ mem_stage_stall_type ldst_unit::process_memory_access_queue_l1cache(
       unsigned bank_id = m_config->m_L1D_config.set_bank(mf->get_addr());
       assert(bank_id < m_config->m_L1D_config.l1_banks);
 
-      if ((l1_latency_queue[bank_id][m_config->m_L1D_config.l1_latency - 1]) ==
-          NULL) {
-        l1_latency_queue[bank_id][m_config->m_L1D_config.l1_latency - 1] = mf;
+      m_L1D_demand_access = true;
+      if (l1_latency_queue_free(bank_id)) {
+        l1_latency_queue_push(bank_id, mf);
 
         if (mf->get_inst().is_store()) {
           unsigned inc_ack =
@@ -1797,10 +2094,30 @@ mem_stage_stall_type ldst_unit::process_memory_access_queue_l1cache(
   }
 }
 
+// A bank takes one new request per cycle, which reaches the L1D l1_latency
+// cycles later unless the request ahead of it still waits there.  This is
+// the timing of a shift register of l1_latency slots in which a request
+// moves forward whenever the next slot is free, without the shifting.
+bool ldst_unit::l1_latency_queue_free(unsigned bank) const {
+  const unsigned latency = m_config->m_L1D_config.l1_latency;
+  const std::deque<l1_latency_entry> &q = l1_latency_queue[bank];
+  return q.size() < latency &&
+         (q.empty() || q.back().ready < m_l1_latency_cycle + latency);
+}
+
+void ldst_unit::l1_latency_queue_push(unsigned bank, mem_fetch *mf) {
+  assert(l1_latency_queue_free(bank));
+  l1_latency_entry e = {mf,
+                        m_l1_latency_cycle + m_config->m_L1D_config.l1_latency};
+  l1_latency_queue[bank].push_back(e);
+}
+
 void ldst_unit::L1_latency_queue_cycle() {
+  m_l1_latency_cycle++;
   for (int j = 0; j < m_config->m_L1D_config.l1_banks; j++) {
-    if ((l1_latency_queue[j][0]) != NULL) {
-      mem_fetch *mf_next = l1_latency_queue[j][0];
+    if (!l1_latency_queue[j].empty() &&
+        l1_latency_queue[j].front().ready <= m_l1_latency_cycle) {
+      mem_fetch *mf_next = l1_latency_queue[j].front().mf;
       std::list<cache_event> events;
       enum cache_request_status status =
           m_L1D->access(mf_next->get_addr(), mf_next,
@@ -1811,9 +2128,27 @@ void ldst_unit::L1_latency_queue_cycle() {
       bool write_sent = was_write_sent(events);
       bool read_sent = was_read_sent(events);
 
-      if (status == HIT) {
+      if (mf_next->get_access_type() == L1_PREFETCH_ACC) {
+        l1_latency_queue[j].pop_front();
+        if (status == HIT || status == RESERVATION_FAIL) {
+          // filled since it was probed, or the L1D has no room for it now
+          if (status == RESERVATION_FAIL)
+            m_stats->m_l1d_prefetch_stats.dropped++;
+          delete mf_next;
+        } else {
+          // waits in the MSHRs; writeback() drops it once it is filled
+          m_prefetch_inflight++;
+          if (read_sent) {
+            m_stats->m_l1d_prefetch_stats.issued++;
+            new_addr_type atom =
+                m_config->m_L1D_config.mshr_addr(mf_next->get_addr());
+            prefetched_slot(atom) = atom;
+          }
+        }
+      } else if (status == HIT) {
+        if (m_prefetcher) prefetch_demand_access(mf_next, status, read_sent);
         assert(!read_sent);
-        l1_latency_queue[j][0] = NULL;
+        l1_latency_queue[j].pop_front();
         if (mf_next->get_inst().is_load()) {
           for (unsigned r = 0; r < MAX_OUTPUT_VALUES; r++)
             if (mf_next->get_inst().out[r] > 0) {
@@ -1851,16 +2186,10 @@ void ldst_unit::L1_latency_queue_cycle() {
         assert(!write_sent);
       } else {
         assert(status == MISS || status == HIT_RESERVED);
-        l1_latency_queue[j][0] = NULL;
+        if (m_prefetcher) prefetch_demand_access(mf_next, status, read_sent);
+        l1_latency_queue[j].pop_front();
       }
     }
-
-    for (unsigned stage = 0; stage < m_config->m_L1D_config.l1_latency - 1;
-         ++stage)
-      if (l1_latency_queue[j][stage] == NULL) {
-        l1_latency_queue[j][stage] = l1_latency_queue[j][stage + 1];
-        l1_latency_queue[j][stage + 1] = NULL;
-      }
   }
 }
 
@@ -1907,21 +2236,14 @@ bool ldst_unit::memory_cycle(warp_inst_t &inst,
   mem_stage_stall_type stall_cond = NO_RC_FAIL;
   const mem_access_t &access = inst.accessq_back();
 
-  bool bypassL1D = false;
-  if (CACHE_GLOBAL == inst.cache_op || (m_L1D == NULL)) {
-    bypassL1D = true;
-  } else if (inst.space.is_global()) {  // global memory access
-    // skip L1 cache if the option is enabled
-    if (m_core->get_config()->gmem_skip_L1D && (CACHE_L1 != inst.cache_op))
-      bypassL1D = true;
-  }
-  if (bypassL1D) {
+  if (bypass_L1D(inst)) {
     // bypass L1 cache
     unsigned control_size =
         inst.is_store() ? WRITE_PACKET_SIZE : READ_PACKET_SIZE;
     unsigned size = access.get_size() + control_size;
     // printf("Interconnect:Addr: %x, size=%d\n",access.get_addr(),size);
-    if (m_icnt->full(size, inst.is_store() || inst.isatomic())) {
+    if (m_icnt->full(size, inst.is_store() || inst.isatomic(),
+                     inst.m_kernel_id)) {
       stall_cond = ICNT_RC_FAIL;
     } else {
       mem_fetch *mf =
@@ -1955,6 +2277,138 @@ bool ldst_unit::memory_cycle(warp_inst_t &inst,
   return inst.accessq_empty();
 }
 
+bool ldst_unit::bypass_L1D(const warp_inst_t &inst) const {
+  if (CACHE_GLOBAL == inst.cache_op || (m_L1D == NULL)) return true;
+  // global memory access; skip L1 cache if the option is enabled
+  return inst.space.is_global() && m_core->get_config()->gmem_skip_L1D &&
+         (CACHE_L1 != inst.cache_op);
+}
+
+new_addr_type &ldst_unit::prefetched_slot(new_addr_type atom) {
+  return m_prefetched[(atom / m_config->m_L1D_config.get_atom_sz()) %
+                      m_prefetched.size()];
+}
+
+void ldst_unit::train_prefetcher(const warp_inst_t &inst) {
+  if (!inst.is_load() || inst.isatomic() || inst.accessq_empty() ||
+      ((inst.space.get_type() != global_space) &&
+       (inst.space.get_type() != local_space) &&
+       (inst.space.get_type() != param_space_local)) ||
+      bypass_L1D(inst))
+    return;
+
+  // the lowest address stands for the whole warp access
+  const std::vector<mem_access_t> &accessq = inst.get_accessq();
+  new_addr_type base = accessq[0].get_addr();
+  for (unsigned i = 1; i < accessq.size(); i++)
+    base = std::min(base, accessq[i].get_addr());
+  m_prefetch_offsets.clear();
+  m_prefetcher->observe(inst.pc, inst.warp_id(), base, m_prefetch_offsets);
+
+  // expect a future instance to touch the same pattern, shifted by offset
+  const unsigned atom_sz = m_config->m_L1D_config.get_atom_sz();
+  for (unsigned o = 0; o < m_prefetch_offsets.size(); o++) {
+    for (unsigned i = 0; i < accessq.size(); i++) {
+      new_addr_type start = accessq[i].get_addr() + m_prefetch_offsets[o];
+      new_addr_type end = start + accessq[i].get_size();
+      for (new_addr_type atom = start & ~(new_addr_type)(atom_sz - 1);
+           atom < end; atom += atom_sz)
+        queue_prefetch(inst, atom);
+    }
+  }
+}
+
+void ldst_unit::queue_prefetch(const warp_inst_t &inst, new_addr_type atom) {
+  if (prefetched_slot(atom) == atom) return;
+  for (unsigned i = 0; i < m_prefetch_queue.size(); i++)
+    if (m_prefetch_queue[i].get_addr() == atom) return;
+
+  if (m_prefetch_queue.size() >= m_config->l1d_prefetch_queue_size) {
+    m_stats->m_l1d_prefetch_stats.dropped++;
+    m_prefetch_queue.pop_front();
+  }
+  const l1d_cache_config &l1 = m_config->m_L1D_config;
+  mem_access_sector_mask_t sector_mask;
+  unsigned first_sector = (atom % l1.get_line_sz()) / SECTOR_SIZE;
+  for (unsigned s = 0; s < l1.get_atom_sz() / SECTOR_SIZE; s++)
+    sector_mask.set(first_sector + s);
+  m_prefetch_queue.push_back(mem_access_t(
+      inst.m_kernel_id, L1_PREFETCH_ACC, atom, l1.get_atom_sz(), false,
+      active_mask_t(), mem_access_byte_mask_t(), sector_mask,
+      m_core->get_gpu()->gpgpu_ctx));
+}
+
+void ldst_unit::issue_prefetch() {
+  // Lowest priority: wait for a cycle in which no demand access entered the
+  // L1D, keep l1d_prefetch_mshr_reserve MSHRs free for demand misses, and
+  // never hold more than half of the MSHRs.
+  bool demand_access = m_L1D_demand_access;
+  m_L1D_demand_access = false;
+  const l1d_cache_config &l1 = m_config->m_L1D_config;
+  if (m_prefetch_queue.empty() || demand_access ||
+      m_L1D->mshr_occupancy() + m_config->l1d_prefetch_mshr_reserve >=
+          l1.get_mshr_entries() ||
+      m_prefetch_inflight >= l1.get_mshr_entries() / 2)
+    return;
+
+  const mem_access_t &access = m_prefetch_queue.front();
+  unsigned bank = l1.set_bank(access.get_addr());
+  if (!l1_latency_queue_free(bank)) return;
+
+  enum cache_request_status probe =
+      m_L1D->probe(access.get_addr(), access.get_sector_mask());
+  if (probe == RESERVATION_FAIL) {
+    m_stats->m_l1d_prefetch_stats.dropped++;
+  } else if (probe != HIT && probe != HIT_RESERVED) {
+    l1_latency_queue_push(
+        bank, new mem_fetch(access, NULL, READ_PACKET_SIZE, -1, m_sid, m_tpc,
+                            m_memory_config,
+                            m_core->get_gpu()->gpu_sim_cycle +
+                                m_core->get_gpu()->gpu_tot_sim_cycle));
+  }
+  m_prefetch_queue.pop_front();
+}
+
+void ldst_unit::prefetch_demand_access(mem_fetch *mf,
+                                       enum cache_request_status status,
+                                       bool read_sent) {
+  // a read that missed without sending a request merged into an
+  // outstanding one
+  bool miss = (status != HIT) && read_sent;
+  new_addr_type atom = m_config->m_L1D_config.mshr_addr(mf->get_addr());
+  new_addr_type &p = prefetched_slot(atom);
+  if (p != atom) return;
+  // a miss means the prefetched atom was evicted before it was read
+  p = (new_addr_type)-1;
+  if (!miss && mf->get_inst().is_load()) {
+    m_stats->m_l1d_prefetch_stats.useful++;
+    if (status != HIT) m_stats->m_l1d_prefetch_stats.late++;
+  }
+}
+
+bool ldst_unit::idle() const {
+  if (!m_dispatch_reg->empty() || !m_next_wb.empty() || m_next_global ||
+      !m_response_fifo.empty() || active_insts_in_pipeline)
+    return false;
+  if (m_L1T->access_ready() || !m_L1T->idle()) return false;
+  if (m_L1C->access_ready() || !m_L1C->idle()) return false;
+  if (m_L1D) {
+    if (m_L1D->access_ready() || !m_L1D->idle()) return false;
+    if (!m_prefetch_queue.empty()) return false;
+    for (unsigned j = 0; j < l1_latency_queue.size(); j++)
+      if (!l1_latency_queue[j].empty()) return false;
+  }
+  return true;
+}
+
+// Equivalent of cycle() when idle(): only the round-robin state of the
+// operand collector and the cache port statistics advance
+void ldst_unit::idle_cycle() {
+  m_operand_collector->idle_step();
+  m_L1C->idle_cycle();
+  if (m_L1D) m_L1D->idle_cycle();
+}
+
 bool ldst_unit::response_buffer_full() const {
   return m_response_fifo.size() >= m_config->ldst_unit_response_queue_size;
 }
@@ -1979,6 +2433,7 @@ void ldst_unit::invalidate() {
 simd_function_unit::simd_function_unit(const shader_core_config *config) {
   m_config = config;
   m_dispatch_reg = new warp_inst_t(config);
+  m_sub_core = -1;
 }
 
 sfu::sfu(register_set *result_port, const shader_core_config *config,
@@ -1996,7 +2451,7 @@ tensor_core::tensor_core(register_set *result_port,
 }
 
 void sfu::issue(register_set &source_reg) {
-  warp_inst_t **ready_reg = source_reg.get_ready();
+  warp_inst_t **ready_reg = get_ready(source_reg);
   // m_core->incexecstat((*ready_reg));
 
   (*ready_reg)->op_pipe = SFU__OP;
@@ -2005,7 +2460,7 @@ void sfu::issue(register_set &source_reg) {
 }
 
 void tensor_core::issue(register_set &source_reg) {
-  warp_inst_t **ready_reg = source_reg.get_ready();
+  warp_inst_t **ready_reg = get_ready(source_reg);
   // m_core->incexecstat((*ready_reg));
 
   (*ready_reg)->op_pipe = TENSOR_CORE__OP;
@@ -2088,7 +2543,7 @@ int_unit::int_unit(register_set *result_port, const shader_core_config *config,
 }
 
 void sp_unit ::issue(register_set &source_reg) {
-  warp_inst_t **ready_reg = source_reg.get_ready();
+  warp_inst_t **ready_reg = get_ready(source_reg);
   // m_core->incexecstat((*ready_reg));
   (*ready_reg)->op_pipe = SP__OP;
   m_core->incsp_stat(m_core->get_config()->warp_size, (*ready_reg)->latency);
@@ -2096,7 +2551,7 @@ void sp_unit ::issue(register_set &source_reg) {
 }
 
 void dp_unit ::issue(register_set &source_reg) {
-  warp_inst_t **ready_reg = source_reg.get_ready();
+  warp_inst_t **ready_reg = get_ready(source_reg);
   // m_core->incexecstat((*ready_reg));
   (*ready_reg)->op_pipe = DP__OP;
   m_core->incsp_stat(m_core->get_config()->warp_size, (*ready_reg)->latency);
@@ -2104,7 +2559,7 @@ void dp_unit ::issue(register_set &source_reg) {
 }
 
 void int_unit ::issue(register_set &source_reg) {
-  warp_inst_t **ready_reg = source_reg.get_ready();
+  warp_inst_t **ready_reg = get_ready(source_reg);
   // m_core->incexecstat((*ready_reg));
   (*ready_reg)->op_pipe = INTP__OP;
   m_core->incsp_stat(m_core->get_config()->warp_size, (*ready_reg)->latency);
@@ -2148,7 +2603,7 @@ void pipelined_simd_unit::cycle() {
 
 void pipelined_simd_unit::issue(register_set &source_reg) {
   // move_warp(m_dispatch_reg,source_reg);
-  warp_inst_t **ready_reg = source_reg.get_ready();
+  warp_inst_t **ready_reg = get_ready(source_reg);
   m_core->incexecstat((*ready_reg));
   // source_reg.move_out_to(m_dispatch_reg);
   simd_function_unit::issue(source_reg);
@@ -2197,6 +2652,10 @@ void ldst_unit::init(mem_fetch_interface *icnt,
   m_next_global = NULL;
   m_last_inst_gpu_sim_cycle = 0;
   m_last_inst_gpu_tot_sim_cycle = 0;
+  m_prefetcher = NULL;
+  m_prefetch_inflight = 0;
+  m_L1D_demand_access = false;
+  m_l1_latency_cycle = 0;
 }
 
 ldst_unit::ldst_unit(mem_fetch_interface *icnt,
@@ -2220,9 +2679,15 @@ ldst_unit::ldst_unit(mem_fetch_interface *icnt,
     l1_latency_queue.resize(m_config->m_L1D_config.l1_banks);
     assert(m_config->m_L1D_config.l1_latency > 0);
 
-    for (unsigned j = 0; j < m_config->m_L1D_config.l1_banks; j++)
-      l1_latency_queue[j].resize(m_config->m_L1D_config.l1_latency,
-                                 (mem_fetch *)NULL);
+    if (m_config->l1d_prefetcher == L1D_PREFETCH_STRIDE) {
+      const l1d_cache_config &l1 = m_config->m_L1D_config;
+      m_prefetcher = new l1d_stride_prefetcher(
+          m_config->l1d_prefetch_table_size, m_config->l1d_prefetch_degree,
+          m_config->l1d_prefetch_distance);
+      m_prefetched.assign(
+          l1.get_max_num_lines() * (l1.get_line_sz() / l1.get_atom_sz()),
+          (new_addr_type)-1);
+    }
   }
   m_name = "MEM ";
 }
@@ -2241,7 +2706,7 @@ ldst_unit::ldst_unit(mem_fetch_interface *icnt,
 }
 
 void ldst_unit::issue(register_set &reg_set) {
-  warp_inst_t *inst = *(reg_set.get_ready());
+  warp_inst_t *inst = *get_ready(reg_set);
 
   // record how many pending register writes/memory accesses there are for this
   // instruction
@@ -2257,8 +2722,14 @@ void ldst_unit::issue(register_set &reg_set) {
     }
   }
 
+  if (m_prefetcher) train_prefetcher(*inst);
+
   inst->op_pipe = MEM__OP;
   // stat collection
+  if (inst->space.get_type() == shared_space)
+    m_stats->event_shmem_access(inst->m_kernel_id, inst->pc,
+                                inst->shmem_conflict_degree(),
+                                inst->shmem_phases());
   m_core->mem_instruction_stats(*inst);
   m_core->incmem_stat(m_core->get_config()->warp_size, 1);
   pipelined_simd_unit::issue(reg_set);
@@ -2312,6 +2783,8 @@ void ldst_unit::writeback() {
           }
           m_core->dec_inst_in_pipeline(m_pipeline_reg[0]->warp_id());
           m_pipeline_reg[0]->clear();
+          assert(active_insts_in_pipeline > 0);
+          active_insts_in_pipeline--;
           serviced_client = next_client;
         }
         break;
@@ -2346,6 +2819,13 @@ void ldst_unit::writeback() {
       case 4:
         if (m_L1D && m_L1D->access_ready()) {
           mem_fetch *mf = m_L1D->next_access();
+          if (mf->get_access_type() == L1_PREFETCH_ACC) {
+            // the block is in the L1D now; nobody waits for it
+            assert(m_prefetch_inflight > 0);
+            m_prefetch_inflight--;
+            delete mf;
+            break;
+          }
           m_next_wb = mf->get_inst();
           delete mf;
           serviced_client = next_client;
@@ -2395,9 +2875,11 @@ inst->space.get_type() != shared_space) { unsigned warp_id = inst->warp_id();
 void ldst_unit::cycle() {
   writeback();
   m_operand_collector->step();
-  for (unsigned stage = 0; (stage + 1) < m_pipeline_depth; stage++)
-    if (m_pipeline_reg[stage]->empty() && !m_pipeline_reg[stage + 1]->empty())
-      move_warp(m_pipeline_reg[stage], m_pipeline_reg[stage + 1]);
+  if (active_insts_in_pipeline) {
+    for (unsigned stage = 0; (stage + 1) < m_pipeline_depth; stage++)
+      if (m_pipeline_reg[stage]->empty() && !m_pipeline_reg[stage + 1]->empty())
+        move_warp(m_pipeline_reg[stage], m_pipeline_reg[stage + 1]);
+  }
 
   if (!m_response_fifo.empty()) {
     mem_fetch *mf = m_response_fifo.front();
@@ -2469,6 +2951,7 @@ void ldst_unit::cycle() {
   done &= texture_cycle(pipe_reg, rc_fail, type);
   done &= memory_cycle(pipe_reg, rc_fail, type);
   m_mem_rc = rc_fail;
+  if (m_prefetcher) issue_prefetch();
 
   if (!done) {  // log stall types and return
     assert(rc_fail != NO_RC_FAIL);
@@ -2485,6 +2968,7 @@ void ldst_unit::cycle() {
           // new shared memory request
           move_warp(m_pipeline_reg[m_config->smem_latency - 1], m_dispatch_reg);
           m_dispatch_reg->clear();
+          active_insts_in_pipeline++;
         }
       } else {
         // if( pipe_reg.active_count() > 0 ) {
@@ -2866,7 +3350,8 @@ void shader_core_ctx::print_stage(unsigned int stage, FILE *fout) const {
 }
 
 void shader_core_ctx::display_simt_state(FILE *fout, int mask) const {
-  if ((mask & 4) && m_config->model == POST_DOMINATOR) {
+  if ((mask & 4) && (m_config->model == POST_DOMINATOR ||
+                     m_config->model == INDEPENDENT_THREAD_SCHEDULING)) {
     fprintf(fout, "per warp SIMT control-flow state:\n");
     unsigned n = m_config->n_thread_per_shader / m_config->warp_size;
     for (unsigned i = 0; i < n; i++) {
@@ -3311,6 +3796,7 @@ void shader_core_config::set_pipeline_latency() {
   unsigned dp_latency[5];
   unsigned sfu_latency;
   unsigned tensor_latency;
+  unsigned tensor_acc_latency[2];
 
   /*
    * [0] ADD,SUB
@@ -3331,6 +3817,8 @@ void shader_core_config::set_pipeline_latency() {
          &dp_latency[4]);
   sscanf(gpgpu_ctx->func_sim->opcode_latency_sfu, "%u", &sfu_latency);
   sscanf(gpgpu_ctx->func_sim->opcode_latency_tensor, "%u", &tensor_latency);
+  sscanf(gpgpu_ctx->func_sim->opcode_latency_tensor_acc, "%u,%u",
+         &tensor_acc_latency[0], &tensor_acc_latency[1]);
 
   // all div operation are executed on sfu
   // assume that the max latency are dp div or normal sfu_latency
@@ -3339,12 +3827,24 @@ void shader_core_config::set_pipeline_latency() {
   max_sp_latency = fp_latency[1];
   max_int_latency = std::max(int_latency[1], int_latency[5]);
   max_dp_latency = dp_latency[1];
-  max_tensor_core_latency = tensor_latency;
+  // the tensor core pipeline must be deep enough for the slowest wmma.mma
+  max_tensor_core_latency = std::max(
+      tensor_latency, std::max(tensor_acc_latency[0], tensor_acc_latency[1]));
 }
 
 void shader_core_ctx::cycle() {
   if (!isactive() && get_not_completed() == 0) return;
 
+  if (m_idle_state == CORE_ASLEEP) {
+    idle_cycle();
+    return;
+  }
+  unsigned distro[3];
+  if (m_idle_state == CORE_PROBE_IDLE) {
+    for (unsigned i = 0; i < 3; i++)
+      distro[i] = m_stats->shader_cycle_distro[i];
+  }
+
   m_stats->shader_cycles[m_sid]++;
   writeback();
   execute();
@@ -3352,6 +3852,70 @@ void shader_core_ctx::cycle() {
   issue();
   decode();
   fetch();
+
+  if (m_idle_state == CORE_PROBE_IDLE) {
+    // nothing could move in this cycle, so every following cycle up to the
+    // next memory response is an exact copy of it
+    for (unsigned i = 0; i < 3; i++)
+      m_idle_distro_delta[i] = m_stats->shader_cycle_distro[i] - distro[i];
+    m_idle_state = idle_until_response() ? CORE_ASLEEP : CORE_AWAKE;
+  } else if (m_idle_skip_enabled && idle_until_response()) {
+    m_idle_state = CORE_PROBE_IDLE;
+  }
+}
+
+// True if no pipeline stage of this core can change state until a response
+// arrives from the memory system (or a new CTA is issued): the front-end has
+// nothing to fetch, the pipeline and function units are drained and every
+// warp is blocked on a barrier, a memory barrier, an atomic or the scoreboard.
+bool shader_core_ctx::idle_until_response() {
+  if (m_inst_fetch_buffer.m_valid || m_L1I->access_ready() || !m_L1I->idle())
+    return false;
+  for (unsigned i = 0; i < m_pipeline_reg.size(); i++)
+    if (m_pipeline_reg[i].has_ready()) return false;
+  for (unsigned i = 0; i < num_result_bus; i++)
+    if (m_result_bus[i]->any()) return false;
+  for (unsigned n = 0; n < m_num_function_units; n++)
+    if (!m_fu[n]->idle()) return false;
+  if (!m_operand_collector.idle()) return false;
+
+  for (unsigned w = 0; w < m_warp.size(); w++) {
+    shd_warp_t &warp = m_warp[w];
+    // fetch() would reclaim this warp or fetch for it
+    if (warp.hardware_done() && !m_scoreboard->pendingWrites(w) &&
+        !warp.done_exit())
+      return false;
+    if (!warp.functional_done() && !warp.imiss_pending() &&
+        warp.ibuffer_empty())
+      return false;
+    // waiting() releases a memory barrier once its writes have drained
+    if (warp.get_membar() && !m_scoreboard->pendingWrites(w)) return false;
+    if (warp.done_exit() || warp.waiting() || warp.ibuffer_empty()) continue;
+
+    // the scheduler must find the next instruction blocked on the scoreboard
+    const warp_inst_t *pI = warp.ibuffer_next_inst();
+    if (!pI) {
+      if (warp.ibuffer_next_valid()) return false;
+      continue;
+    }
+    if (pI->m_is_cdp && warp.m_cdp_latency > 0) return false;
+    unsigned pc, rpc;
+    m_simt_stack[w]->get_pdom_stack_top_info(&pc, &rpc);
+    if (pc != pI->pc || !m_scoreboard->checkCollision(w, pI)) return false;
+  }
+  return true;
+}
+
+// Replays the side effects of a cycle in which idle_until_response() holds
+void shader_core_ctx::idle_cycle() {
+  m_stats->shader_cycles[m_sid]++;
+  m_stats->gpgpu_n_skipped_idle_cycles++;
+  for (unsigned i = 0; i < 3; i++)
+    m_stats->shader_cycle_distro[i] += m_idle_distro_delta[i];
+  unsigned multiplier = m_ldst_unit->clock_multiplier();
+  for (unsigned c = 0; c < multiplier; c++) m_ldst_unit->idle_cycle();
+  Issue_Prio = (Issue_Prio + 1) % schedulers.size();
+  m_L1I->idle_cycle();
 }
 
 // Flushes all content of the cache to memory
@@ -3361,83 +3925,48 @@ void shader_core_ctx::cache_flush() { m_ldst_unit->flush(); }
 void shader_core_ctx::cache_invalidate() { m_ldst_unit->invalidate(); }
 
 // modifiers
-std::list<opndcoll_rfu_t::op_t> opndcoll_rfu_t::arbiter_t::allocate_reads() {
-  std::list<op_t>
-      result;  // a list of registers that (a) are in different register banks,
-               // (b) do not go to the same operand collector
-
-  int input;
-  int output;
-  int _inputs = m_num_banks;
-  int _outputs = m_num_collectors;
-  int _square = (_inputs > _outputs) ? _inputs : _outputs;
-  assert(_square > 0);
-  int _pri = (int)m_last_cu;
-
-  // Clear matching
-  for (int i = 0; i < _inputs; ++i) _inmatch[i] = -1;
-  for (int j = 0; j < _outputs; ++j) _outmatch[j] = -1;
-
-  for (unsigned i = 0; i < m_num_banks; i++) {
-    for (unsigned j = 0; j < m_num_collectors; j++) {
-      assert(i < (unsigned)_inputs);
-      assert(j < (unsigned)_outputs);
-      _request[i][j] = 0;
-    }
-    if (!m_queue[i].empty()) {
-      const op_t &op = m_queue[i].front();
-      int oc_id = op.get_oc_id();
-      assert(i < (unsigned)_inputs);
-      assert(oc_id < _outputs);
-      _request[i][oc_id] = 1;
-    }
-    if (m_allocated_bank[i].is_write()) {
-      assert(i < (unsigned)_inputs);
-      _inmatch[i] = 0;  // write gets priority
+//
+// Wavefront allocator from booksim over the square bank x collector request
+// matrix, in which each bank requests the collector unit of its oldest
+// read.  Diagonal p pairs bank i with collector (m_last_cu + p + i) % square
+// and diagonals are visited in order, so a collector is granted to the
+// requesting bank on the lowest diagonal; two banks asking for the same
+// collector always lie on different diagonals.  Banks allocated for a write
+// neither request nor block a collector.
+void opndcoll_rfu_t::arbiter_t::allocate_reads(std::vector<op_t> &result) {
+  result.clear();  // registers in different banks, for different collectors
+  unsigned square =
+      (m_num_banks > m_num_collectors) ? m_num_banks : m_num_collectors;
+  unsigned pri = m_last_cu;
+
+  for (int b = m_requests.find(0, m_num_banks); b >= 0;
+       b = m_requests.find(b + 1, m_num_banks)) {
+    if (m_allocated_bank[b].is_write()) continue;  // write gets priority
+    unsigned cu = m_queue[b].front().get_oc_id();
+    assert(cu < m_num_collectors);
+    unsigned diagonal = (cu + 2 * square - b - pri) % square;
+    if (!m_cu_requested.test(cu) || diagonal < m_cu_diagonal[cu]) {
+      m_cu_requested.set(cu);
+      m_cu_diagonal[cu] = diagonal;
+      m_cu_bank[cu] = b;
     }
   }
-
-  ///// wavefront allocator from booksim... --->
-
-  // Loop through diagonals of request matrix
-
-  for (int p = 0; p < _square; ++p) {
-    output = (_pri + p) % _square;
-
-    // Step through the current diagonal
-    for (input = 0; input < _inputs; ++input) {
-      assert(input < _inputs);
-      assert(output < _outputs);
-      if ((output < _outputs) && (_inmatch[input] == -1) &&
-          (_outmatch[output] == -1) &&
-          (_request[input][output] /*.label != -1*/)) {
-        // Grant!
-        _inmatch[input] = output;
-        _outmatch[output] = input;
-      }
-
-      output = (output + 1) % _square;
-    }
+  for (int cu = m_cu_requested.find(0, m_num_collectors); cu >= 0;
+       cu = m_cu_requested.find(cu + 1, m_num_collectors)) {
+    m_cu_requested.clear(cu);
+    m_granted.set(m_cu_bank[cu]);
   }
 
   // Round-robin the priority diagonal
-  _pri = (_pri + 1) % _square;
-
-  /// <--- end code from booksim
-
-  m_last_cu = _pri;
-  for (unsigned i = 0; i < m_num_banks; i++) {
-    if (_inmatch[i] != -1) {
-      if (!m_allocated_bank[i].is_write()) {
-        unsigned bank = (unsigned)i;
-        op_t &op = m_queue[bank].front();
-        result.push_back(op);
-        m_queue[bank].pop_front();
-      }
-    }
-  }
+  m_last_cu = (pri + 1) % square;
 
-  return result;
+  for (int b = m_granted.find(0, m_num_banks); b >= 0;
+       b = m_granted.find(b + 1, m_num_banks)) {
+    m_granted.clear(b);
+    result.push_back(m_queue[b].front());
+    m_queue[b].pop_front();
+    if (m_queue[b].empty()) m_requests.clear(b);
+  }
 }
 
 barrier_set_t::barrier_set_t(shader_core_ctx *shader,
@@ -3683,6 +4212,7 @@ void shader_core_ctx::broadcast_barrier_reduction(unsigned cta_id,
 bool shader_core_ctx::fetch_unit_response_buffer_full() const { return false; }
 
 void shader_core_ctx::accept_fetch_response(mem_fetch *mf) {
+  wake_up();
   mf->set_status(IN_SHADER_FETCHED,
                  m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle);
   m_L1I->fill(mf, m_gpu->gpu_sim_cycle + m_gpu->gpu_tot_sim_cycle);
@@ -3693,6 +4223,7 @@ bool shader_core_ctx::ldst_unit_response_buffer_full() const {
 }
 
 void shader_core_ctx::accept_ldst_unit_response(mem_fetch *mf) {
+  wake_up();
   m_ldst_unit->fill(mf);
 }
 
@@ -3741,6 +4272,41 @@ bool shd_warp_t::hardware_done() const {
   return functional_done() && stores_done() && !inst_in_pipeline();
 }
 
+void shd_warp_t::ibuffer_fill(unsigned slot, const warp_inst_t *pI) {
+  assert(slot < IBUFFER_SIZE);
+  m_ibuffer[slot].m_inst = pI;
+  m_ibuffer[slot].m_valid = true;
+  m_next = 0;
+  update_ibuffer_state();
+}
+
+void shd_warp_t::ibuffer_flush() {
+  for (unsigned i = 0; i < IBUFFER_SIZE; i++) {
+    if (m_ibuffer[i].m_valid) dec_inst_in_pipeline();
+    m_ibuffer[i].m_inst = NULL;
+    m_ibuffer[i].m_valid = false;
+  }
+  update_ibuffer_state();
+}
+
+void shd_warp_t::ibuffer_free() {
+  m_ibuffer[m_next].m_inst = NULL;
+  m_ibuffer[m_next].m_valid = false;
+  update_ibuffer_state();
+}
+
+void shd_warp_t::update_fetch_candidate() {
+  // a reset warp is done and exited; init() adds it back
+  if (m_warp_id != (unsigned)-1) m_shader->set_fetch_candidate(m_warp_id);
+}
+
+void shd_warp_t::update_ibuffer_state() {
+  if (m_warp_id == (unsigned)-1) return;
+  bool empty = ibuffer_empty();
+  m_shader->set_ibuffer_filled(m_warp_id, !empty);
+  if (empty) m_shader->set_fetch_candidate(m_warp_id);
+}
+
 bool shd_warp_t::waiting() {
   if (functional_done()) {
     // waiting to be initialized with a kernel
@@ -3810,7 +4376,7 @@ void opndcoll_rfu_t::add_cu_set(unsigned set_id, unsigned num_cu,
   }
   // for now each collector set gets dedicated dispatch units.
   for (unsigned i = 0; i < num_dispatch; i++) {
-    m_dispatch_units.push_back(dispatch_unit_t(&m_cus[set_id]));
+    m_dispatch_units.push_back(dispatch_unit_t(&m_cus[set_id], &m_cu_ready));
   }
 }
 
@@ -3845,13 +4411,23 @@ void opndcoll_rfu_t::init(unsigned num_banks, shader_core_ctx *shader) {
   m_num_banks_per_sched =
       num_banks / shader->get_config()->gpgpu_num_sched_per_core;
 
+  m_cu_free.init(m_cu.size());
+  m_cu_ready.init(m_cu.size());
   for (unsigned j = 0; j < m_cu.size(); j++) {
     m_cu[j]->init(j, num_banks, m_bank_warp_shift, shader->get_config(), this,
                   sub_core_model, m_num_banks_per_sched);
+    m_cu_free.set(j);
   }
+  m_read_grants.reserve(num_banks);
   m_initialized = true;
 }
 
+bool opndcoll_rfu_t::idle() const {
+  for (unsigned n = 0; n < m_cu.size(); n++)
+    if (!m_cu[n]->is_free()) return false;
+  return m_arbiter.idle();
+}
+
 int register_bank(int regnum, int wid, unsigned num_banks,
                   unsigned bank_warp_shift, bool sub_core_model,
                   unsigned banks_per_sched, unsigned sched_id) {
@@ -3940,46 +4516,61 @@ void opndcoll_rfu_t::dispatch_ready_cu() {
 
 void opndcoll_rfu_t::allocate_cu(unsigned port_num) {
   input_port_t &inp = m_in_ports[port_num];
-  for (unsigned i = 0; i < inp.m_in.size(); i++) {
-    if ((*inp.m_in[i]).has_ready()) {
-      // find a free cu
-      for (unsigned j = 0; j < inp.m_cu_sets.size(); j++) {
-        std::vector<collector_unit_t> &cu_set = m_cus[inp.m_cu_sets[j]];
-        bool allocated = false;
-        for (unsigned k = 0; k < cu_set.size(); k++) {
-          if (cu_set[k].is_free()) {
-            collector_unit_t *cu = &cu_set[k];
-            allocated = cu->allocate(inp.m_in[i], inp.m_out[i]);
-            m_arbiter.add_read_requests(cu);
-            break;
-          }
+  if (sub_core_model) {
+    // each sub-core collects its operands in its own slice of the cu sets, so
+    // a full slice only stalls the instructions of that sub-core
+    for (unsigned s = 0; s < m_num_warp_sceds; s++) {
+      for (unsigned i = 0; i < inp.m_in.size(); i++) {
+        if (s < inp.m_in[i]->get_size() && inp.m_in[i]->get_ready(true, s)) {
+          allocate_cu(inp, i, s);
+          break;  // one input per sub-core
         }
-        if (allocated) break;  // cu has been allocated, no need to search more.
       }
+    }
+    return;
+  }
+  for (unsigned i = 0; i < inp.m_in.size(); i++) {
+    if ((*inp.m_in[i]).has_ready()) {
+      allocate_cu(inp, i, 0);
       break;  // can only service a single input, if it failed it will fail for
               // others.
     }
   }
 }
 
+// move the ready instruction of input i (slot reg_id in the sub-core model)
+// into a free cu of the port's sets
+bool opndcoll_rfu_t::allocate_cu(input_port_t &inp, unsigned i,
+                                 unsigned reg_id) {
+  // find a free cu; the units of a set have consecutive hw ids
+  for (unsigned j = 0; j < inp.m_cu_sets.size(); j++) {
+    std::vector<collector_unit_t> &cu_set = m_cus[inp.m_cu_sets[j]];
+    if (cu_set.empty()) continue;
+    unsigned base = cu_set[0].get_id();
+    unsigned end = base + cu_set.size();
+    unsigned per_sched = cu_set.size() / m_num_warp_sceds;
+    if (sub_core_model && per_sched > 0) {
+      base += reg_id * per_sched;
+      end = base + per_sched;
+    }
+    int k = m_cu_free.find(base, end);
+    if (k >= 0) {
+      collector_unit_t *cu = m_cu[k];
+      bool allocated = cu->allocate(inp.m_in[i], inp.m_out[i], reg_id);
+      m_arbiter.add_read_requests(cu);
+      if (allocated) return true;  // no need to search more.
+    }
+  }
+  return false;
+}
+
 void opndcoll_rfu_t::allocate_reads() {
-  // process read requests that do not have conflicts
-  std::list<op_t> allocated = m_arbiter.allocate_reads();
-  std::map<unsigned, op_t> read_ops;
-  for (std::list<op_t>::iterator r = allocated.begin(); r != allocated.end();
-       r++) {
-    const op_t &rr = *r;
-    unsigned reg = rr.get_reg();
-    unsigned wid = rr.get_wid();
-    unsigned bank =
-        register_bank(reg, wid, m_num_banks, m_bank_warp_shift, sub_core_model,
-                      m_num_banks_per_sched, rr.get_sid());
-    m_arbiter.allocate_for_read(bank, rr);
-    read_ops[bank] = rr;
-  }
-  std::map<unsigned, op_t>::iterator r;
-  for (r = read_ops.begin(); r != read_ops.end(); ++r) {
-    op_t &op = r->second;
+  // process read requests that do not have conflicts; one per bank, in bank
+  // order
+  m_arbiter.allocate_reads(m_read_grants);
+  for (unsigned r = 0; r < m_read_grants.size(); r++) {
+    op_t &op = m_read_grants[r];
+    m_arbiter.allocate_for_read(op.get_bank(), op);
     unsigned cu = op.get_oc_id();
     unsigned operand = op.get_operand();
     m_cu[cu]->collect_operand(operand);
@@ -4004,7 +4595,8 @@ void opndcoll_rfu_t::allocate_reads() {
 }
 
 bool opndcoll_rfu_t::collector_unit_t::ready() const {
-  return (!m_free) && m_not_ready.none() && (*m_output_register).has_free();
+  return (!m_free) && m_not_ready.none() &&
+         (*m_output_register).has_free(m_sub_core_model, m_warp->get_schd_id());
 }
 
 void opndcoll_rfu_t::collector_unit_t::dump(
@@ -4039,12 +4631,15 @@ void opndcoll_rfu_t::collector_unit_t::init(unsigned n, unsigned num_banks,
 }
 
 bool opndcoll_rfu_t::collector_unit_t::allocate(register_set *pipeline_reg_set,
-                                                register_set *output_reg_set) {
+                                                register_set *output_reg_set,
+                                                unsigned reg_id) {
   assert(m_free);
   assert(m_not_ready.none());
   m_free = false;
+  m_rfu->m_cu_free.clear(m_cuid);
   m_output_register = output_reg_set;
-  warp_inst_t **pipeline_reg = pipeline_reg_set->get_ready();
+  warp_inst_t **pipeline_reg =
+      pipeline_reg_set->get_ready(m_sub_core_model, reg_id);
   if ((pipeline_reg) and !((*pipeline_reg)->empty())) {
     m_warp_id = (*pipeline_reg)->warp_id();
     for (unsigned op = 0; op < MAX_REG_OPERANDS; op++) {
@@ -4061,17 +4656,21 @@ bool opndcoll_rfu_t::collector_unit_t::allocate(register_set *pipeline_reg_set,
         m_src_op[op] = op_t();
     }
     // move_warp(m_warp,*pipeline_reg);
-    pipeline_reg_set->move_out_to(m_warp);
+    pipeline_reg_set->move_out_to(m_sub_core_model, reg_id, m_warp);
+    if (m_not_ready.none()) m_rfu->m_cu_ready.set(m_cuid);
     return true;
   }
+  m_rfu->m_cu_ready.set(m_cuid);
   return false;
 }
 
 void opndcoll_rfu_t::collector_unit_t::dispatch() {
   assert(m_not_ready.none());
   // move_warp(*m_output_register,m_warp);
-  m_output_register->move_in(m_warp);
+  m_output_register->move_in(m_sub_core_model, m_warp->get_schd_id(), m_warp);
   m_free = true;
+  m_rfu->m_cu_free.set(m_cuid);
+  m_rfu->m_cu_ready.clear(m_cuid);
   m_output_register = NULL;
   for (unsigned i = 0; i < MAX_REG_OPERANDS * 2; i++) m_src_op[i].reset();
 }
@@ -4292,10 +4891,11 @@ void simt_core_cluster::cache_invalidate() {
     m_core[i]->cache_invalidate();
 }
 
-bool simt_core_cluster::icnt_injection_buffer_full(unsigned size, bool write) {
+bool simt_core_cluster::icnt_injection_buffer_full(unsigned size, bool write,
+                                                   unsigned kernel_id) {
   unsigned request_size = size;
   if (!write) request_size = READ_PACKET_SIZE;
-  return !::icnt_has_buffer(m_cluster_id, request_size);
+  return !::icnt_has_buffer(m_cluster_id, request_size, kernel_id);
 }
 
 void simt_core_cluster::icnt_inject_request_packet(class mem_fetch *mf) {
@@ -4340,6 +4940,8 @@ void simt_core_cluster::icnt_inject_request_packet(class mem_fetch *mf) {
     case L2_WR_ALLOC_R:
       m_stats->gpgpu_n_mem_l2_write_allocate++;
       break;
+    case L1_PREFETCH_ACC:  // counted in m_l1d_prefetch_stats
+      break;
     default:
       assert(0);
   }
@@ -4497,6 +5099,8 @@ void shader_core_ctx::checkExecutionStatusAndUpdate(warp_inst_t &inst,
                                                     unsigned t, unsigned tid) {
   if (inst.isatomic()) m_warp[inst.warp_id()].inc_n_atomic();
   if (inst.space.is_local() && (inst.is_load() || inst.is_store())) {
+    if (m_inst_trace_mode == INST_TRACE_CAPTURE)
+      m_trace_local_addr[t] = inst.get_addr(t);
     new_addr_type localaddrs[MAX_ACCESSES_PER_INSN_PER_THREAD];
     unsigned num_addrs;
     num_addrs = translate_local_memaddr(
@@ -49,6 +49,8 @@
 #include "delayqueue.h"
 #include "dram.h"
 #include "gpu-cache.h"
+#include "inst_trace.h"
+#include "l1d_prefetcher.h"
 #include "mem_fetch.h"
 #include "scoreboard.h"
 #include "stack.h"
@@ -82,6 +84,35 @@ enum exec_unit_type_t {
   TENSOR = 6
 };
 
+// one bit per register bank, collector unit or warp
+class bit_mask_t {
+ public:
+  void init(unsigned n_bits) { m_words.assign((n_bits + 63) / 64, 0); }
+  void set(unsigned i) { m_words[i >> 6] |= 1ULL << (i & 63); }
+  void clear(unsigned i) { m_words[i >> 6] &= ~(1ULL << (i & 63)); }
+  bool test(unsigned i) const { return (m_words[i >> 6] >> (i & 63)) & 1; }
+  bool none() const {
+    for (unsigned w = 0; w < m_words.size(); w++)
+      if (m_words[w]) return false;
+    return true;
+  }
+  // lowest set bit in [from, end), or -1
+  int find(unsigned from, unsigned end) const {
+    if (from >= end) return -1;
+    unsigned w = from >> 6;
+    unsigned long long bits = m_words[w] & (~0ULL << (from & 63));
+    while (!bits) {
+      if (++w << 6 >= end) return -1;
+      bits = m_words[w];
+    }
+    unsigned i = (w << 6) + __builtin_ctzll(bits);
+    return (i < end) ? (int)i : -1;
+  }
+
+ private:
+  std::vector<unsigned long long> m_words;
+};
+
 class thread_ctx_t {
  public:
   unsigned m_cta_id;  // hardware CTA this thread belongs
@@ -140,6 +171,8 @@ class shd_warp_t {
     // Jin: cdp support
     m_cdp_latency = 0;
     m_cdp_dummy = false;
+    update_fetch_candidate();
+    update_ibuffer_state();
   }
 
   bool functional_done() const;
@@ -157,6 +190,7 @@ class shd_warp_t {
     assert(m_active_threads.test(lane));
     m_active_threads.reset(lane);
     n_completed++;
+    if (functional_done()) update_fetch_candidate();
   }
 
   void set_last_fetch(unsigned long long sim_cycle) {
@@ -180,35 +214,24 @@ class shd_warp_t {
     return &m_inst_at_barrier;
   }
 
-  void ibuffer_fill(unsigned slot, const warp_inst_t *pI) {
-    assert(slot < IBUFFER_SIZE);
-    m_ibuffer[slot].m_inst = pI;
-    m_ibuffer[slot].m_valid = true;
-    m_next = 0;
-  }
+  void ibuffer_fill(unsigned slot, const warp_inst_t *pI);
   bool ibuffer_empty() const {
     for (unsigned i = 0; i < IBUFFER_SIZE; i++)
       if (m_ibuffer[i].m_valid) return false;
     return true;
   }
-  void ibuffer_flush() {
-    for (unsigned i = 0; i < IBUFFER_SIZE; i++) {
-      if (m_ibuffer[i].m_valid) dec_inst_in_pipeline();
-      m_ibuffer[i].m_inst = NULL;
-      m_ibuffer[i].m_valid = false;
-    }
-  }
+  void ibuffer_flush();
   const warp_inst_t *ibuffer_next_inst() { return m_ibuffer[m_next].m_inst; }
   bool ibuffer_next_valid() { return m_ibuffer[m_next].m_valid; }
-  void ibuffer_free() {
-    m_ibuffer[m_next].m_inst = NULL;
-    m_ibuffer[m_next].m_valid = false;
-  }
+  void ibuffer_free();
   void ibuffer_step() { m_next = (m_next + 1) % IBUFFER_SIZE; }
 
   bool imiss_pending() const { return m_imiss_pending; }
   void set_imiss_pending() { m_imiss_pending = true; }
-  void clear_imiss_pending() { m_imiss_pending = false; }
+  void clear_imiss_pending() {
+    m_imiss_pending = false;
+    update_fetch_candidate();
+  }
 
   bool stores_done() const { return m_stores_outstanding == 0; }
   void inc_store_req() { m_stores_outstanding++; }
@@ -244,6 +267,10 @@ class shd_warp_t {
   unsigned get_kernel_id() {return kernel_id;}
 
  private:
+  // tell the core this warp may have become ready to fetch or reclaim
+  void update_fetch_candidate();
+  void update_ibuffer_state();
+
   static const unsigned IBUFFER_SIZE = 2;
   class shader_core_ctx *m_shader;
   unsigned m_cta_id;
@@ -578,6 +605,10 @@ class opndcoll_rfu_t {  // operand collector based register file unit
     for (unsigned p = 0; p < m_in_ports.size(); p++) allocate_cu(p);
     process_banks();
   }
+  // true when no collector unit is allocated and no read is queued
+  bool idle() const;
+  // equivalent of step() when idle()
+  void idle_step() { m_arbiter.idle_step(); }
 
   void dump(FILE *fp) const {
     fprintf(fp, "\n");
@@ -601,6 +632,9 @@ class opndcoll_rfu_t {  // operand collector based register file unit
   // types
 
   class collector_unit_t;
+  class input_port_t;
+
+  bool allocate_cu(input_port_t &inp, unsigned input, unsigned reg_id);
 
   class op_t {
    public:
@@ -740,16 +774,44 @@ class opndcoll_rfu_t {  // operand collector based register file unit
     op_t m_op;
   };
 
+  // read requests waiting for one bank, oldest first
+  class op_queue_t {
+   public:
+    op_queue_t() : m_head(0), m_count(0), m_mask(0) {}
+    void init(unsigned capacity) {
+      unsigned size = 1;
+      while (size < capacity) size <<= 1;
+      m_data.resize(size);
+      m_mask = size - 1;
+    }
+    bool empty() const { return m_count == 0; }
+    unsigned size() const { return m_count; }
+    const op_t &operator[](unsigned i) const {
+      return m_data[(m_head + i) & m_mask];
+    }
+    const op_t &front() const { return m_data[m_head]; }
+    void push_back(const op_t &op) {
+      assert(m_count < m_data.size());
+      m_data[(m_head + m_count) & m_mask] = op;
+      m_count++;
+    }
+    void pop_front() {
+      assert(m_count > 0);
+      m_head = (m_head + 1) & m_mask;
+      m_count--;
+    }
+
+   private:
+    std::vector<op_t> m_data;
+    unsigned m_head, m_count, m_mask;
+  };
+
   class arbiter_t {
    public:
     // constructors
     arbiter_t() {
       m_queue = NULL;
       m_allocated_bank = NULL;
-      m_allocator_rr_head = NULL;
-      _inmatch = NULL;
-      _outmatch = NULL;
-      _request = NULL;
       m_last_cu = 0;
     }
     void init(unsigned num_cu, unsigned num_banks) {
@@ -757,16 +819,16 @@ class opndcoll_rfu_t {  // operand collector based register file unit
       assert(num_banks > 0);
       m_num_collectors = num_cu;
       m_num_banks = num_banks;
-      _inmatch = new int[m_num_banks];
-      _outmatch = new int[m_num_collectors];
-      _request = new int *[m_num_banks];
-      for (unsigned i = 0; i < m_num_banks; i++)
-        _request[i] = new int[m_num_collectors];
-      m_queue = new std::list<op_t>[num_banks];
+      m_queue = new op_queue_t[num_banks];
+      // a collector unit queues at most one read per source operand
+      for (unsigned b = 0; b < num_banks; b++)
+        m_queue[b].init(num_cu * MAX_REG_OPERANDS * 2);
       m_allocated_bank = new allocation_t[num_banks];
-      m_allocator_rr_head = new unsigned[num_cu];
-      for (unsigned n = 0; n < num_cu; n++)
-        m_allocator_rr_head[n] = n % num_banks;
+      m_requests.init(num_banks);
+      m_granted.init(num_banks);
+      m_cu_requested.init(num_cu);
+      m_cu_diagonal.resize(num_cu);
+      m_cu_bank.resize(num_cu);
       reset_alloction();
     }
 
@@ -777,10 +839,7 @@ class opndcoll_rfu_t {  // operand collector based register file unit
       fprintf(fp, "  requests:\n");
       for (unsigned b = 0; b < m_num_banks; b++) {
         fprintf(fp, "    bank %u : ", b);
-        std::list<op_t>::const_iterator o = m_queue[b].begin();
-        for (; o != m_queue[b].end(); o++) {
-          o->dump(fp);
-        }
+        for (unsigned o = 0; o < m_queue[b].size(); o++) m_queue[b][o].dump(fp);
         fprintf(fp, "\n");
       }
       fprintf(fp, "  grants:\n");
@@ -792,7 +851,7 @@ class opndcoll_rfu_t {  // operand collector based register file unit
     }
 
     // modifiers
-    std::list<op_t> allocate_reads();
+    void allocate_reads(std::vector<op_t> &result);
 
     void add_read_requests(collector_unit_t *cu) {
       const op_t *src = cu->get_operands();
@@ -801,6 +860,7 @@ class opndcoll_rfu_t {  // operand collector based register file unit
         if (op.valid()) {
           unsigned bank = op.get_bank();
           m_queue[bank].push_back(op);
+          m_requests.set(bank);
         }
       }
     }
@@ -818,21 +878,29 @@ class opndcoll_rfu_t {  // operand collector based register file unit
     void reset_alloction() {
       for (unsigned b = 0; b < m_num_banks; b++) m_allocated_bank[b].reset();
     }
+    bool idle() const { return m_requests.none(); }
+    // allocate_reads() rotates the priority diagonal even without requests
+    void idle_step() {
+      unsigned square =
+          (m_num_banks > m_num_collectors) ? m_num_banks : m_num_collectors;
+      m_last_cu = (m_last_cu + 1) % square;
+    }
 
    private:
     unsigned m_num_banks;
     unsigned m_num_collectors;
 
     allocation_t *m_allocated_bank;  // bank # -> register that wins
-    std::list<op_t> *m_queue;
+    op_queue_t *m_queue;
+    bit_mask_t m_requests;  // banks with a queued read
 
-    unsigned *
-        m_allocator_rr_head;  // cu # -> next bank to check for request (rr-arb)
-    unsigned m_last_cu;       // first cu to check while arb-ing banks (rr)
+    unsigned m_last_cu;  // first cu to check while arb-ing banks (rr)
 
-    int *_inmatch;
-    int *_outmatch;
-    int **_request;
+    // matching state of allocate_reads(), kept to avoid reallocation
+    bit_mask_t m_granted;       // banks
+    bit_mask_t m_cu_requested;  // collector units
+    std::vector<unsigned> m_cu_diagonal;  // cu # -> diagonal of best request
+    std::vector<unsigned> m_cu_bank;      // cu # -> bank of best request
   };
 
   class input_port_t {
@@ -878,9 +946,13 @@ class opndcoll_rfu_t {  // operand collector based register file unit
     void init(unsigned n, unsigned num_banks, unsigned log2_warp_size,
               const core_config *config, opndcoll_rfu_t *rfu,
               bool m_sub_core_model, unsigned num_banks_per_sched);
-    bool allocate(register_set *pipeline_reg, register_set *output_reg);
+    bool allocate(register_set *pipeline_reg, register_set *output_reg,
+                  unsigned reg_id);
 
-    void collect_operand(unsigned op) { m_not_ready.reset(op); }
+    void collect_operand(unsigned op) {
+      m_not_ready.reset(op);
+      if (m_not_ready.none()) m_rfu->m_cu_ready.set(m_cuid);
+    }
     unsigned get_num_operands() const { return m_warp->get_num_operands(); }
     unsigned get_num_regs() const { return m_warp->get_num_regs(); }
     void dispatch();
@@ -905,27 +977,44 @@ class opndcoll_rfu_t {  // operand collector based register file unit
 
   class dispatch_unit_t {
    public:
-    dispatch_unit_t(std::vector<collector_unit_t> *cus) {
+    dispatch_unit_t(std::vector<collector_unit_t> *cus,
+                    const bit_mask_t *cu_ready) {
       m_last_cu = 0;
       m_collector_units = cus;
       m_num_collectors = (*cus).size();
       m_next_cu = 0;
+      m_cu_ready = cu_ready;
     }
 
     collector_unit_t *find_ready() {
-      for (unsigned n = 0; n < m_num_collectors; n++) {
-        unsigned c = (m_last_cu + n + 1) % m_num_collectors;
-        if ((*m_collector_units)[c].ready()) {
-          m_last_cu = c;
-          return &((*m_collector_units)[c]);
+      if (!m_num_collectors) return NULL;
+      // the units of a set have consecutive hw ids
+      unsigned base = (*m_collector_units)[0].get_id();
+      unsigned start = (m_last_cu + 1) % m_num_collectors;
+      collector_unit_t *cu = find_ready(base + start, base + m_num_collectors);
+      if (!cu) cu = find_ready(base, base + start);
+      return cu;
+    }
+
+   private:
+    // first unit in [from, end) that has read all its operands and can
+    // move to its output register
+    collector_unit_t *find_ready(unsigned from, unsigned end) {
+      unsigned base = (*m_collector_units)[0].get_id();
+      for (int c = m_cu_ready->find(from, end); c >= 0;
+           c = m_cu_ready->find(c + 1, end)) {
+        collector_unit_t &cu = (*m_collector_units)[c - base];
+        if (cu.ready()) {
+          m_last_cu = c - base;
+          return &cu;
         }
       }
       return NULL;
     }
 
-   private:
     unsigned m_num_collectors;
     std::vector<collector_unit_t> *m_collector_units;
+    const bit_mask_t *m_cu_ready;
     unsigned m_last_cu;  // dispatch ready cu's rr
     unsigned m_next_cu;  // for initialization
   };
@@ -940,6 +1029,10 @@ class opndcoll_rfu_t {  // operand collector based register file unit
   unsigned m_warp_size;
   std::vector<collector_unit_t *> m_cu;
   arbiter_t m_arbiter;
+  std::vector<op_t> m_read_grants;
+  // by hw id: units not allocated, and allocated units with all operands read
+  bit_mask_t m_cu_free;
+  bit_mask_t m_cu_ready;
 
   unsigned m_num_banks_per_sched;
   unsigned m_num_warp_sceds;
@@ -1038,11 +1131,14 @@ class simd_function_unit {
 
   // modifiers
   virtual void issue(register_set &source_reg) {
-    source_reg.move_out_to(m_dispatch_reg);
+    source_reg.move_out_to(m_sub_core >= 0, m_sub_core, m_dispatch_reg);
     occupied.set(m_dispatch_reg->latency);
   }
   virtual void cycle() = 0;
   virtual void active_lanes_in_pipeline() = 0;
+  // in the sub-core model a unit only accepts instructions from the issue
+  // register of the sub-core that owns it
+  void set_sub_core(int sub_core) { m_sub_core = sub_core; }
 
   // accessors
   virtual unsigned clock_multiplier() const { return 1; }
@@ -1050,16 +1146,24 @@ class simd_function_unit {
     return m_dispatch_reg->empty() && !occupied.test(inst.latency);
   }
   virtual bool stallable() const = 0;
+  // true when cycle() would neither move nor retire any instruction
+  virtual bool idle() const = 0;
   virtual void print(FILE *fp) const {
     fprintf(fp, "%s dispatch= ", m_name.c_str());
     m_dispatch_reg->print(fp);
   }
   const char *get_name() { return m_name.c_str(); }
+  int get_sub_core() const { return m_sub_core; }
+  // the instruction issue() would take from source_reg, NULL if none
+  warp_inst_t **get_ready(register_set &source_reg) const {
+    return source_reg.get_ready(m_sub_core >= 0, m_sub_core);
+  }
 
  protected:
   std::string m_name;
   const shader_core_config *m_config;
   warp_inst_t *m_dispatch_reg;
+  int m_sub_core;  // owning sub-core, -1 if shared by the whole core
   static const unsigned MAX_ALU_LATENCY = 512;
   std::bitset<MAX_ALU_LATENCY> occupied;
 };
@@ -1086,6 +1190,10 @@ class pipelined_simd_unit : public simd_function_unit {
   */
   // accessors
   virtual bool stallable() const { return false; }
+  virtual bool idle() const {
+    return m_dispatch_reg->empty() && !active_insts_in_pipeline &&
+           occupied.none();
+  }
   virtual bool can_issue(const warp_inst_t &inst) const {
     return simd_function_unit::can_issue(inst);
   }
@@ -1269,6 +1377,8 @@ class ldst_unit : public pipelined_simd_unit {
 
   virtual void active_lanes_in_pipeline();
   virtual bool stallable() const { return true; }
+  virtual bool idle() const;
+  void idle_cycle();
   bool response_buffer_full() const;
   void print(FILE *fout) const;
   void print_cache_stats(FILE *fp, unsigned &dl1_accesses,
@@ -1346,8 +1456,34 @@ class ldst_unit : public pipelined_simd_unit {
   unsigned long long m_last_inst_gpu_sim_cycle;
   unsigned long long m_last_inst_gpu_tot_sim_cycle;
 
-  std::vector<std::deque<mem_fetch *>> l1_latency_queue;
+  // L1D latency pipeline, per bank: requests in arrival order with the
+  // m_l1_latency_cycle at which each may access the L1D
+  struct l1_latency_entry {
+    mem_fetch *mf;
+    unsigned long long ready;
+  };
+  std::vector<std::deque<l1_latency_entry>> l1_latency_queue;
+  unsigned long long m_l1_latency_cycle;  // calls to L1_latency_queue_cycle
+  bool l1_latency_queue_free(unsigned bank) const;
+  void l1_latency_queue_push(unsigned bank, mem_fetch *mf);
   void L1_latency_queue_cycle();
+
+  // core-side L1D prefetching; m_prefetcher is NULL when it is disabled
+  l1d_stride_prefetcher *m_prefetcher;
+  std::deque<mem_access_t> m_prefetch_queue;
+  // atoms fetched by a prefetch and not yet read, direct mapped; -1 is empty
+  std::vector<new_addr_type> m_prefetched;
+  std::vector<long long> m_prefetch_offsets;
+  unsigned m_prefetch_inflight;
+  bool m_L1D_demand_access;  // a demand access entered the L1D this cycle
+
+  bool bypass_L1D(const warp_inst_t &inst) const;
+  void train_prefetcher(const warp_inst_t &inst);
+  void queue_prefetch(const warp_inst_t &inst, new_addr_type atom);
+  void issue_prefetch();
+  void prefetch_demand_access(mem_fetch *mf, enum cache_request_status status,
+                              bool read_sent);
+  new_addr_type &prefetched_slot(new_addr_type atom);
 };
 
 enum pipeline_stage_name_t {
@@ -1373,6 +1509,44 @@ const char *const pipeline_stage_name_decode[] = {
     "OC_EX_SFU",         "OC_EX_MEM",        "EX_WB",     "ID_OC_TENSOR_CORE",
     "OC_EX_TENSOR_CORE", "N_PIPELINE_STAGES"};
 
+// A sub-core (SM processing block) in the sub-core model. Sub-core i pairs
+// with warp scheduler i: it issues into slot i of the ID_OC registers, reads
+// its own slice of the register file banks and collector units, and owns the
+// execution units and result buses it dispatches to. Sub-cores only meet at
+// the units shared by the whole core (LD/ST) and at writeback.
+class shader_core_partition {
+ public:
+  shader_core_partition(unsigned id, unsigned result_bus_begin,
+                        unsigned result_bus_end)
+      : m_id(id),
+        m_result_bus_begin(result_bus_begin),
+        m_result_bus_end(result_bus_end) {}
+
+  void add_function_unit(simd_function_unit *fu,
+                         enum pipeline_stage_name_t issue_port) {
+    fu->set_sub_core(m_id);
+    m_fu.push_back(fu);
+    m_issue_port.push_back(issue_port);
+  }
+
+  unsigned get_id() const { return m_id; }
+  unsigned num_function_units() const { return m_fu.size(); }
+  simd_function_unit *get_function_unit(unsigned n) const { return m_fu[n]; }
+  enum pipeline_stage_name_t get_issue_port(unsigned n) const {
+    return m_issue_port[n];
+  }
+  // result buses [begin, end) of the core are reserved by this sub-core only
+  unsigned result_bus_begin() const { return m_result_bus_begin; }
+  unsigned result_bus_end() const { return m_result_bus_end; }
+
+ private:
+  unsigned m_id;
+  std::vector<simd_function_unit *> m_fu;
+  std::vector<enum pipeline_stage_name_t> m_issue_port;
+  unsigned m_result_bus_begin;
+  unsigned m_result_bus_end;
+};
+
 class shader_core_config : public core_config {
  public:
   shader_core_config(gpgpu_context *ctx) : core_config(ctx) {
@@ -1381,6 +1555,10 @@ class shader_core_config : public core_config {
   }
 
   void init() {
+    if (model != POST_DOMINATOR && model != INDEPENDENT_THREAD_SCHEDULING) {
+      printf("GPGPU-Sim uArch: error: unknown -gpgpu_simd_model %d\n", model);
+      abort();
+    }
     int ntok = sscanf(gpgpu_shader_core_pipeline_opt, "%d:%d",
                       &n_thread_per_shader, &warp_size);
     if (ntok != 2) {
@@ -1422,6 +1600,15 @@ class shader_core_config : public core_config {
     max_warps_per_shader = n_thread_per_shader / warp_size;
     assert(!(n_thread_per_shader % warp_size));
 
+    if (shmem_bank_width < core_config::WORD_SIZE ||
+        (shmem_bank_width & (shmem_bank_width - 1))) {
+      printf(
+          "GPGPU-Sim uArch: Error ** gpgpu_shmem_bank_width must be a power "
+          "of two of at least %u bytes\n",
+          core_config::WORD_SIZE);
+      abort();
+    }
+
     set_pipeline_latency();
 
     m_L1I_config.init(m_L1I_config.m_config_string, FuncCachePreferNone);
@@ -1430,6 +1617,20 @@ class shader_core_config : public core_config {
     m_L1D_config.init(m_L1D_config.m_config_string, FuncCachePreferNone);
     gpgpu_cache_texl1_linesize = m_L1T_config.get_line_sz();
     gpgpu_cache_constl1_linesize = m_L1C_config.get_line_sz();
+
+    if (l1d_prefetcher != L1D_PREFETCH_NONE) {
+      if (m_L1D_config.disabled()) {
+        printf("GPGPU-Sim uArch: ERROR ** L1D prefetcher needs an L1D cache\n");
+        abort();
+      }
+      if (!l1d_prefetch_degree || !l1d_prefetch_table_size ||
+          !l1d_prefetch_queue_size) {
+        printf(
+            "GPGPU-Sim uArch: ERROR ** L1D prefetch degree, table size and "
+            "queue size must be non-zero\n");
+        abort();
+      }
+    }
     m_valid = true;
   }
   void reg_options(class OptionParser *opp);
@@ -1474,6 +1675,14 @@ class shader_core_config : public core_config {
   mutable cache_config m_L1C_config;
   mutable l1d_cache_config m_L1D_config;
 
+  // core-side L1D prefetching
+  enum l1d_prefetcher_type l1d_prefetcher;
+  unsigned l1d_prefetch_degree;
+  unsigned l1d_prefetch_distance;
+  unsigned l1d_prefetch_table_size;
+  unsigned l1d_prefetch_queue_size;
+  unsigned l1d_prefetch_mshr_reserve;
+
   bool gpgpu_dwf_reg_bankconflict;
 
   unsigned gpgpu_num_sched_per_core;
@@ -1536,6 +1745,7 @@ class shader_core_config : public core_config {
   unsigned ldst_unit_response_queue_size;
 
   int simt_core_sim_order;
+  bool gpgpu_skip_idle_core_cycles;
 
   unsigned smem_latency;
 
@@ -1561,6 +1771,12 @@ struct shader_core_stats_pod {
   unsigned *
       m_num_decoded_insn;  // number of instructions decoded by this shader core
   float *m_pipeline_duty_cycle;
+  // running totals over all shaders, kept current by the cores so the GPU
+  // does not reduce over every shader each cycle
+  unsigned *m_pipeline_committed_insn;  // per shader, in its last cycle
+  unsigned long long m_pipeline_committed_sum;
+  unsigned long long m_active_warps_sum;
+  unsigned long long m_occupied_warp_slots;  // warp slots of active cores
   unsigned *m_num_FPdecoded_insn;
   unsigned *m_num_INTdecoded_insn;
   unsigned *m_num_storequeued_insn;
@@ -1602,6 +1818,7 @@ struct shader_core_stats_pod {
   unsigned gpgpu_n_const_insn;
   unsigned gpgpu_n_param_insn;
   unsigned gpgpu_n_shmem_bkconflict;
+  unsigned gpgpu_n_shmem_phase_cycles;  // beyond the first, per warp access
   unsigned gpgpu_n_cache_bkconflict;
   int gpgpu_n_intrawarp_mshr_merge;
   unsigned gpgpu_n_cmem_portconflict;
@@ -1612,6 +1829,7 @@ struct shader_core_stats_pod {
   unsigned *last_shader_cycle_distro;
   unsigned *num_warps_issuable;
   unsigned gpgpu_n_stall_shd_mem;
+  unsigned long long gpgpu_n_skipped_idle_cycles;
   unsigned *single_issue_nums;
   unsigned *dual_issue_nums;
 
@@ -1654,6 +1872,8 @@ class shader_core_stats : public shader_core_stats_pod {
         (unsigned *)calloc(config->num_shader(), sizeof(unsigned));
     m_pipeline_duty_cycle =
         (float *)calloc(config->num_shader(), sizeof(float));
+    m_pipeline_committed_insn =
+        (unsigned *)calloc(config->num_shader(), sizeof(unsigned));
     m_num_decoded_insn =
         (unsigned *)calloc(config->num_shader(), sizeof(unsigned));
     m_num_FPdecoded_insn =
@@ -1755,6 +1975,8 @@ class shader_core_stats : public shader_core_stats_pod {
 
   void event_warp_issued(unsigned s_id, unsigned warp_id, unsigned num_issued,
                          unsigned dynamic_warp_id);
+  void event_shmem_access(unsigned kernel_id, address_type pc,
+                          unsigned conflict_degree, unsigned phases);
 
   void visualizer_print(gzFile visualizer_file);
 
@@ -1780,6 +2002,13 @@ class shader_core_stats : public shader_core_stats_pod {
   std::vector<std::vector<unsigned>> m_shader_warp_slot_issue_distro;
   std::vector<unsigned> m_last_shader_warp_slot_issue_distro;
 
+  // Shared memory accesses by bank conflict degree (1 + the cycles a warp
+  // access takes beyond one per phase), for each kernel and instruction.
+  std::map<unsigned, std::vector<unsigned long long>> m_shmem_conflict_kernel;
+  std::map<address_type, std::vector<unsigned long long>> m_shmem_conflict_pc;
+
+  l1d_prefetch_stats m_l1d_prefetch_stats;  // all cores
+
   friend class power_stat_t;
   friend class shader_core_ctx;
   friend class ldst_unit;
@@ -1881,6 +2110,19 @@ class shader_core_ctx : public core_t {
   }  // also used in writeback()
   void store_ack(class mem_fetch *mf);
   bool warp_waiting_at_mem_barrier(unsigned warp_id);
+  // kept up to date by shd_warp_t state transitions
+  void set_fetch_candidate(unsigned warp_id) {
+    m_fetch_candidates.set(warp_id);
+  }
+  void set_ibuffer_filled(unsigned warp_id, bool filled) {
+    if (filled)
+      m_ibuffer_filled.set(warp_id);
+    else
+      m_ibuffer_filled.clear(warp_id);
+  }
+  bool ibuffer_filled(unsigned warp_id) const {
+    return m_ibuffer_filled.test(warp_id);
+  }
   void set_max_cta(const kernel_info_t &kernel);
   void warp_inst_complete(const warp_inst_t &inst);
 
@@ -2067,9 +2309,10 @@ class shader_core_ctx : public core_t {
     return (((32 - active_count) >> 1) * latency);
   }
 
-  int test_res_bus(int latency);
+  int test_res_bus(int latency, unsigned begin, unsigned end);
   void init_warps(unsigned cta_id, unsigned start_thread, unsigned end_thread,
                   unsigned ctaid, int cta_size, unsigned kernel_id);
+  void set_active_warps(int n);
   virtual void checkExecutionStatusAndUpdate(warp_inst_t &inst, unsigned t,
                                              unsigned tid);
   address_type next_pc(int tid) const;
@@ -2086,6 +2329,11 @@ class shader_core_ctx : public core_t {
                   const active_mask_t &active_mask, unsigned warp_id,
                   unsigned sch_id);
   void func_exec_inst(warp_inst_t &inst);
+  // instruction trace: record the outcome of executing inst, or apply the
+  // recorded outcome in place of the PTX functional model
+  void capture_warp_inst(const warp_inst_t &inst,
+                         const active_mask_t &issued);
+  void replay_warp_inst(warp_inst_t &inst);
 
   // Returns numbers of addresses in translated_addrs
   unsigned translate_local_memaddr(address_type localaddr, unsigned tid,
@@ -2095,9 +2343,18 @@ class shader_core_ctx : public core_t {
   void read_operands();
 
   void execute();
+  void execute_unit(simd_function_unit *fu,
+                    enum pipeline_stage_name_t issue_port,
+                    unsigned result_bus_begin, unsigned result_bus_end);
 
   void writeback();
 
+  // idle-cycle skipping: a core whose warps all wait on memory responses is
+  // put to sleep and only replays the per-cycle statistics until woken up
+  bool idle_until_response();
+  void idle_cycle();
+  void wake_up() { m_idle_state = CORE_AWAKE; }
+
   // used in display_pipeline():
   void dump_warp_state(FILE *fout) const;
   void print_stage(unsigned int stage, FILE *fout) const;
@@ -2135,6 +2392,11 @@ class shader_core_ctx : public core_t {
   // fetch
   read_only_cache *m_L1I;  // instruction cache
   int m_last_warp_fetched;
+  // superset of the warps that fetch() may reclaim or fetch for; a warp is
+  // dropped when fetch() finds it is neither and re-added by shd_warp_t when
+  // that may have changed
+  bit_mask_t m_fetch_candidates;
+  bit_mask_t m_ibuffer_filled;  // warps with a valid ibuffer entry
 
   // decode/dispatch
   std::vector<shd_warp_t> m_warp;  // per warp information array
@@ -2151,6 +2413,17 @@ class shader_core_ctx : public core_t {
   // issue
   unsigned int Issue_Prio;
 
+  // idle-cycle skipping
+  enum idle_state_t { CORE_AWAKE, CORE_PROBE_IDLE, CORE_ASLEEP };
+  bool m_idle_skip_enabled;
+  idle_state_t m_idle_state;
+  unsigned m_idle_distro_delta[3];  // shader_cycle_distro[0..2] per cycle
+
+  // instruction trace capture/replay
+  int m_inst_trace_mode;
+  std::vector<warp_trace_t> m_warp_trace;  // per hw warp
+  new_addr_type m_trace_local_addr[MAX_WARP_SIZE];  // before translation
+
   // execute
   unsigned m_num_function_units;
   std::vector<pipeline_stage_name_t> m_dispatch_port;
@@ -2161,6 +2434,10 @@ class shader_core_ctx : public core_t {
   static const unsigned MAX_ALU_LATENCY = 512;
   unsigned num_result_bus;
   std::vector<std::bitset<MAX_ALU_LATENCY> *> m_result_bus;
+  // sub-cores (empty unless sub_core_model), and the units of m_fu that are
+  // not owned by one of them
+  std::vector<shader_core_partition> m_partitions;
+  std::vector<unsigned> m_shared_fu;
 
   // used for local address mapping with single kernel launch
   unsigned kernel_max_cta_per_shader;
@@ -2203,7 +2480,8 @@ class simt_core_cluster {
   unsigned issue_block2core_SMK();
   void cache_flush();
   void cache_invalidate();
-  bool icnt_injection_buffer_full(unsigned size, bool write);
+  bool icnt_injection_buffer_full(unsigned size, bool write,
+                                  unsigned kernel_id);
   void icnt_inject_request_packet(class mem_fetch *mf);
 
   // for perfect memory interface
@@ -2274,8 +2552,8 @@ class shader_memory_interface : public mem_fetch_interface {
     m_core = core;
     m_cluster = cluster;
   }
-  virtual bool full(unsigned size, bool write) const {
-    return m_cluster->icnt_injection_buffer_full(size, write);
+  virtual bool full(unsigned size, bool write, unsigned kernel_id) const {
+    return m_cluster->icnt_injection_buffer_full(size, write, kernel_id);
   }
   virtual void push(mem_fetch *mf) {
     m_core->inc_simt_to_mem(mf->get_num_flits(true));
@@ -2293,7 +2571,7 @@ class perfect_memory_interface : public mem_fetch_interface {
     m_core = core;
     m_cluster = cluster;
   }
-  virtual bool full(unsigned size, bool write) const {
+  virtual bool full(unsigned size, bool write, unsigned kernel_id) const {
     return m_cluster->response_queue_full();
   }
   virtual void push(mem_fetch *mf) {
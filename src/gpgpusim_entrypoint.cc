@@ -79,13 +79,12 @@ void *gpgpu_sim_thread_concurrent(void *ctx_ptr) {
   do {
     if (g_debug_execution >= 3) {
       printf(
-          "GPGPU-Sim: *** simulation thread starting and spinning waiting for "
-          "work ***\n");
+          "GPGPU-Sim: *** simulation thread starting and waiting for work "
+          "***\n");
       fflush(stdout);
     }
-    while (ctx->the_gpgpusim->g_stream_manager->empty_protected() &&
-           !ctx->the_gpgpusim->g_sim_done)
-      ;
+    ctx->the_gpgpusim->g_stream_manager->wait_for_work(
+        &ctx->the_gpgpusim->g_sim_done);
     if (g_debug_execution >= 3) {
       printf("GPGPU-Sim: ** START simulation thread (detected work) **\n");
       ctx->the_gpgpusim->g_stream_manager->print(stdout);
@@ -117,6 +116,9 @@ void *gpgpu_sim_thread_concurrent(void *ctx_ptr) {
         kernel_info_t *kernel =
             ctx->the_gpgpusim->g_the_gpu->get_functional_kernel();
         assert(kernel);
+        // a memoized launch advanced the timing counters, so they must be
+        // reported and folded into the totals like a simulated kernel
+        if (ctx->the_gpgpusim->g_the_gpu->is_memoized_sim()) sim_cycles = true;
         ctx->the_gpgpusim->gpgpu_ctx->func_sim->gpgpu_cuda_ptx_sim_main_func(
             *kernel);
         ctx->the_gpgpusim->g_the_gpu->finish_functional_sim(kernel);
@@ -150,6 +152,7 @@ void *gpgpu_sim_thread_concurrent(void *ctx_ptr) {
     }
     pthread_mutex_lock(&(ctx->the_gpgpusim->g_sim_lock));
     ctx->the_gpgpusim->g_sim_active = false;
+    pthread_cond_broadcast(&(ctx->the_gpgpusim->g_sim_cond));
     pthread_mutex_unlock(&(ctx->the_gpgpusim->g_sim_lock));
   } while (!ctx->the_gpgpusim->g_sim_done);
 
@@ -172,21 +175,28 @@ void gpgpu_context::synchronize() {
   the_gpgpusim->g_stream_manager->print(stdout);
   fflush(stdout);
   //    sem_wait(&g_sim_signal_finish);
-  bool done = false;
-  do {
-    pthread_mutex_lock(&(the_gpgpusim->g_sim_lock));
-    done = (the_gpgpusim->g_stream_manager->empty() &&
+  // the sim thread broadcasts g_sim_cond each time it goes idle; work pushed
+  // while it is idle wakes it, so it will go idle (and broadcast) again
+  pthread_mutex_lock(&(the_gpgpusim->g_sim_lock));
+  while (!((the_gpgpusim->g_stream_manager->empty() &&
             !the_gpgpusim->g_sim_active) ||
-           the_gpgpusim->g_sim_done;
-    pthread_mutex_unlock(&(the_gpgpusim->g_sim_lock));
-  } while (!done);
+           the_gpgpusim->g_sim_done))
+    pthread_cond_wait(&(the_gpgpusim->g_sim_cond),
+                      &(the_gpgpusim->g_sim_lock));
+  pthread_mutex_unlock(&(the_gpgpusim->g_sim_lock));
   printf("GPGPU-Sim: detected inactive GPU simulation thread\n");
   fflush(stdout);
   //    sem_post(&g_sim_signal_start);
 }
 
 void gpgpu_context::exit_simulation() {
+  pthread_mutex_lock(&(the_gpgpusim->g_sim_lock));
   the_gpgpusim->g_sim_done = true;
+  pthread_cond_broadcast(&(the_gpgpusim->g_sim_cond));
+  pthread_mutex_unlock(&(the_gpgpusim->g_sim_lock));
+  // wake the sim thread if it is sleeping on an empty stream manager
+  if (the_gpgpusim->g_stream_manager)
+    the_gpgpusim->g_stream_manager->notify_work();
   printf("GPGPU-Sim: exit_simulation called\n");
   fflush(stdout);
   sem_wait(&(the_gpgpusim->g_sim_signal_exit));
@@ -44,6 +44,7 @@ class GPGPUsim_ctx {
     g_sim_done = true;
     break_limit = false;
     g_sim_lock = PTHREAD_MUTEX_INITIALIZER;
+    g_sim_cond = PTHREAD_COND_INITIALIZER;
 
     g_the_gpu_config = NULL;
     g_the_gpu = NULL;
@@ -70,6 +71,7 @@ class GPGPUsim_ctx {
   gpgpu_context *gpgpu_ctx;
 
   pthread_mutex_t g_sim_lock;
+  pthread_cond_t g_sim_cond;  // broadcast when g_sim_active drops
   bool g_sim_active;
   bool g_sim_done;
   bool break_limit;
@@ -57,6 +57,13 @@ BookSimConfig::BookSimConfig( )
   //simulator tries to correclty adjust latency for node/router placement 
   _int_map["use_noc_latency"] = 1;
 
+  // only step routers and channels that have flits or credits in flight
+  _int_map["activity_stepping"] = 1;
+
+  // worker threads sharing the router/channel evaluation of all subnets
+  // each cycle (0 or 1: step on the simulation thread)
+  _int_map["step_threads"] = 0;
+
 
   //used for noc latency calcualtion for network with concentration
   _int_map["x"] = 8; //number of routers in X
@@ -66,17 +66,26 @@ public:
   virtual void Evaluate() {}
   virtual void WriteOutputs();
 
+  virtual bool IsIdle() const {
+    return !_input && !_output && _wait_queue.empty();
+  }
+
+  // module woken whenever data comes out of the channel
+  void SetSinkModule(TimedModule * sink) { _sink_module = sink; }
+
 protected:
   int _delay;
   T * _input;
   T * _output;
   queue<pair<int, T *> > _wait_queue;
+  TimedModule * _sink_module;
 
 };
 
 template<typename T>
 Channel<T>::Channel(Module * parent, string const & name)
-  : TimedModule(parent, name), _delay(1), _input(0), _output(0) {
+  : TimedModule(parent, name), _delay(1), _input(0), _output(0),
+    _sink_module(0) {
 }
 
 template<typename T>
@@ -90,6 +99,9 @@ void Channel<T>::SetLatency(int cycles) {
 template<typename T>
 void Channel<T>::Send(T * data) {
   _input = data;
+  if(data) {
+    Wake();
+  }
 }
 
 template<typename T>
@@ -120,6 +132,9 @@ void Channel<T>::WriteOutputs() {
   _output = item.second;
   assert(_output);
   _wait_queue.pop();
+  if(_sink_module) {
+    _sink_module->Wake();
+  }
 }
 
 #endif
@@ -35,6 +35,8 @@
 
 stack<Credit *> Credit::_all;
 stack<Credit *> Credit::_free;
+bool Credit::_thread_safe = false;
+pthread_mutex_t Credit::_lock = PTHREAD_MUTEX_INITIALIZER;
 
 Credit::Credit()
 {
@@ -51,19 +53,23 @@ void Credit::Reset()
 
 Credit * Credit::New() {
   Credit * c;
+  if(_thread_safe) pthread_mutex_lock(&_lock);
   if(_free.empty()) {
     c = new Credit();
     _all.push(c);
   } else {
     c = _free.top();
-    c->Reset();
     _free.pop();
   }
+  if(_thread_safe) pthread_mutex_unlock(&_lock);
+  c->Reset();
   return c;
 }
 
 void Credit::Free() {
+  if(_thread_safe) pthread_mutex_lock(&_lock);
   _free.push(this);
+  if(_thread_safe) pthread_mutex_unlock(&_lock);
 }
 
 void Credit::FreeAll() {
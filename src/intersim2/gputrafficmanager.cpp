@@ -47,10 +47,58 @@ GPUTrafficManager::GPUTrafficManager( const Configuration &config, const vector<
       _input_queue[subnet][node].resize(_classes);
     }
   }
+  
+  _qos_weights.resize(_classes, 1);
+  _qos_credits.resize(_nodes);
+  _qos_first_class.resize(_nodes);
+  for ( int node = 0; node < _nodes; ++node ) {
+    _qos_credits[node].resize(_subnets, _qos_weights);
+    _qos_first_class[node].resize(_subnets, 0);
+  }
+  
+  _stepper = NULL;
+  int const step_threads = config.GetInt("step_threads");
+  if(step_threads > 1) {
+    _stepper = new ParallelStepper(step_threads);
+    Credit::SetThreadSafe(true);
+    for(int subnet = 0; subnet < _subnets; ++subnet) {
+      _net[subnet]->SetSharedStepping(true);
+    }
+  }
 }
 
 GPUTrafficManager::~GPUTrafficManager()
 {
+  delete _stepper;
+}
+
+/* Subnets are independent and, within a phase, routers and channels only
+ * touch their own state, so the phases can be run over all subnets at once
+ * without changing the result.
+ */
+void GPUTrafficManager::_StepNetworks( Network::StepPhase phase )
+{
+  if(!_stepper) {
+    for(int subnet = 0; subnet < _subnets; ++subnet) {
+      switch(phase) {
+      case Network::ReadInputsPhase: _net[subnet]->ReadInputs( ); break;
+      case Network::EvaluatePhase: _net[subnet]->Evaluate( ); break;
+      case Network::WriteOutputsPhase: _net[subnet]->WriteOutputs( ); break;
+      }
+    }
+    return;
+  }
+  if(phase == Network::ReadInputsPhase) {
+    for(int subnet = 0; subnet < _subnets; ++subnet) {
+      _net[subnet]->BeginStep( );
+    }
+  }
+  _stepper->Run(_net, phase);
+  if(phase == Network::WriteOutputsPhase) {
+    for(int subnet = 0; subnet < _subnets; ++subnet) {
+      _net[subnet]->EndStep( );
+    }
+  }
 }
 
 void GPUTrafficManager::Init()
@@ -61,6 +109,23 @@ void GPUTrafficManager::Init()
   
 }
 
+void GPUTrafficManager::SetQoSWeight( int c, int weight )
+{
+  assert((c >= 0) && (c < _classes));
+  _qos_weights[c] = weight;
+}
+
+void GPUTrafficManager::_QoSInjected( int node, int subnet, int c )
+{
+  int & credit = _qos_credits[node][subnet][c];
+  if(--credit > 0) {
+    _qos_first_class[node][subnet] = c;
+  } else {
+    credit = _qos_weights[c];
+    _qos_first_class[node][subnet] = (c + 1) % _classes;
+  }
+}
+
 void GPUTrafficManager::_RetireFlit( Flit *f, int dest )
 {
   _deadlock_timer = 0;
@@ -399,8 +464,8 @@ void GPUTrafficManager::_Step()
         c->Free();
       }
     }
-    _net[subnet]->ReadInputs( );
   }
+  _StepNetworks(Network::ReadInputsPhase);
 
 // GPGPUSim will generate/inject packets from interconnection interface
 #if 0
@@ -434,9 +499,16 @@ void GPUTrafficManager::_Step()
         }
       }
       
+      // with one flit per class per turn (all weights 1) this is the plain
+      // round robin starting after last_class
+      int first_class = last_class;
+      if((_classes > 1) && (class_limit == _classes)) {
+        first_class = _qos_first_class[n][subnet] + _classes - 1;
+      }
+      
       for(int i = 1; i <= class_limit; ++i) {
         
-        int const c = (last_class + i) % _classes;
+        int const c = (first_class + i) % _classes;
         
         list<Flit *> const & pp = _input_queue[subnet][n][c];
         
@@ -586,6 +658,9 @@ void GPUTrafficManager::_Step()
         }
         
         _last_class[n][subnet] = c;
+        if(_classes > 1) {
+          _QoSInjected(n, subnet, c);
+        }
         
         _input_queue[subnet][n][c].pop_front();
         
@@ -661,10 +736,10 @@ void GPUTrafficManager::_Step()
       }
     }
     flits[subnet].clear();
-    // _InteralStep here
-    _net[subnet]->Evaluate( );
-    _net[subnet]->WriteOutputs( );
   }
+  // _InteralStep here
+  _StepNetworks(Network::EvaluatePhase);
+  _StepNetworks(Network::WriteOutputsPhase);
   
   ++_time;
   assert(_time);
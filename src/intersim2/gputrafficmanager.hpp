@@ -38,6 +38,7 @@
 #include "booksim.hpp"
 #include "booksim_config.hpp"
 #include "flit.hpp"
+#include "parallel_stepper.hpp"
 
 class GPUTrafficManager : public TrafficManager {
   
@@ -50,6 +51,17 @@ protected:
   // record size of _partial_packets for each subnet
   vector<vector<vector<list<Flit *> > > > _input_queue;
   
+  // weighted round robin between classes at injection: a class keeps
+  // priority until it has injected _qos_weights[c] flits
+  vector<int> _qos_weights;
+  vector<vector<vector<int> > > _qos_credits;  // [node][subnet][class]
+  vector<vector<int> > _qos_first_class;       // [node][subnet]
+  void _QoSInjected( int node, int subnet, int c );
+  
+  // steps the routers and channels of all subnets on step_threads threads
+  ParallelStepper * _stepper;
+  void _StepNetworks( Network::StepPhase phase );
+  
 public:
   
   GPUTrafficManager( const Configuration &config, const vector<Network *> & net );
@@ -58,6 +70,8 @@ public:
   // correspond to TrafficManger::Run/SingleSim
   void Init();
   
+  void SetQoSWeight( int c, int weight );
+  
   // TODO: if it is not good...
   friend class InterconnectInterface;
   
@@ -59,9 +59,14 @@ InterconnectInterface* InterconnectInterface::New(const char* const config_file)
   return icnt_interface;
 }
 
-InterconnectInterface::InterconnectInterface()
+static unsigned mem_fetch_packet_type(void* data)
 {
+  return static_cast<mem_fetch*>(data)->get_type();
+}
 
+InterconnectInterface::InterconnectInterface()
+{
+  _packet_type = mem_fetch_packet_type;
 }
 
 InterconnectInterface::~InterconnectInterface()
@@ -80,7 +85,7 @@ InterconnectInterface::~InterconnectInterface()
   delete _icnt_config;
 }
 
-void InterconnectInterface::CreateInterconnect(unsigned n_shader, unsigned n_mem)
+void InterconnectInterface::CreateInterconnect(unsigned n_shader, unsigned n_mem, unsigned qos_classes)
 {
   _n_shader = n_shader;
   _n_mem = n_mem;
@@ -117,6 +122,12 @@ void InterconnectInterface::CreateInterconnect(unsigned n_shader, unsigned n_mem
 
   _flit_size = _icnt_config->GetInt( "flit_size" );
 
+  _classes = _icnt_config->GetInt( "classes" );
+  if ((int)qos_classes > _classes) {
+    cout << "GPGPU-Sim: " << qos_classes << " interconnect QoS classes share "
+         << _classes << " intersim traffic classes (set classes in the icnt config)" << endl;
+  }
+
   // Config for interface buffers
   if (_icnt_config->GetInt("ejection_buffer_size")) {
     _ejection_buffer_capacity = _icnt_config->GetInt( "ejection_buffer_size" ) ;
@@ -144,10 +155,10 @@ void InterconnectInterface::Init()
   //       _boundary_buffer, _ejection_buffer and _ejected_flit_queue should be cleared
 }
 
-void InterconnectInterface::Push(unsigned input_deviceID, unsigned output_deviceID, void *data, unsigned int size)
+void InterconnectInterface::Push(unsigned input_deviceID, unsigned output_deviceID, void *data, unsigned int size, unsigned qos_class)
 {
   // it should have free buffer
-  assert(HasBuffer(input_deviceID, size));
+  assert(HasBuffer(input_deviceID, size, qos_class));
 
   DPRINTF(INTERCONNECT, "Sent %d bytes from %d to %d", size, input_deviceID, output_deviceID);
   
@@ -172,24 +183,23 @@ void InterconnectInterface::Push(unsigned input_deviceID, unsigned output_device
     }
   }
 
-  //TODO: Remove mem_fetch to reduce dependency
   Flit::FlitType packet_type;
-  mem_fetch* mf = static_cast<mem_fetch*>(data);
+  unsigned const mf_packet_type = _packet_type(data);
 
-  switch (mf->get_type()) {
+  switch (mf_packet_type) {
     case READ_REQUEST:  packet_type = Flit::READ_REQUEST   ;break;
     case WRITE_REQUEST: packet_type = Flit::WRITE_REQUEST  ;break;
     case READ_REPLY:    packet_type = Flit::READ_REPLY     ;break;
     case WRITE_ACK:     packet_type = Flit::WRITE_REPLY    ;break;
     default:
     	{
-    		cout<<"Type "<<mf->get_type()<<" is undefined!"<<endl;
+    		cout<<"Type "<<mf_packet_type<<" is undefined!"<<endl;
     		assert (0 && "Type is undefined");
     	}
   }
 
   //TODO: _include_queuing ?
-  _traffic_manager->_GeneratePacket( input_icntID, -1, 0 /*class*/, _traffic_manager->_time, subnet, n_flits, packet_type, data, output_icntID);
+  _traffic_manager->_GeneratePacket( input_icntID, -1, _TrafficClass(qos_class), _traffic_manager->_time, subnet, n_flits, packet_type, data, output_icntID);
 
 #if DOUB
   cout <<"Traffic[" << subnet << "] (mapped) sending form "<< input_icntID << " to " << output_icntID << endl;
@@ -234,12 +244,17 @@ void InterconnectInterface::Advance()
 
 bool InterconnectInterface::Busy() const
 {
-  bool busy = !_traffic_manager->_total_in_flight_flits[0].empty();
+  bool busy = false;
+  for (int c = 0; c < _classes; ++c) {
+    busy |= !_traffic_manager->_total_in_flight_flits[c].empty();
+  }
   if (!busy) {
     for (int s = 0; s < _subnets; ++s) {
       for (unsigned n = 0; n < _n_shader+_n_mem; ++n) {
-        //FIXME: if this cannot make sure _partial_packets is empty
-        assert(_traffic_manager->_input_queue[s][n][0].empty());
+        for (int c = 0; c < _classes; ++c) {
+          //FIXME: if this cannot make sure _partial_packets is empty
+          assert(_traffic_manager->_input_queue[s][n][c].empty());
+        }
       }
     }
   }
@@ -257,20 +272,27 @@ bool InterconnectInterface::Busy() const
   return false;
 }
 
-bool InterconnectInterface::HasBuffer(unsigned deviceID, unsigned int size) const
+bool InterconnectInterface::HasBuffer(unsigned deviceID, unsigned int size, unsigned qos_class) const
 {
   bool has_buffer = false;
   unsigned int n_flits = size / _flit_size + ((size % _flit_size)? 1:0);
   int icntID = _node_map.find(deviceID)->second;
+  // each traffic class has its own injection queue, and so its own quota
+  int cl = _TrafficClass(qos_class);
 
-  has_buffer = _traffic_manager->_input_queue[0][icntID][0].size() +n_flits <= _input_buffer_capacity;
+  has_buffer = _traffic_manager->_input_queue[0][icntID][cl].size() +n_flits <= _input_buffer_capacity;
 
   if ((_subnets>1) && deviceID >= _n_shader) // deviceID is memory node
-    has_buffer = _traffic_manager->_input_queue[1][icntID][0].size() +n_flits <= _input_buffer_capacity;
+    has_buffer = _traffic_manager->_input_queue[1][icntID][cl].size() +n_flits <= _input_buffer_capacity;
 
   return has_buffer;
 }
 
+void InterconnectInterface::SetQoSWeight(unsigned qos_class, unsigned weight)
+{
+  _traffic_manager->SetQoSWeight(_TrafficClass(qos_class), weight);
+}
+
 void InterconnectInterface::DisplayStats() const
 {
   _traffic_manager->UpdateStats();
@@ -49,15 +49,18 @@ public:
   InterconnectInterface();
   virtual ~InterconnectInterface();
   static InterconnectInterface* New(const char* const config_file);
-  virtual void CreateInterconnect(unsigned n_shader,  unsigned n_mem);
+  virtual void CreateInterconnect(unsigned n_shader,  unsigned n_mem, unsigned qos_classes = 1);
   
   //node side functions
   virtual void Init();
-  virtual void Push(unsigned input_deviceID, unsigned output_deviceID, void* data, unsigned int size);
+  virtual void Push(unsigned input_deviceID, unsigned output_deviceID, void* data, unsigned int size, unsigned qos_class = 0);
   virtual void* Pop(unsigned ouput_deviceID);
   virtual void Advance();
   virtual bool Busy() const;
-  virtual bool HasBuffer(unsigned deviceID, unsigned int size) const;
+  virtual bool HasBuffer(unsigned deviceID, unsigned int size, unsigned qos_class = 0) const;
+  void SetQoSWeight(unsigned qos_class, unsigned weight);
+  // returns the mf_type of a pushed packet; defaults to reading a mem_fetch
+  void SetPacketTypeFunc(unsigned (*packet_type)(void* data)) { _packet_type = packet_type; }
   virtual void DisplayStats() const;
   virtual void DisplayOverallStats() const;
   unsigned GetFlitSize() const;
@@ -95,6 +98,8 @@ protected:
   void _CreateBuffer( );
   void _CreateNodeMap(unsigned n_shader, unsigned n_mem, unsigned n_node, int use_map);
   void _DisplayMap(int dim,int count);
+  // GPGPU-Sim QoS classes are folded onto the booksim traffic classes
+  inline int _TrafficClass(unsigned qos_class) const { return qos_class % _classes; }
   
   // size: [subnets][nodes][vcs]
   vector<vector<vector<_BoundaryBufferItem> > > _boundary_buffer;
@@ -116,6 +121,8 @@ protected:
   vector<Network *> _net;
   int _vcs;
   int _subnets;
+  int _classes;
+  unsigned (*_packet_type)(void* data);
   
   //deviceID to icntID map
   //deviceID : Starts from 0 for shaders and then continues until mem nodes
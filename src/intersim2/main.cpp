@@ -110,6 +110,9 @@ bool gTrace;
 
 ostream * gWatchOut;
 
+//set while ParallelStepper threads run a network phase
+bool gInParallelStep = false;
+
 
 
 /////////////////////////////////////////////////////////////////////////////
@@ -34,6 +34,7 @@
 
 #include <cassert>
 #include <sstream>
+#include <algorithm>
 
 #include "booksim.hpp"
 #include "network.hpp"
@@ -56,6 +57,8 @@ Network::Network( const Configuration &config, const string & name ) :
   _nodes    = -1; 
   _channels = -1;
   _classes  = config.GetInt("classes");
+  _activity_stepping = (config.GetInt("activity_stepping") > 0);
+  _active_set_ready = false;
 }
 
 Network::~Network( )
@@ -179,33 +182,105 @@ void Network::_Alloc( )
   }
 }
 
-void Network::ReadInputs( )
+/* The step list holds the modules still busy after the previous cycle plus
+ * the ones woken since (by channel writes from the traffic manager or by
+ * routers and channels during WriteOutputs), in _timed_modules order. Every
+ * module starts awake; modules are only dropped once they report IsIdle(),
+ * i.e. when stepping them would not change any state.
+ */
+void Network::_BuildStepList( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
-      ++iter) {
-    (*iter)->ReadInputs( );
+  if(!_active_set_ready) {
+    int const size = _timed_modules.size();
+    _active_set.Reset(size);
+    _step_list.resize(size);
+    for(int i = 0; i < size; ++i) {
+      _timed_modules[i]->SetActiveSet(&_active_set, i);
+      _step_list[i] = i;
+    }
+    _active_set_ready = true;
+    return;
+  }
+  vector<int> & woken = _active_set.Woken();
+  if(!woken.empty()) {
+    _step_list.insert(_step_list.end(), woken.begin(), woken.end());
+    woken.clear();
+    sort(_step_list.begin(), _step_list.end());
   }
 }
 
-void Network::Evaluate( )
+void Network::_SleepIdleModules( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
-      ++iter) {
-    (*iter)->Evaluate( );
+  size_t busy = 0;
+  for(size_t i = 0; i < _step_list.size(); ++i) {
+    int const id = _step_list[i];
+    if(_timed_modules[id]->IsIdle()) {
+      _active_set.Sleep(id);
+    } else {
+      _step_list[busy++] = id;
+    }
   }
+  _step_list.resize(busy);
 }
 
-void Network::WriteOutputs( )
+void Network::SetSharedStepping( bool shared )
+{
+  _active_set.SetShared(shared);
+}
+
+void Network::BeginStep( )
+{
+  if(_activity_stepping) {
+    _BuildStepList( );
+  }
+}
+
+void Network::StepPart( StepPhase phase, int part, int parts )
+{
+  size_t const count = _StepCount( );
+  switch(phase) {
+  case ReadInputsPhase:
+    for(size_t i = part; i < count; i += parts) {
+      _StepModule(i)->ReadInputs( );
+    }
+    break;
+  case EvaluatePhase:
+    for(size_t i = part; i < count; i += parts) {
+      _StepModule(i)->Evaluate( );
+    }
+    break;
+  case WriteOutputsPhase:
+    for(size_t i = part; i < count; i += parts) {
+      _StepModule(i)->WriteOutputs( );
+    }
+    break;
+  }
+}
+
+void Network::EndStep( )
 {
-  for(deque<TimedModule *>::const_iterator iter = _timed_modules.begin();
-      iter != _timed_modules.end();
-      ++iter) {
-    (*iter)->WriteOutputs( );
+  if(_activity_stepping) {
+    _SleepIdleModules( );
   }
 }
 
+void Network::ReadInputs( )
+{
+  BeginStep( );
+  StepPart( ReadInputsPhase, 0, 1 );
+}
+
+void Network::Evaluate( )
+{
+  StepPart( EvaluatePhase, 0, 1 );
+}
+
+void Network::WriteOutputs( )
+{
+  StepPart( WriteOutputsPhase, 0, 1 );
+  EndStep( );
+}
+
 void Network::WriteFlit( Flit *f, int source )
 {
   assert( ( source >= 0 ) && ( source < _nodes ) );
@@ -66,12 +66,29 @@ protected:
 
   deque<TimedModule *> _timed_modules;
 
+  // activity-driven stepping: only modules in _step_list are visited
+  bool _activity_stepping;
+  bool _active_set_ready;
+  ActiveSet _active_set;
+  vector<int> _step_list;
+
   virtual void _ComputeSize( const Configuration &config ) = 0;
   virtual void _BuildNet( const Configuration &config ) = 0;
 
   void _Alloc( );
+  void _BuildStepList( );
+  void _SleepIdleModules( );
+
+  inline size_t _StepCount( ) const {
+    return _activity_stepping ? _step_list.size() : _timed_modules.size();
+  }
+  inline TimedModule * _StepModule( size_t i ) const {
+    return _timed_modules[_activity_stepping ? _step_list[i] : i];
+  }
 
 public:
+  enum StepPhase { ReadInputsPhase, EvaluatePhase, WriteOutputsPhase };
+
   Network( const Configuration &config, const string & name );
   virtual ~Network( );
 
@@ -94,6 +111,15 @@ public:
   virtual void Evaluate( );
   virtual void WriteOutputs( );
 
+  // A cycle split across threads: BeginStep and EndStep run on one thread,
+  // StepPart on each of the parts for every phase in turn. Within a phase
+  // routers and channels only touch their own state, so the parts can run
+  // concurrently and give the same result as the sequential calls above.
+  void SetSharedStepping( bool shared );
+  void BeginStep( );
+  void StepPart( StepPhase phase, int part, int parts );
+  void EndStep( );
+
   void Display( ostream & os = cout ) const;
   void DumpChannelMap( ostream & os = cout, string const & prefix = "" ) const;
   void DumpNodeMap( ostream & os = cout, string const & prefix = "" ) const;
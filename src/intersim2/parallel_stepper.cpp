@@ -0,0 +1,138 @@
+// Copyright (c) 2009-2013, Tor M. Aamodt, Dongdong Li, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <sched.h>
+
+#include "parallel_stepper.hpp"
+#include "globals.hpp"
+
+// spins on the generation counter before a worker goes to sleep; phases of
+// the same cycle follow each other closely, cycles may be far apart
+static const int kSpinLimit = 4096;
+
+ParallelStepper::ParallelStepper( int threads )
+  : _threads(threads), _nets(NULL), _phase(Network::ReadInputsPhase),
+    _generation(0), _pending(0), _exit(false), _sleepers(0)
+{
+  assert(_threads > 1);
+  pthread_mutex_init(&_lock, NULL);
+  pthread_cond_init(&_start_cond, NULL);
+  _workers.resize(_threads);
+  _args.resize(_threads);
+  for(int t = 1; t < _threads; ++t) {
+    _args[t].stepper = this;
+    _args[t].part = t;
+    if(pthread_create(&_workers[t], NULL, _WorkerMain, &_args[t])) {
+      printf("GPGPU-Sim: failed to create interconnect step thread %d\n", t);
+      abort();
+    }
+  }
+}
+
+ParallelStepper::~ParallelStepper( )
+{
+  pthread_mutex_lock(&_lock);
+  _exit = true;
+  __atomic_add_fetch(&_generation, 1, __ATOMIC_RELEASE);
+  pthread_cond_broadcast(&_start_cond);
+  pthread_mutex_unlock(&_lock);
+  for(int t = 1; t < _threads; ++t) {
+    pthread_join(_workers[t], NULL);
+  }
+  pthread_cond_destroy(&_start_cond);
+  pthread_mutex_destroy(&_lock);
+}
+
+void * ParallelStepper::_WorkerMain( void * arg )
+{
+  _WorkerArg * const a = static_cast<_WorkerArg *>(arg);
+  a->stepper->_Work(a->part);
+  return NULL;
+}
+
+void ParallelStepper::_Work( int part )
+{
+  unsigned seen = 0;
+  while(true) {
+    unsigned gen;
+    int spins = 0;
+    while((gen = __atomic_load_n(&_generation, __ATOMIC_ACQUIRE)) == seen) {
+      if(++spins < kSpinLimit) {
+        continue;
+      }
+      pthread_mutex_lock(&_lock);
+      ++_sleepers;
+      while(__atomic_load_n(&_generation, __ATOMIC_ACQUIRE) == seen) {
+        pthread_cond_wait(&_start_cond, &_lock);
+      }
+      --_sleepers;
+      pthread_mutex_unlock(&_lock);
+      spins = 0;
+    }
+    seen = gen;
+    if(_exit) {
+      return;
+    }
+    _RunPart(part);
+    __atomic_sub_fetch(&_pending, 1, __ATOMIC_ACQ_REL);
+  }
+}
+
+void ParallelStepper::_RunPart( int part )
+{
+  for(size_t n = 0; n < _nets->size(); ++n) {
+    (*_nets)[n]->StepPart(_phase, part, _threads);
+  }
+}
+
+void ParallelStepper::Run( vector<Network *> const & nets,
+                           Network::StepPhase phase )
+{
+  _nets = &nets;
+  _phase = phase;
+  gInParallelStep = true;
+  _pending = _threads - 1;
+  __atomic_add_fetch(&_generation, 1, __ATOMIC_RELEASE);
+  pthread_mutex_lock(&_lock);
+  if(_sleepers) {
+    pthread_cond_broadcast(&_start_cond);
+  }
+  pthread_mutex_unlock(&_lock);
+
+  _RunPart(0);
+
+  int spins = 0;
+  while(__atomic_load_n(&_pending, __ATOMIC_ACQUIRE) > 0) {
+    if(++spins >= kSpinLimit) {
+      sched_yield();
+    }
+  }
+  gInParallelStep = false;
+}
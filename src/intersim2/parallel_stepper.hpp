@@ -0,0 +1,77 @@
+// Copyright (c) 2009-2013, Tor M. Aamodt, Dongdong Li, Ali Bakhoda
+// The University of British Columbia
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+// Redistributions in binary form must reproduce the above copyright notice, this
+// list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+// Neither the name of The University of British Columbia nor the names of its
+// contributors may be used to endorse or promote products derived from this
+// software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef _PARALLEL_STEPPER_HPP_
+#define _PARALLEL_STEPPER_HPP_
+
+#include <vector>
+#include <pthread.h>
+
+#include "network.hpp"
+
+// Runs the ReadInputs/Evaluate/WriteOutputs phases of a set of networks on
+// a fixed pool of threads. Every phase is spread over all threads, each
+// taking an interleaved share of the routers and channels of every subnet,
+// and the caller only returns once all threads have finished the phase.
+// The calling thread works on share 0.
+class ParallelStepper {
+
+  int _threads;
+  vector<pthread_t> _workers;
+
+  // phase being run; published to the workers by bumping _generation
+  vector<Network *> const * _nets;
+  Network::StepPhase _phase;
+  unsigned _generation;
+  int _pending;
+  bool _exit;
+
+  // workers spin for a while between phases and then sleep on _start_cond
+  pthread_mutex_t _lock;
+  pthread_cond_t _start_cond;
+  int _sleepers;
+
+  struct _WorkerArg {
+    ParallelStepper * stepper;
+    int part;
+  };
+  vector<_WorkerArg> _args;
+
+  static void * _WorkerMain( void * arg );
+  void _Work( int part );
+  void _RunPart( int part );
+
+public:
+  ParallelStepper( int threads );
+  ~ParallelStepper( );
+
+  void Run( vector<Network *> const & nets, Network::StepPhase phase );
+
+  int Threads( ) const { return _threads; }
+};
+
+#endif
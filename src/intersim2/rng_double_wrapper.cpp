@@ -25,10 +25,21 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cstdio>
+#include <cstdlib>
+
+#include "globals.hpp"
+
 #define main rng_double_main
 #include "rng-double.c"
 
 double ranf_next( )
 {
+  // the draw order would depend on thread scheduling
+  if(gInParallelStep) {
+    printf("GPGPU-Sim: step_threads needs deterministic routing functions "
+           "and allocators\n");
+    abort();
+  }
   return ranf_arr_next( );
 }
@@ -25,10 +25,21 @@
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 */
 
+#include <cstdio>
+#include <cstdlib>
+
+#include "globals.hpp"
+
 #define main rng_main
 #include "rng.c"
 
 long ran_next( )
 {
+  // the draw order would depend on thread scheduling
+  if(gInParallelStep) {
+    printf("GPGPU-Sim: step_threads needs deterministic routing functions "
+           "and allocators\n");
+    abort();
+  }
   return ran_arr_next( );
 }
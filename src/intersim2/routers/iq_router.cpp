@@ -223,6 +223,26 @@ void IQRouter::ReadInputs( )
   _active = _active || have_flits || have_credits;
 }
 
+bool IQRouter::IsIdle( ) const
+{
+  // with a fractional speedup, skipped cycles would shift the internal phase
+  if(_active || !_in_queue_flits.empty() ||
+     (_internal_speedup != (double)(int)_internal_speedup)) {
+    return false;
+  }
+  for(int output = 0; output < _outputs; ++output) {
+    if(!_output_buffer[output].empty() || _output_credits[output]->Receive()) {
+      return false;
+    }
+  }
+  for(int input = 0; input < _inputs; ++input) {
+    if(!_credit_buffer[input].empty() || _input_channels[input]->Receive()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void IQRouter::_InternalStep( )
 {
   if(!_active) {
@@ -28,17 +28,82 @@
 #ifndef _TIMED_MODULE_HPP_
 #define _TIMED_MODULE_HPP_
 
+#include <vector>
+#include <pthread.h>
+
 #include "module.hpp"
 
+// Tracks which timed modules of a network must be stepped. A module that
+// reports IsIdle() after a cycle is dropped until something calls Wake() on
+// it (a channel write, or a channel delivering to its sink).
+class ActiveSet {
+
+  vector<char> _awake;
+  vector<int> _woken;
+
+  // set when the network is stepped by several threads, which may wake
+  // the same module concurrently
+  bool _shared;
+  pthread_mutex_t _woken_lock;
+
+public:
+  ActiveSet() : _shared(false) {
+    pthread_mutex_init(&_woken_lock, NULL);
+  }
+  ~ActiveSet() {
+    pthread_mutex_destroy(&_woken_lock);
+  }
+  void SetShared(bool shared) { _shared = shared; }
+  void Reset(int size) {
+    _awake.assign(size, 1);
+    _woken.clear();
+  }
+  inline void Wake(int id) {
+    if(!_shared) {
+      if(!_awake[id]) {
+        _awake[id] = 1;
+        _woken.push_back(id);
+      }
+      return;
+    }
+    if(__atomic_load_n(&_awake[id], __ATOMIC_RELAXED)) {
+      return;
+    }
+    if(!__atomic_exchange_n(&_awake[id], 1, __ATOMIC_RELAXED)) {
+      pthread_mutex_lock(&_woken_lock);
+      _woken.push_back(id);
+      pthread_mutex_unlock(&_woken_lock);
+    }
+  }
+  inline void Sleep(int id) { _awake[id] = 0; }
+  vector<int> & Woken() { return _woken; }
+};
+
 class TimedModule : public Module {
 
+protected:
+  ActiveSet * _active_set;
+  int _active_id;
+
 public:
-  TimedModule(Module * parent, string const & name) : Module(parent, name) {}
+  TimedModule(Module * parent, string const & name)
+    : Module(parent, name), _active_set(0), _active_id(-1) {}
   virtual ~TimedModule() {}
   
   virtual void ReadInputs() = 0;
   virtual void Evaluate() = 0;
   virtual void WriteOutputs() = 0;
+
+  // true if the next ReadInputs/Evaluate/WriteOutputs would all be no-ops
+  virtual bool IsIdle() const { return false; }
+
+  void SetActiveSet(ActiveSet * set, int id) {
+    _active_set = set;
+    _active_id = id;
+  }
+  inline void Wake() {
+    if(_active_set) _active_set->Wake(_active_id);
+  }
 };
 
 #endif
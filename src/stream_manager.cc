@@ -38,6 +38,7 @@ CUstream_st::CUstream_st() {
   m_pending = false;
   m_uid = sm_next_stream_uid++;
   pthread_mutex_init(&m_lock, NULL);
+  pthread_cond_init(&m_done_cond, NULL);
 }
 
 bool CUstream_st::empty() {
@@ -55,13 +56,10 @@ bool CUstream_st::busy() {
 }
 
 void CUstream_st::synchronize() {
-  // called by host thread
-  bool done = false;
-  do {
-    pthread_mutex_lock(&m_lock);
-    done = m_operations.empty();
-    pthread_mutex_unlock(&m_lock);
-  } while (!done);
+  // called by host thread, woken by record_next_done()
+  pthread_mutex_lock(&m_lock);
+  while (!m_operations.empty()) pthread_cond_wait(&m_done_cond, &m_lock);
+  pthread_mutex_unlock(&m_lock);
 }
 
 void CUstream_st::push(const stream_operation &op) {
@@ -77,6 +75,7 @@ void CUstream_st::record_next_done() {
   assert(m_pending);
   m_operations.pop_front();
   m_pending = false;
+  if (m_operations.empty()) pthread_cond_broadcast(&m_done_cond);
   pthread_mutex_unlock(&m_lock);
 }
 
@@ -162,7 +161,7 @@ bool stream_operation::do_operation(gpgpu_sim *gpu) {
             m_kernel->print_parent_info();
           }
           gpu->set_cache_config(m_kernel->name());
-          gpu->launch(m_kernel);
+          if (!gpu->launch_memoized(m_kernel)) gpu->launch(m_kernel);
         } else {
           if (m_kernel->m_launch_latency) m_kernel->m_launch_latency--;
           if (g_debug_execution >= 3)
@@ -235,6 +234,7 @@ stream_manager::stream_manager(gpgpu_sim *gpu, bool cuda_launch_blocking) {
   m_service_stream_zero = false;
   m_cuda_launch_blocking = cuda_launch_blocking;
   pthread_mutex_init(&m_lock, NULL);
+  pthread_cond_init(&m_work_cond, NULL);
   m_last_stream = m_streams.begin();
 }
 
@@ -409,6 +409,19 @@ bool stream_manager::empty_protected() {
   return result;
 }
 
+void stream_manager::wait_for_work(const volatile bool *done) {
+  // called by gpu simulation thread; sleeps until push() or notify_work()
+  pthread_mutex_lock(&m_lock);
+  while (!*done && empty()) pthread_cond_wait(&m_work_cond, &m_lock);
+  pthread_mutex_unlock(&m_lock);
+}
+
+void stream_manager::notify_work() {
+  pthread_mutex_lock(&m_lock);
+  pthread_cond_broadcast(&m_work_cond);
+  pthread_mutex_unlock(&m_lock);
+}
+
 bool stream_manager::empty() {
   bool result = true;
   if (!concurrent_streams_empty()) result = false;
@@ -462,6 +475,7 @@ void stream_manager::push(stream_operation op) {
     printf("\n");
   }
   if (g_debug_execution >= 3) print_impl(stdout);
+  pthread_cond_broadcast(&m_work_cond);
   pthread_mutex_unlock(&m_lock);
   if (m_cuda_launch_blocking || stream == NULL) {
     unsigned int wait_amount = 100;
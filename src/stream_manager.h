@@ -245,6 +245,7 @@ struct CUstream_st {
 
   pthread_mutex_t m_lock;  // ensure only one host or gpu manipulates stream
                            // operation at one time
+  pthread_cond_t m_done_cond;  // signaled when the stream drains
 };
 
 class stream_manager {
@@ -258,6 +259,8 @@ class stream_manager {
   bool concurrent_streams_empty();
   bool empty_protected();
   bool empty();
+  void wait_for_work(const volatile bool *done);
+  void notify_work();
   void print(FILE *fp);
   void push(stream_operation op);
   void pushCudaStreamWaitEventToAllStreams(CUevent_st *e, unsigned int flags);
@@ -276,6 +279,7 @@ class stream_manager {
   CUstream_st m_stream_zero;
   bool m_service_stream_zero;
   pthread_mutex_t m_lock;
+  pthread_cond_t m_work_cond;  // signaled by push() for the sim thread
   std::list<struct CUstream_st *>::iterator m_last_stream;
 };
 